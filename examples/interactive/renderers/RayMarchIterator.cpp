@@ -75,6 +75,7 @@ namespace openvkl {
 
         }
 
+#ifdef RAYMARCHER_ITERATOR_TESTS
         tasking::parallel_for((size_t)nbrays, [&](size_t i) {
 
           auto pixel = pixelIndices.reshape((i*fbDims.x/nbrays) + (fbDims.y/2)*fbDims.x);
@@ -84,45 +85,70 @@ namespace openvkl {
 
           Ray ray = computeRay(screen, coef);
 
-          // vec3f color = renderPixel(ray, vec4i(pixel.x, pixel.y, fbDims.y, fbDims.x));
           vec3f color = renderPixel(ray, vec4i(i, pixel.y, nbrays, fbDims.y));
 
         });
+#else
+        // march all fan rays in a single batched call, then scatter the
+        // per-ray sample lines into the framebuffer
+        const size_t numSteps = fbDims.y;
+
+        std::vector<Ray> rays(nbrays);
+        std::vector<vkl_vec3f> origins(nbrays);
+        std::vector<vkl_vec3f> directions(nbrays);
+        std::vector<float> tStart(nbrays, 0.f);
+
+        for (int i = 0; i < nbrays; i++) {
+          auto pixel = pixelIndices.reshape((i*fbDims.x/nbrays) + (fbDims.y/2)*fbDims.x);
+
+          vec2f screen(pixel.x * rcp(float(fbDims.x)),
+                       pixel.y * rcp(float(fbDims.y)));
+
+          rays[i]   = computeRay(screen, coef);
+          rays[i].t = intersectRayBox(rays[i].org, rays[i].dir, volumeBounds);
+
+          origins[i]    = (const vkl_vec3f &)rays[i].org;
+          directions[i] = (const vkl_vec3f &)rays[i].dir;
+        }
+
+        std::vector<float> values(nbrays * numSteps);
+        std::vector<uint8_t> labels(nbrays * numSteps);
+
+        vklSampleRays(volume,
+                      nbrays,
+                      origins.data(),
+                      directions.data(),
+                      tStart.data(),
+                      1.f,
+                      numSteps,
+                      values.data(),
+                      labels.data());
+
+        tasking::parallel_for((size_t)nbrays, [&](size_t i) {
+          if (rays[i].t.empty())
+            return;
+
+          splatRay(vec4i(i, 0, nbrays, numSteps),
+                   values.data() + i * numSteps,
+                   labels.data() + i * numSteps);
+        });
+#endif
 
         frameID++;
       }
     }
 
 
-#ifndef RAYMARCHER_ITERATOR_TESTS
-    vec3f RayMarchIterator::renderPixel(Ray &ray, const vec4i &sampleID)
+    void RayMarchIterator::splatRay(const vec4i &sampleID,
+                                    const float *values,
+                                    const uint8_t *labels)
     {
       float accumScale = 1.f / (frameID + 1);
       auto fbDims = pixelIndices.dimensions();
 
-      // float r = (sampleID[0]%10 < 5 )?((sampleID[0]%(sampleID[2]/2))/(sampleID[2]/2.0f)):0;
-      float r = (sampleID[0]%10 < 5 )?255:0;
-      float g = ((sampleID[0]+5)%10 < 5 && sampleID[0] < sampleID[2]/2)?255:0;
-      float b = ((sampleID[0]+5)%10 < 5 && sampleID[0] > sampleID[2]/2)?255:0;
-
-      if(sampleID[0] == sampleID[2]/2)
-      {
-        r = 255;
-        g = 255;
-        b = 255;
-      }
-
-      ray.t = intersectRayBox(ray.org, ray.dir, volumeBounds);
-
-      if (ray.t.empty())
-        return vec3f(0.f);
-
-      // ray.t = intersectRayBox(ray.org, ray.dir, box3f(vec3f(250,250,0),vec3f(300,300,150)));
-      // int dist = min((int)sampleID[3], (int)ray.t.lower);
-
       float angle = (((float)sampleID[0] / ((float)sampleID[2]-1) -0.5f) * fov)* M_PI / 180.0f;
 
-      tasking::parallel_for(sampleID[3], [&](int j) 
+      for (int j = 0; j < sampleID[3]; j++)
       {
         int y = static_cast<int>(cos(angle)*(float)j);
         int x = static_cast<int>(sin(angle)*(float)j);
@@ -131,28 +157,39 @@ namespace openvkl {
         {
           int id = x + fbDims.x/2 + y*fbDims.x;
 
-          float sample = 0; // 0 pas necessaire
-
-          const vec3f c = ray.org + j* ray.dir;
-          uint8_t segmentation;  
-          sample        = vklComputeSampleSeg(volume, (const vkl_vec3f *)&c, &segmentation);
-          
-          // vec3f pixel_color = static_cast<float>(static_cast<int>(sample) & 0xff );
-          //std::cout << sample << " | " << static_cast<int>(sample) << " | " << (static_cast<int>(sample) & 0xff) << " | " << (static_cast<int>(sample)>> 8) << " | " <<  sample-pixel_color << std::endl;
-
           if(vRays)
-            // framebuffer[id] = vec3f(r, g, b);
-            framebuffer[id] = static_cast<float>(segmentation )/255.0f;
+            framebuffer[id] = static_cast<float>(labels[j])/255.0f;
           else
-            // framebuffer[id] = static_cast<float>(static_cast<uint16_t>(sample) & 0xff )/255.0f;
-            framebuffer[id] =  (1-accumScale) * framebuffer[id] + accumScale * (sample/255.0f);
-
-          // linear to sRGB color space conversion
-          // framebuffer[id] = vec3f(pow(framebuffer[id].x, 1.f / 2.2f),
-          //                       pow(framebuffer[id].y, 1.f / 2.2f),
-          //                       pow(framebuffer[id].z, 1.f / 2.2f));
+            framebuffer[id] =  (1-accumScale) * framebuffer[id] + accumScale * (values[j]/255.0f);
         }
-      });
+      }
+    }
+
+#ifndef RAYMARCHER_ITERATOR_TESTS
+    vec3f RayMarchIterator::renderPixel(Ray &ray, const vec4i &sampleID)
+    {
+      ray.t = intersectRayBox(ray.org, ray.dir, volumeBounds);
+
+      if (ray.t.empty())
+        return vec3f(0.f);
+
+      const size_t numSteps = sampleID[3];
+      const float tStart    = 0.f;
+
+      std::vector<float> values(numSteps);
+      std::vector<uint8_t> labels(numSteps);
+
+      vklSampleRays(volume,
+                    1,
+                    (const vkl_vec3f *)&ray.org,
+                    (const vkl_vec3f *)&ray.dir,
+                    &tStart,
+                    1.f,
+                    numSteps,
+                    values.data(),
+                    labels.data());
+
+      splatRay(sampleID, values.data(), labels.data());
 
       return vec3f(0.f);
     }
@@ -38,6 +38,12 @@ namespace openvkl {
       vec3f renderPixel(Ray &ray, const vec4i &sampleID) override;
       float random_float() const;
 
+      // write one fan ray's sample line (sampleID = (ray, -, numRays,
+      // numSteps)) into the framebuffer
+      void splatRay(const vec4i &sampleID,
+                    const float *values,
+                    const uint8_t *labels);
+
      private:
       float samplingRate{1.f};
       Ray camera;
@@ -14,6 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include "../common/Fence.h"
 #include "../common/logging.h"
 #include "../common/simd.h"
 #include "Driver.h"
@@ -97,6 +98,19 @@ extern "C" VKLData vklNewData(size_t numItems,
 }
 OPENVKL_CATCH_END(nullptr)
 
+extern "C" VKLData vklNewDataFromFile(const char *filename,
+                                      size_t offset,
+                                      size_t numItems,
+                                      VKLDataType dataType) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  THROW_IF_NULL_STRING(filename);
+  VKLData data = openvkl::api::currentDriver().newDataFromFile(
+      filename, offset, numItems, dataType);
+  return data;
+}
+OPENVKL_CATCH_END(nullptr)
+
 ///////////////////////////////////////////////////////////////////////////////
 // Driver /////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -222,6 +236,30 @@ extern "C" void vklCommit(VKLObject object) OPENVKL_CATCH_BEGIN
 }
 OPENVKL_CATCH_END()
 
+extern "C" VKLFence vklCommitAsync(VKLObject object) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  THROW_IF_NULL_OBJECT(object);
+  return openvkl::api::currentDriver().commitAsync(object);
+}
+OPENVKL_CATCH_END(nullptr)
+
+extern "C" void vklWait(VKLFence fence) OPENVKL_CATCH_BEGIN
+{
+  THROW_IF_NULL_OBJECT(fence);
+  auto *object = (openvkl::Fence *)fence;
+  object->wait();
+}
+OPENVKL_CATCH_END()
+
+extern "C" int vklIsReady(VKLFence fence) OPENVKL_CATCH_BEGIN
+{
+  THROW_IF_NULL_OBJECT(fence);
+  auto *object = (openvkl::Fence *)fence;
+  return object->isReady();
+}
+OPENVKL_CATCH_END(0)
+
 extern "C" void vklRelease(VKLObject object) OPENVKL_CATCH_BEGIN
 {
   ASSERT_DRIVER();
@@ -488,6 +526,17 @@ extern "C" void vklSetInt(VKLObject object,
 }
 OPENVKL_CATCH_END()
 
+extern "C" void vklSetULong(VKLObject object,
+                            const char *name,
+                            uint64_t x) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  THROW_IF_NULL_OBJECT(object);
+  THROW_IF_NULL_STRING(name);
+  openvkl::api::currentDriver().set1ul(object, name, x);
+}
+OPENVKL_CATCH_END()
+
 extern "C" void vklSetVec3i(
     VKLObject object, const char *name, int x, int y, int z) OPENVKL_CATCH_BEGIN
 {
@@ -575,6 +624,15 @@ extern "C" void vklValueSelectorSetValues(VKLValueSelector valueSelector,
 }
 OPENVKL_CATCH_END()
 
+extern "C" void vklValueSelectorSetStepSize(VKLValueSelector valueSelector,
+                                            float stepSize) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  openvkl::api::currentDriver().valueSelectorSetStepSize(valueSelector,
+                                                         stepSize);
+}
+OPENVKL_CATCH_END()
+
 ///////////////////////////////////////////////////////////////////////////////
 // Volume /////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -607,6 +665,52 @@ extern "C" float vklComputeSample(
 }
 OPENVKL_CATCH_END(ospcommon::math::nan)
 
+extern "C" float vklComputeSampleLOD(VKLVolume volume,
+                                     const vkl_vec3f *objectCoordinates,
+                                     float lod) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  float sample;
+  openvkl::api::currentDriver().computeSampleLOD(
+      volume,
+      reinterpret_cast<const vvec3fn<1> &>(*objectCoordinates),
+      lod,
+      reinterpret_cast<vfloatn<1> &>(sample));
+  return sample;
+}
+OPENVKL_CATCH_END(ospcommon::math::nan)
+
+extern "C" float vklComputeSampleTime(VKLVolume volume,
+                                      const vkl_vec3f *objectCoordinates,
+                                      float time) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  float sample;
+  openvkl::api::currentDriver().computeSampleTime(
+      volume,
+      reinterpret_cast<const vvec3fn<1> &>(*objectCoordinates),
+      time,
+      reinterpret_cast<vfloatn<1> &>(sample));
+  return sample;
+}
+OPENVKL_CATCH_END(ospcommon::math::nan)
+
+extern "C" float vklComputeSampleHint(VKLVolume volume,
+                                      const vkl_vec3f *objectCoordinates,
+                                      uint64_t *hint) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  THROW_IF_NULL(hint, "hint");
+  float sample;
+  openvkl::api::currentDriver().computeSampleHint(
+      volume,
+      reinterpret_cast<const vvec3fn<1> &>(*objectCoordinates),
+      hint,
+      reinterpret_cast<vfloatn<1> &>(sample));
+  return sample;
+}
+OPENVKL_CATCH_END(ospcommon::math::nan)
+
 extern "C" float vklComputeSampleSeg(
     VKLVolume volume, const vkl_vec3f *objectCoordinates, uint8_t *segmentation) OPENVKL_CATCH_BEGIN
 {
@@ -647,6 +751,81 @@ __define_vklComputeSampleN(16);
 
 #undef __define_vklComputeSampleN
 
+#define __define_vklComputeSampleSegN(WIDTH)                          \
+  extern "C" void vklComputeSampleSeg##WIDTH(                         \
+      const int *valid,                                               \
+      VKLVolume volume,                                               \
+      const vkl_vvec3f##WIDTH *objectCoordinates,                     \
+      float *samples,                                                 \
+      uint8_t *segmentation) OPENVKL_CATCH_BEGIN                      \
+  {                                                                   \
+    ASSERT_DRIVER();                                                  \
+    ASSERT_DRIVER_SUPPORTS_WIDTH(WIDTH);                              \
+                                                                      \
+    openvkl::api::currentDriver().computeSampleSeg##WIDTH(            \
+        valid,                                                        \
+        volume,                                                       \
+        reinterpret_cast<const vvec3fn<WIDTH> &>(*objectCoordinates), \
+        reinterpret_cast<vfloatn<WIDTH> &>(*samples),                 \
+        reinterpret_cast<uint8 *>(segmentation));                     \
+  }                                                                   \
+  OPENVKL_CATCH_END()
+
+__define_vklComputeSampleSegN(4);
+__define_vklComputeSampleSegN(8);
+__define_vklComputeSampleSegN(16);
+
+#undef __define_vklComputeSampleSegN
+
+extern "C" void vklComputeSampleStream(VKLVolume volume,
+                                       size_t count,
+                                       const float *x,
+                                       const float *y,
+                                       const float *z,
+                                       float *samples) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  openvkl::api::currentDriver().computeSampleStream(
+      volume, count, x, y, z, 1, samples);
+}
+OPENVKL_CATCH_END()
+
+extern "C" void vklComputeSampleStreamAOS(VKLVolume volume,
+                                          size_t count,
+                                          const vkl_vec3f *objectCoordinates,
+                                          float *samples) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  const float *oc = reinterpret_cast<const float *>(objectCoordinates);
+  openvkl::api::currentDriver().computeSampleStream(
+      volume, count, oc, oc + 1, oc + 2, 3, samples);
+}
+OPENVKL_CATCH_END()
+
+extern "C" void vklSampleRays(VKLVolume volume,
+                              size_t numRays,
+                              const vkl_vec3f *origins,
+                              const vkl_vec3f *directions,
+                              const float *tStart,
+                              float dt,
+                              size_t numSteps,
+                              float *outValues,
+                              uint8_t *outLabels) OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  openvkl::api::currentDriver().sampleRays(
+      volume,
+      numRays,
+      reinterpret_cast<const vec3f *>(origins),
+      reinterpret_cast<const vec3f *>(directions),
+      tStart,
+      dt,
+      numSteps,
+      outValues,
+      reinterpret_cast<uint8 *>(outLabels));
+}
+OPENVKL_CATCH_END()
+
 extern "C" vkl_vec3f vklComputeGradient(
     VKLVolume volume, const vkl_vec3f *objectCoordinates) OPENVKL_CATCH_BEGIN
 {
@@ -686,6 +865,50 @@ __define_vklComputeGradientN(16);
 
 #undef __define_vklComputeGradientN
 
+extern "C" float vklComputeSampleAndGradient(VKLVolume volume,
+                                             const vkl_vec3f *objectCoordinates,
+                                             vkl_vec3f *gradient)
+    OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  constexpr int valid = 1;
+  float sample;
+  openvkl::api::currentDriver().computeSampleAndGradient1(
+      &valid,
+      volume,
+      reinterpret_cast<const vvec3fn<1> &>(*objectCoordinates),
+      reinterpret_cast<vfloatn<1> &>(sample),
+      reinterpret_cast<vvec3fn<1> &>(*gradient));
+  return sample;
+}
+OPENVKL_CATCH_END(ospcommon::math::nan)
+
+#define __define_vklComputeSampleAndGradientN(WIDTH)                  \
+  extern "C" void vklComputeSampleAndGradient##WIDTH(                 \
+      const int *valid,                                               \
+      VKLVolume volume,                                               \
+      const vkl_vvec3f##WIDTH *objectCoordinates,                     \
+      float *samples,                                                 \
+      vkl_vvec3f##WIDTH *gradients) OPENVKL_CATCH_BEGIN               \
+  {                                                                   \
+    ASSERT_DRIVER();                                                  \
+    ASSERT_DRIVER_SUPPORTS_WIDTH(WIDTH);                              \
+                                                                      \
+    openvkl::api::currentDriver().computeSampleAndGradient##WIDTH(    \
+        valid,                                                        \
+        volume,                                                       \
+        reinterpret_cast<const vvec3fn<WIDTH> &>(*objectCoordinates), \
+        reinterpret_cast<vfloatn<WIDTH> &>(*samples),                 \
+        reinterpret_cast<vvec3fn<WIDTH> &>(*gradients));              \
+  }                                                                   \
+  OPENVKL_CATCH_END()
+
+__define_vklComputeSampleAndGradientN(4);
+__define_vklComputeSampleAndGradientN(8);
+__define_vklComputeSampleAndGradientN(16);
+
+#undef __define_vklComputeSampleAndGradientN
+
 extern "C" vkl_box3f vklGetBoundingBox(VKLVolume volume) OPENVKL_CATCH_BEGIN
 {
   ASSERT_DRIVER();
@@ -701,3 +924,31 @@ extern "C" vkl_range1f vklGetValueRange(VKLVolume volume) OPENVKL_CATCH_BEGIN
   return reinterpret_cast<const vkl_range1f &>(result);
 }
 OPENVKL_CATCH_END(vkl_range1f{ospcommon::math::nan})
+
+extern "C" VKLCacheStatistics vklGetCacheStatistics(VKLVolume volume)
+    OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  return openvkl::api::currentDriver().getCacheStatistics(volume);
+}
+OPENVKL_CATCH_END(VKLCacheStatistics{})
+
+extern "C" void vklVolumeUpdateRegion(VKLVolume volume,
+                                      const vkl_box3i *region)
+    OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  openvkl::api::currentDriver().updateVolumeRegion(
+      volume, reinterpret_cast<const box3i &>(*region));
+}
+OPENVKL_CATCH_END()
+
+extern "C" void vklVolumeSerializeAccelerator(VKLVolume volume,
+                                              const char *filename)
+    OPENVKL_CATCH_BEGIN
+{
+  ASSERT_DRIVER();
+  THROW_IF_NULL_STRING(filename);
+  openvkl::api::currentDriver().serializeVolumeAccelerator(volume, filename);
+}
+OPENVKL_CATCH_END()
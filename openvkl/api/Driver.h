@@ -59,6 +59,9 @@ namespace openvkl {
       virtual void commit(VKLObject object)  = 0;
       virtual void release(VKLObject object) = 0;
 
+      // commit object without blocking; see vklCommitAsync()
+      virtual VKLFence commitAsync(VKLObject object) = 0;
+
       /////////////////////////////////////////////////////////////////////////
       // Driver parameters (updated on commit()) //////////////////////////////
       /////////////////////////////////////////////////////////////////////////
@@ -78,6 +81,11 @@ namespace openvkl {
                               const void *source,
                               VKLDataCreationFlags dataCreationFlags) = 0;
 
+      virtual VKLData newDataFromFile(const char *filename,
+                                      size_t offset,
+                                      size_t numItems,
+                                      VKLDataType dataType) = 0;
+
       /////////////////////////////////////////////////////////////////////////
       // Interval iterator ////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
@@ -176,6 +184,9 @@ namespace openvkl {
                            const bool b)                                    = 0;
       virtual void set1f(VKLObject object, const char *name, const float x) = 0;
       virtual void set1i(VKLObject object, const char *name, const int x)   = 0;
+      virtual void set1ul(VKLObject object,
+                          const char *name,
+                          const uint64_t x)                                 = 0;
       virtual void setVec3f(VKLObject object,
                             const char *name,
                             const vec3f &v)                                 = 0;
@@ -204,6 +215,9 @@ namespace openvkl {
           VKLValueSelector valueSelector,
           const utility::ArrayView<const float> &values) = 0;
 
+      virtual void valueSelectorSetStepSize(VKLValueSelector valueSelector,
+                                            float stepSize) = 0;
+
       /////////////////////////////////////////////////////////////////////////
       // Volume ///////////////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
@@ -237,6 +251,45 @@ namespace openvkl {
 
 #undef __define_computeSampleSegN
 
+      virtual void computeSampleLOD(VKLVolume volume,
+                                    const vvec3fn<1> &objectCoordinates,
+                                    float lod,
+                                    vfloatn<1> &sample) = 0;
+
+      virtual void computeSampleTime(VKLVolume volume,
+                                     const vvec3fn<1> &objectCoordinates,
+                                     float time,
+                                     vfloatn<1> &sample) = 0;
+
+      virtual void computeSampleHint(VKLVolume volume,
+                                     const vvec3fn<1> &objectCoordinates,
+                                     uint64_t *hint,
+                                     vfloatn<1> &sample) = 0;
+
+      // sample count coordinates; coordinate i is read at offset i * stride
+      // from each of x, y and z, which covers both SoA (stride 1) and AoS
+      // (stride 3) inputs
+      virtual void computeSampleStream(VKLVolume volume,
+                                       size_t count,
+                                       const float *x,
+                                       const float *y,
+                                       const float *z,
+                                       int stride,
+                                       float *samples) = 0;
+
+      // march numRays rays at a fixed step dt; sample j of ray i is taken at
+      // origins[i] + (tStart[i] + j * dt) * directions[i] and written to
+      // values[i * numSteps + j] (and labels, if not null)
+      virtual void sampleRays(VKLVolume volume,
+                              size_t numRays,
+                              const vec3f *origins,
+                              const vec3f *directions,
+                              const float *tStart,
+                              float dt,
+                              size_t numSteps,
+                              float *values,
+                              uint8 *labels) = 0;
+
 #define __define_computeGradientN(WIDTH)                                       \
   virtual void computeGradient##WIDTH(const int *valid,                        \
                                       VKLVolume volume,                        \
@@ -250,10 +303,33 @@ namespace openvkl {
 
 #undef __define_computeGradientN
 
+#define __define_computeSampleAndGradientN(WIDTH)                         \
+  virtual void computeSampleAndGradient##WIDTH(                           \
+      const int *valid,                                                   \
+      VKLVolume volume,                                                   \
+      const vvec3fn<WIDTH> &objectCoordinates,                            \
+      vfloatn<WIDTH> &samples,                                            \
+      vvec3fn<WIDTH> &gradients) = 0;
+
+      __define_computeSampleAndGradientN(1);
+      __define_computeSampleAndGradientN(4);
+      __define_computeSampleAndGradientN(8);
+      __define_computeSampleAndGradientN(16);
+
+#undef __define_computeSampleAndGradientN
+
       virtual box3f getBoundingBox(VKLVolume volume) = 0;
 
       virtual range1f getValueRange(VKLVolume volume) = 0;
 
+      virtual VKLCacheStatistics getCacheStatistics(VKLVolume volume) = 0;
+
+      virtual void updateVolumeRegion(VKLVolume volume,
+                                      const box3i &region) = 0;
+
+      virtual void serializeVolumeAccelerator(VKLVolume volume,
+                                              const std::string &filename) = 0;
+
      private:
       bool committed = false;
     };
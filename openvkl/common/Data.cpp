@@ -17,6 +17,16 @@
 #include "Data.h"
 #include "ospcommon/memory/malloc.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace openvkl {
 
   Data::Data(size_t numItems,
@@ -53,6 +63,29 @@ namespace openvkl {
     }
   }
 
+  Data::Data(const std::string &filename,
+             size_t offset,
+             size_t numItems,
+             VKLDataType dataType)
+      : numItems(numItems),
+        numBytes(numItems * sizeOf(dataType)),
+        dataType(dataType),
+        dataCreationFlags(VKL_DATA_SHARED_BUFFER)
+  {
+    if (isManagedObject(dataType))
+      throw std::runtime_error("file-backed data cannot hold object handles");
+
+    if (numBytes == 0)
+      throw std::runtime_error("file-backed data must not be empty");
+
+    if (numBytes / sizeOf(dataType) != numItems)
+      throw std::runtime_error("file-backed data is too large");
+
+    mapFile(filename, offset);
+
+    managedObjectType = VKL_DATA;
+  }
+
   Data::~Data()
   {
     if (isManagedObject(dataType)) {
@@ -63,7 +96,9 @@ namespace openvkl {
       }
     }
 
-    if (!(dataCreationFlags & VKL_DATA_SHARED_BUFFER))
+    if (mappedAddress)
+      unmapFile();
+    else if (!(dataCreationFlags & VKL_DATA_SHARED_BUFFER))
       ospcommon::memory::alignedFree(data);
   }
 
@@ -77,4 +112,153 @@ namespace openvkl {
     return numItems;
   }
 
+#ifdef _WIN32
+  void Data::mapFile(const std::string &filename, size_t offset)
+  {
+    HANDLE file = CreateFileA(filename.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("could not open file " + filename);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        offset > size_t(fileSize.QuadPart) ||
+        numBytes > size_t(fileSize.QuadPart) - offset) {
+      CloseHandle(file);
+      throw std::runtime_error("file " + filename +
+                               " is too small for the requested data");
+    }
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+      throw std::runtime_error("could not map file " + filename);
+
+    // views must start at a multiple of the allocation granularity
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+
+    const size_t mapOffset =
+        offset - offset % systemInfo.dwAllocationGranularity;
+    const size_t viewOffset = offset - mapOffset;
+
+    // like copied data, mapped data is followed by 16 readable bytes for
+    // vectorized over-reads: the view extends into the rest of the file, and
+    // its last page reads as zero past the end of the file
+    const size_t paddedBytes = viewOffset + numBytes + 16;
+    const size_t fileBytes   = size_t(fileSize.QuadPart) - mapOffset;
+
+    mappedBytes   = paddedBytes < fileBytes ? paddedBytes : fileBytes;
+    mappedAddress = MapViewOfFile(mapping,
+                                  FILE_MAP_READ,
+                                  DWORD(uint64_t(mapOffset) >> 32),
+                                  DWORD(mapOffset & 0xffffffff),
+                                  mappedBytes);
+    CloseHandle(mapping);
+
+    if (mappedAddress == nullptr)
+      throw std::runtime_error("could not map file " + filename);
+
+    data = static_cast<char *>(mappedAddress) + viewOffset;
+
+    // if the padding reaches the page after the view, copy the items instead
+    const size_t pageSize = systemInfo.dwPageSize;
+
+    if ((mappedBytes + pageSize - 1) / pageSize * pageSize < paddedBytes) {
+      void *copy = ospcommon::memory::alignedMalloc(numBytes + 16);
+
+      if (copy == nullptr) {
+        unmapFile();
+        throw std::runtime_error("data is NULL");
+      }
+
+      memcpy(copy, data, numBytes);
+      unmapFile();
+
+      data              = copy;
+      dataCreationFlags = VKL_DATA_DEFAULT;
+    }
+  }
+
+  void Data::unmapFile()
+  {
+    UnmapViewOfFile(mappedAddress);
+    mappedAddress = nullptr;
+  }
+#else
+  void Data::mapFile(const std::string &filename, size_t offset)
+  {
+    const int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd == -1)
+      throw std::runtime_error("could not open file " + filename);
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || offset > size_t(fileStat.st_size) ||
+        numBytes > size_t(fileStat.st_size) - offset) {
+      close(fd);
+      throw std::runtime_error("file " + filename +
+                               " is too small for the requested data");
+    }
+
+    // mappings must start at a page boundary
+    const size_t pageSize  = sysconf(_SC_PAGESIZE);
+    const size_t mapOffset = offset - offset % pageSize;
+    const size_t fileBytes = numBytes + (offset - mapOffset);
+
+    // like copied data, mapped data is followed by 16 readable bytes for
+    // vectorized over-reads. pages past the end of the file would fault, so
+    // the file is mapped over a reserved range of zero pages that much larger.
+    mappedBytes   = fileBytes + 16;
+    mappedAddress = mmap(nullptr,
+                         mappedBytes,
+                         PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1,
+                         0);
+
+    void *fileAddress = MAP_FAILED;
+
+    if (mappedAddress != MAP_FAILED) {
+      fileAddress = mmap(mappedAddress,
+                         fileBytes,
+                         PROT_READ,
+                         MAP_SHARED | MAP_FIXED,
+                         fd,
+                         mapOffset);
+    }
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if (fileAddress == MAP_FAILED) {
+      if (mappedAddress != MAP_FAILED)
+        munmap(mappedAddress, mappedBytes);
+
+      mappedAddress = nullptr;
+      throw std::runtime_error("could not map file " + filename);
+    }
+
+    // start asynchronous readahead; commits (e.g. accelerator builds) will
+    // touch all pages anyway
+    madvise(mappedAddress, fileBytes, MADV_WILLNEED);
+
+    data = static_cast<char *>(mappedAddress) + (offset - mapOffset);
+  }
+
+  void Data::unmapFile()
+  {
+    munmap(mappedAddress, mappedBytes);
+    mappedAddress = nullptr;
+  }
+#endif
+
 }  // namespace openvkl
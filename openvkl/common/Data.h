@@ -28,6 +28,12 @@ namespace openvkl {
          const void *source,
          VKLDataCreationFlags dataCreationFlags);
 
+    // read-only memory mapping of numItems items at byte offset in filename
+    Data(const std::string &filename,
+         size_t offset,
+         size_t numItems,
+         VKLDataType dataType);
+
     virtual ~Data() override;
 
     virtual std::string toString() const override;
@@ -57,6 +63,15 @@ namespace openvkl {
     VKLDataType dataType;
     void *data;
     VKLDataCreationFlags dataCreationFlags;
+
+   private:
+    void mapFile(const std::string &filename, size_t offset);
+    void unmapFile();
+
+    // base address and length of the file mapping, if any; data may point
+    // past mappedAddress as mappings must start at page boundaries
+    void *mappedAddress{nullptr};
+    size_t mappedBytes{0};
   };
 
   template <typename T>
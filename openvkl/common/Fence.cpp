@@ -0,0 +1,39 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "Fence.h"
+
+namespace openvkl {
+
+  Fence::Fence(const std::shared_future<void> &future) : future(future) {}
+
+  std::string Fence::toString() const
+  {
+    return "openvkl::Fence";
+  }
+
+  void Fence::wait() const
+  {
+    future.get();
+  }
+
+  bool Fence::isReady() const
+  {
+    return future.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  }
+
+}  // namespace openvkl
@@ -16,33 +16,27 @@
 
 #pragma once
 
-struct FindStack
-{
-  varying bool active;
-  uniform int32 nodeID;
-};
-
-inline uniform FindStack *uniform pushStack(uniform FindStack *uniform stackPtr,
-                                            uniform int nodeID)
-{
-  unmasked {
-    stackPtr->active = false;
-  }
-
-  stackPtr->active = true;
-  stackPtr->nodeID = nodeID;
-  return stackPtr+1;
-}
-
-inline uniform FindStack *uniform pushStack(uniform FindStack *uniform stackPtr,
-                                            uniform int nodeID,
-                                            varying bool valid)
-{
-  unmasked {
-    stackPtr->active = false;
-  }
-
-  stackPtr->active = valid;
-  stackPtr->nodeID = nodeID;
-  return stackPtr+1;
-}
\ No newline at end of file
+#include <future>
+#include "ManagedObject.h"
+
+namespace openvkl {
+
+  // completion handle of an asynchronous commit (see vklCommitAsync())
+  struct OPENVKL_CORE_INTERFACE Fence : public ManagedObject
+  {
+    Fence(const std::shared_future<void> &future);
+
+    virtual ~Fence() override = default;
+
+    virtual std::string toString() const override;
+
+    // block until the commit completed; rethrows any error raised by it
+    void wait() const;
+
+    bool isReady() const;
+
+   private:
+    std::shared_future<void> future;
+  };
+
+}  // namespace openvkl
@@ -16,9 +16,11 @@
 
 #include "ISPCDriver.h"
 #include "../common/Data.h"
+#include "../common/Fence.h"
 #include "../value_selector/ValueSelector.h"
 #include "../volume/Volume.h"
 #include "ispc_util_ispc.h"
+#include "ospcommon/tasking/parallel_for.h"
 
 namespace openvkl {
   namespace ispc_driver {
@@ -46,6 +48,27 @@ namespace openvkl {
     {
       ManagedObject *managedObject = (ManagedObject *)object;
       managedObject->commit();
+
+      if (managedObject->managedObjectType == VKL_VOLUME)
+        referenceFromHandle<Volume<W>>(object).resetCommittedInstance();
+    }
+
+    template <int W>
+    VKLFence ISPCDriver<W>::commitAsync(VKLObject object)
+    {
+      ManagedObject *managedObject = (ManagedObject *)object;
+
+      if (managedObject->managedObjectType == VKL_VOLUME) {
+        auto &volumeObject = referenceFromHandle<Volume<W>>(object);
+        return (VKLFence) new Fence(volumeObject.commitAsync());
+      }
+
+      // other objects are cheap to commit, and are committed in place
+      std::promise<void> promise;
+      managedObject->commit();
+      promise.set_value();
+
+      return (VKLFence) new Fence(promise.get_future().share());
     }
 
     template <int W>
@@ -69,6 +92,16 @@ namespace openvkl {
       return (VKLData)data;
     }
 
+    template <int W>
+    VKLData ISPCDriver<W>::newDataFromFile(const char *filename,
+                                           size_t offset,
+                                           size_t numItems,
+                                           VKLDataType dataType)
+    {
+      Data *data = new Data(filename, offset, numItems, dataType);
+      return (VKLData)data;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // Interval iterator //////////////////////////////////////////////////////
     ///////////////////////////////////////////////////////////////////////////
@@ -193,6 +226,15 @@ namespace openvkl {
       managedObject->setParam(name, x);
     }
 
+    template <int W>
+    void ISPCDriver<W>::set1ul(VKLObject object,
+                               const char *name,
+                               const uint64_t x)
+    {
+      ManagedObject *managedObject = (ManagedObject *)object;
+      managedObject->setParam(name, x);
+    }
+
     template <int W>
     void ISPCDriver<W>::setVec3f(VKLObject object,
                                  const char *name,
@@ -268,6 +310,15 @@ namespace openvkl {
       valueSelectorObject.setValues(values);
     }
 
+    template <int W>
+    void ISPCDriver<W>::valueSelectorSetStepSize(
+        VKLValueSelector valueSelector, float stepSize)
+    {
+      auto &valueSelectorObject =
+          referenceFromHandle<ValueSelector<W>>(valueSelector);
+      valueSelectorObject.setStepSize(stepSize);
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // Volume /////////////////////////////////////////////////////////////////
     ///////////////////////////////////////////////////////////////////////////
@@ -280,6 +331,14 @@ namespace openvkl {
       return (VKLVolume)Volume<W>::createInstance(ss.str());
     }
 
+    template <int W>
+    CommittedVolume<W> ISPCDriver<W>::committedVolume(VKLVolume volume,
+                                                      bool forIterator)
+    {
+      return referenceFromHandle<Volume<W>>(volume).committedInstance(
+          forIterator);
+    }
+
 #define __define_computeSampleN(WIDTH)                                       \
   template <int W>                                                           \
   void ISPCDriver<W>::computeSample##WIDTH(                                  \
@@ -304,8 +363,8 @@ namespace openvkl {
                                        const vvec3fn<1> &objectCoordinates,
                                        vfloatn<1> &sample)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
-      volumeObject.computeSample(objectCoordinates, sample);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->computeSample(objectCoordinates, sample);
     }
 
 
@@ -336,8 +395,110 @@ namespace openvkl {
                                        vfloatn<1> &sample,
                                        uint8 *segmentation)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
-      volumeObject.computeSampleSeg(objectCoordinates, sample, segmentation);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->computeSampleSeg(objectCoordinates, sample, segmentation);
+    }
+
+    template <int W>
+    void ISPCDriver<W>::computeSampleLOD(VKLVolume volume,
+                                         const vvec3fn<1> &objectCoordinates,
+                                         float lod,
+                                         vfloatn<1> &sample)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->computeSampleLOD(objectCoordinates, lod, sample);
+    }
+
+    template <int W>
+    void ISPCDriver<W>::computeSampleTime(VKLVolume volume,
+                                          const vvec3fn<1> &objectCoordinates,
+                                          float time,
+                                          vfloatn<1> &sample)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->computeSampleTime(objectCoordinates, time, sample);
+    }
+
+    template <int W>
+    void ISPCDriver<W>::computeSampleHint(VKLVolume volume,
+                                          const vvec3fn<1> &objectCoordinates,
+                                          uint64_t *hint,
+                                          vfloatn<1> &sample)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->computeSampleHint(objectCoordinates, *hint, sample);
+    }
+
+    template <int W>
+    void ISPCDriver<W>::computeSampleStream(VKLVolume volume,
+                                            size_t count,
+                                            const float *x,
+                                            const float *y,
+                                            const float *z,
+                                            int stride,
+                                            float *samples)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+
+      // streams are sampled in fixed-size chunks, each handled by a single
+      // kernel invocation; short streams stay on the calling thread
+      constexpr size_t chunkSize = 16 * 1024;
+
+      const size_t numChunks = count / chunkSize + (count % chunkSize != 0);
+
+      if (numChunks <= 1) {
+        volumeObject->computeSampleStream(count, x, y, z, stride, samples);
+        return;
+      }
+
+      tasking::parallel_for(numChunks, [&](size_t chunkIndex) {
+        const size_t begin      = chunkIndex * chunkSize;
+        const size_t ofs        = begin * stride;
+        const size_t chunkCount = std::min(chunkSize, count - begin);
+
+        volumeObject->computeSampleStream(
+            chunkCount, x + ofs, y + ofs, z + ofs, stride, samples + begin);
+      });
+    }
+
+    template <int W>
+    void ISPCDriver<W>::sampleRays(VKLVolume volume,
+                                   size_t numRays,
+                                   const vec3f *origins,
+                                   const vec3f *directions,
+                                   const float *tStart,
+                                   float dt,
+                                   size_t numSteps,
+                                   float *values,
+                                   uint8 *labels)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+
+      if (numRays == 0 || numSteps == 0)
+        return;
+
+      // rays are grouped so that each task covers roughly the same number of
+      // samples as a stream chunk, with at least one ray per task
+      constexpr size_t samplesPerTask = 16 * 1024;
+
+      const size_t raysPerTask = std::max(size_t(1), samplesPerTask / numSteps);
+      const size_t numTasks =
+          numRays / raysPerTask + (numRays % raysPerTask != 0);
+
+      tasking::parallel_for(numTasks, [&](size_t taskIndex) {
+        const size_t begin     = taskIndex * raysPerTask;
+        const size_t taskRays  = std::min(raysPerTask, numRays - begin);
+        const size_t outOffset = begin * numSteps;
+
+        volumeObject->sampleRays(taskRays,
+                                origins + begin,
+                                directions + begin,
+                                tStart + begin,
+                                dt,
+                                numSteps,
+                                values + outOffset,
+                                labels ? labels + outOffset : nullptr);
+      });
     }
 
 #define __define_computeGradientN(WIDTH)              \
@@ -359,18 +520,61 @@ namespace openvkl {
 
 #undef __define_computeGradientN
 
+#define __define_computeSampleAndGradientN(WIDTH)                \
+  template <int W>                                               \
+  void ISPCDriver<W>::computeSampleAndGradient##WIDTH(           \
+      const int *valid,                                          \
+      VKLVolume volume,                                          \
+      const vvec3fn<WIDTH> &objectCoordinates,                   \
+      vfloatn<WIDTH> &samples,                                   \
+      vvec3fn<WIDTH> &gradients)                                 \
+  {                                                              \
+    computeSampleAndGradientAnyWidth<WIDTH>(                     \
+        valid, volume, objectCoordinates, samples, gradients);   \
+  }
+
+    __define_computeSampleAndGradientN(1);
+    __define_computeSampleAndGradientN(4);
+    __define_computeSampleAndGradientN(8);
+    __define_computeSampleAndGradientN(16);
+
+#undef __define_computeSampleAndGradientN
+
     template <int W>
     box3f ISPCDriver<W>::getBoundingBox(VKLVolume volume)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
-      return volumeObject.getBoundingBox();
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      return volumeObject->getBoundingBox();
     }
 
     template <int W>
     range1f ISPCDriver<W>::getValueRange(VKLVolume volume)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
-      return volumeObject.getValueRange();
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      return volumeObject->getValueRange();
+    }
+
+    template <int W>
+    VKLCacheStatistics ISPCDriver<W>::getCacheStatistics(VKLVolume volume)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      return volumeObject->getCacheStatistics();
+    }
+
+    template <int W>
+    void ISPCDriver<W>::updateVolumeRegion(VKLVolume volume,
+                                           const box3i &region)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->updateRegion(region);
+    }
+
+    template <int W>
+    void ISPCDriver<W>::serializeVolumeAccelerator(VKLVolume volume,
+                                                   const std::string &filename)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+      volumeObject->serializeAccelerator(filename);
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -389,7 +593,7 @@ namespace openvkl {
         const vrange1fn<OW> &tRange,
         VKLValueSelector valueSelector)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume, true);
 
       vintn<W> validW;
       for (int i = 0; i < W; i++)
@@ -401,7 +605,7 @@ namespace openvkl {
 
       vVKLIntervalIteratorN<W> iteratorW;
 
-      volumeObject.initIntervalIteratorV(
+      volumeObject->initIntervalIteratorV(
           validW,
           iteratorW,
           originW,
@@ -424,7 +628,7 @@ namespace openvkl {
         const vrange1fn<OW> &tRange,
         VKLValueSelector valueSelector)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume, true);
 
       vintn<W> validW;
       for (int i = 0; i < W; i++)
@@ -434,7 +638,7 @@ namespace openvkl {
       vvec3fn<W> directionW = static_cast<vvec3fn<W>>(direction);
       vrange1fn<W> tRangeW  = static_cast<vrange1fn<W>>(tRange);
 
-      volumeObject.initIntervalIteratorV(
+      volumeObject->initIntervalIteratorV(
           validW,
           iterator,
           originW,
@@ -553,7 +757,7 @@ namespace openvkl {
                                            const vrange1fn<OW> &tRange,
                                            VKLValueSelector valueSelector)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume, true);
 
       vintn<W> validW;
       for (int i = 0; i < W; i++)
@@ -565,7 +769,7 @@ namespace openvkl {
 
       vVKLHitIteratorN<W> iteratorW;
 
-      volumeObject.initHitIteratorV(
+      volumeObject->initHitIteratorV(
           validW,
           iteratorW,
           originW,
@@ -587,7 +791,7 @@ namespace openvkl {
                                            const vrange1fn<OW> &tRange,
                                            VKLValueSelector valueSelector)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume, true);
 
       vintn<W> validW;
       for (int i = 0; i < W; i++)
@@ -597,7 +801,7 @@ namespace openvkl {
       vvec3fn<W> directionW = static_cast<vvec3fn<W>>(direction);
       vrange1fn<W> tRangeW  = static_cast<vrange1fn<W>>(tRange);
 
-      volumeObject.initHitIteratorV(
+      volumeObject->initHitIteratorV(
           validW,
           iterator,
           originW,
@@ -706,7 +910,7 @@ namespace openvkl {
                                          const vvec3fn<OW> &objectCoordinates,
                                          vfloatn<OW> &samples)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
 
@@ -718,7 +922,7 @@ namespace openvkl {
 
       vfloatn<W> samplesW;
 
-      volumeObject.computeSampleV(validW, ocW, samplesW);
+      volumeObject->computeSampleV(validW, ocW, samplesW);
 
       for (int i = 0; i < OW; i++)
         samples[i] = samplesW[i];
@@ -732,7 +936,7 @@ namespace openvkl {
                                          const vvec3fn<OW> &objectCoordinates,
                                          vfloatn<OW> &samples)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       const int numPacks = OW / W + (OW % W != 0);
 
@@ -747,7 +951,7 @@ namespace openvkl {
 
         vfloatn<W> samplesW;
 
-        volumeObject.computeSampleV(validW, ocW, samplesW);
+        volumeObject->computeSampleV(validW, ocW, samplesW);
 
         for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++)
           samples[i] = samplesW[i - packIndex * W];
@@ -763,7 +967,7 @@ namespace openvkl {
                                          vfloatn<OW> &samples,
                                           uint8 *segmentation)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
 
@@ -774,11 +978,14 @@ namespace openvkl {
       ocW.fill_inactive_lanes(validW);
 
       vfloatn<W> samplesW;
+      uint8 segmentationW[W];
 
-      volumeObject.computeSampleV(validW, ocW, samplesW);
+      volumeObject->computeSampleSegV(validW, ocW, samplesW, segmentationW);
 
-      for (int i = 0; i < OW; i++)
-        samples[i] = samplesW[i];
+      for (int i = 0; i < OW; i++) {
+        samples[i]      = samplesW[i];
+        segmentation[i] = segmentationW[i];
+      }
     }
 
     template <int W>
@@ -790,7 +997,7 @@ namespace openvkl {
                                          vfloatn<OW> &samples,
                                           uint8 *segmentation)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       const int numPacks = OW / W + (OW % W != 0);
 
@@ -798,17 +1005,22 @@ namespace openvkl {
         vvec3fn<W> ocW = objectCoordinates.template extract_pack<W>(packIndex);
 
         vintn<W> validW;
-        for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++)
-          validW[i - packIndex * W] = i < OW ? valid[i] : 0;
+        for (int i = 0; i < W; i++) {
+          const int lane = packIndex * W + i;
+          validW[i]      = lane < OW ? valid[lane] : 0;
+        }
 
         ocW.fill_inactive_lanes(validW);
 
         vfloatn<W> samplesW;
+        uint8 segmentationW[W];
 
-        volumeObject.computeSampleV(validW, ocW, samplesW);
+        volumeObject->computeSampleSegV(validW, ocW, samplesW, segmentationW);
 
-        for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++)
-          samples[i] = samplesW[i - packIndex * W];
+        for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++) {
+          samples[i]      = samplesW[i - packIndex * W];
+          segmentation[i] = segmentationW[i - packIndex * W];
+        }
       }
     }
 
@@ -821,7 +1033,7 @@ namespace openvkl {
                                            const vvec3fn<OW> &objectCoordinates,
                                            vvec3fn<OW> &gradients)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
 
@@ -833,7 +1045,7 @@ namespace openvkl {
 
       vvec3fn<W> gradientsW;
 
-      volumeObject.computeGradientV(validW, ocW, gradientsW);
+      volumeObject->computeGradientV(validW, ocW, gradientsW);
 
       for (int i = 0; i < OW; i++) {
         gradients.x[i] = gradientsW.x[i];
@@ -850,7 +1062,7 @@ namespace openvkl {
                                            const vvec3fn<OW> &objectCoordinates,
                                            vvec3fn<OW> &gradients)
     {
-      auto &volumeObject = referenceFromHandle<Volume<W>>(volume);
+      CommittedVolume<W> volumeObject = committedVolume(volume);
 
       const int numPacks = OW / W + (OW % W != 0);
 
@@ -865,9 +1077,83 @@ namespace openvkl {
 
         vvec3fn<W> gradientsW;
 
-        volumeObject.computeGradientV(validW, ocW, gradientsW);
+        volumeObject->computeGradientV(validW, ocW, gradientsW);
+
+        for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++) {
+          gradients.x[i] = gradientsW.x[i - packIndex * W];
+          gradients.y[i] = gradientsW.y[i - packIndex * W];
+          gradients.z[i] = gradientsW.z[i - packIndex * W];
+        }
+      }
+    }
+
+    template <int W>
+    template <int OW>
+    typename std::enable_if<(OW <= W), void>::type
+    ISPCDriver<W>::computeSampleAndGradientAnyWidth(
+        const int *valid,
+        VKLVolume volume,
+        const vvec3fn<OW> &objectCoordinates,
+        vfloatn<OW> &samples,
+        vvec3fn<OW> &gradients)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+
+      vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
+
+      vintn<W> validW;
+      for (int i = 0; i < W; i++)
+        validW[i] = i < OW ? valid[i] : 0;
+
+      ocW.fill_inactive_lanes(validW);
+
+      vfloatn<W> samplesW;
+      vvec3fn<W> gradientsW;
+
+      volumeObject->computeSampleAndGradientV(
+          validW, ocW, samplesW, gradientsW);
+
+      for (int i = 0; i < OW; i++) {
+        samples[i]     = samplesW[i];
+        gradients.x[i] = gradientsW.x[i];
+        gradients.y[i] = gradientsW.y[i];
+        gradients.z[i] = gradientsW.z[i];
+      }
+    }
+
+    template <int W>
+    template <int OW>
+    typename std::enable_if<(OW > W), void>::type
+    ISPCDriver<W>::computeSampleAndGradientAnyWidth(
+        const int *valid,
+        VKLVolume volume,
+        const vvec3fn<OW> &objectCoordinates,
+        vfloatn<OW> &samples,
+        vvec3fn<OW> &gradients)
+    {
+      CommittedVolume<W> volumeObject = committedVolume(volume);
+
+      const int numPacks = OW / W + (OW % W != 0);
+
+      for (int packIndex = 0; packIndex < numPacks; packIndex++) {
+        vvec3fn<W> ocW = objectCoordinates.template extract_pack<W>(packIndex);
+
+        vintn<W> validW;
+        for (int i = 0; i < W; i++) {
+          const int lane = packIndex * W + i;
+          validW[i]      = lane < OW ? valid[lane] : 0;
+        }
+
+        ocW.fill_inactive_lanes(validW);
+
+        vfloatn<W> samplesW;
+        vvec3fn<W> gradientsW;
+
+        volumeObject->computeSampleAndGradientV(
+            validW, ocW, samplesW, gradientsW);
 
         for (int i = packIndex * W; i < (packIndex + 1) * W && i < OW; i++) {
+          samples[i]     = samplesW[i - packIndex * W];
           gradients.x[i] = gradientsW.x[i - packIndex * W];
           gradients.y[i] = gradientsW.y[i - packIndex * W];
           gradients.z[i] = gradientsW.z[i - packIndex * W];
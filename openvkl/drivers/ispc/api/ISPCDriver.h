@@ -21,6 +21,12 @@
 namespace openvkl {
   namespace ispc_driver {
 
+    template <int W>
+    struct Volume;
+
+    template <int W>
+    class CommittedVolume;
+
     template <int W>
     struct ISPCDriver : public api::Driver
     {
@@ -35,6 +41,8 @@ namespace openvkl {
 
       void commit(VKLObject object) override;
 
+      VKLFence commitAsync(VKLObject object) override;
+
       void release(VKLObject object) override;
 
       /////////////////////////////////////////////////////////////////////////
@@ -46,6 +54,11 @@ namespace openvkl {
                       const void *source,
                       VKLDataCreationFlags dataCreationFlags) override;
 
+      VKLData newDataFromFile(const char *filename,
+                              size_t offset,
+                              size_t numItems,
+                              VKLDataType dataType) override;
+
       /////////////////////////////////////////////////////////////////////////
       // Interval iterator ////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
@@ -125,6 +138,9 @@ namespace openvkl {
       void setBool(VKLObject object, const char *name, const bool b) override;
       void set1f(VKLObject object, const char *name, const float x) override;
       void set1i(VKLObject object, const char *name, const int x) override;
+      void set1ul(VKLObject object,
+                  const char *name,
+                  const uint64_t x) override;
       void setVec3f(VKLObject object,
                     const char *name,
                     const vec3f &v) override;
@@ -153,6 +169,9 @@ namespace openvkl {
           VKLValueSelector valueSelector,
           const utility::ArrayView<const float> &values) override;
 
+      void valueSelectorSetStepSize(VKLValueSelector valueSelector,
+                                    float stepSize) override;
+
       /////////////////////////////////////////////////////////////////////////
       // Volume ///////////////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
@@ -186,6 +205,39 @@ namespace openvkl {
 
 #undef __define_computeSampleSegN
 
+      void computeSampleLOD(VKLVolume volume,
+                            const vvec3fn<1> &objectCoordinates,
+                            float lod,
+                            vfloatn<1> &sample) override;
+
+      void computeSampleTime(VKLVolume volume,
+                             const vvec3fn<1> &objectCoordinates,
+                             float time,
+                             vfloatn<1> &sample) override;
+
+      void computeSampleHint(VKLVolume volume,
+                             const vvec3fn<1> &objectCoordinates,
+                             uint64_t *hint,
+                             vfloatn<1> &sample) override;
+
+      void computeSampleStream(VKLVolume volume,
+                               size_t count,
+                               const float *x,
+                               const float *y,
+                               const float *z,
+                               int stride,
+                               float *samples) override;
+
+      void sampleRays(VKLVolume volume,
+                      size_t numRays,
+                      const vec3f *origins,
+                      const vec3f *directions,
+                      const float *tStart,
+                      float dt,
+                      size_t numSteps,
+                      float *values,
+                      uint8 *labels) override;
+
 #define __define_computeGradientN(WIDTH)                               \
   void computeGradient##WIDTH(const int *valid,                        \
                               VKLVolume volume,                        \
@@ -199,11 +251,39 @@ namespace openvkl {
 
 #undef __define_computeGradientN
 
+#define __define_computeSampleAndGradientN(WIDTH)                      \
+  void computeSampleAndGradient##WIDTH(                                \
+      const int *valid,                                                \
+      VKLVolume volume,                                                \
+      const vvec3fn<WIDTH> &objectCoordinates,                         \
+      vfloatn<WIDTH> &samples,                                         \
+      vvec3fn<WIDTH> &gradients) override;
+
+      __define_computeSampleAndGradientN(1);
+      __define_computeSampleAndGradientN(4);
+      __define_computeSampleAndGradientN(8);
+      __define_computeSampleAndGradientN(16);
+
+#undef __define_computeSampleAndGradientN
+
       box3f getBoundingBox(VKLVolume volume) override;
 
       range1f getValueRange(VKLVolume volume) override;
 
+      VKLCacheStatistics getCacheStatistics(VKLVolume volume) override;
+
+      void updateVolumeRegion(VKLVolume volume, const box3i &region) override;
+
+      void serializeVolumeAccelerator(VKLVolume volume,
+                                      const std::string &filename) override;
+
      private:
+      // queries go to the volume's most recently committed state, which may
+      // be a separate instance after vklCommitAsync(). the query keeps it
+      // alive while in progress
+      CommittedVolume<W> committedVolume(VKLVolume volume,
+                                         bool forIterator = false);
+
       template <int OW>
       typename std::enable_if<(OW == 1), void>::type
       initIntervalIteratorAnyWidth(const int *valid,
@@ -349,6 +429,22 @@ namespace openvkl {
           VKLVolume volume,
           const vvec3fn<OW> &objectCoordinates,
           vvec3fn<OW> &gradients);
+
+      template <int OW>
+      typename std::enable_if<(OW <= W), void>::type
+      computeSampleAndGradientAnyWidth(const int *valid,
+                                       VKLVolume volume,
+                                       const vvec3fn<OW> &objectCoordinates,
+                                       vfloatn<OW> &samples,
+                                       vvec3fn<OW> &gradients);
+
+      template <int OW>
+      typename std::enable_if<(OW > W), void>::type
+      computeSampleAndGradientAnyWidth(const int *valid,
+                                       VKLVolume volume,
+                                       const vvec3fn<OW> &objectCoordinates,
+                                       vfloatn<OW> &samples,
+                                       vvec3fn<OW> &gradients);
     };
 
   }  // namespace ispc_driver
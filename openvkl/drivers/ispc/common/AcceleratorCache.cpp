@@ -0,0 +1,291 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "AcceleratorCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "../common/logging.h"
+#include "ospcommon/tasking/parallel_for.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // bump whenever the layout of the file, or of any cached structure,
+    // changes
+    static constexpr uint32_t ACCELERATOR_CACHE_VERSION = 4;
+
+    // sections start at multiples of this many bytes
+    static constexpr uint64_t ACCELERATOR_CACHE_ALIGNMENT = 64;
+
+    // bytes hashed by one task
+    static constexpr size_t HASH_BLOCK_SIZE = 1 << 20;
+
+    struct AcceleratorCacheHeader
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t numSections;
+      char type[32];
+      uint64_t inputHash;
+    };
+
+    static const char acceleratorCacheMagic[8] = {
+        'V', 'K', 'L', 'A', 'C', 'C', 'E', 'L'};
+
+    static inline uint64_t hashMix(uint64_t h, uint64_t word)
+    {
+      h ^= word * 0xff51afd7ed558ccdull;
+      h = (h << 31 | h >> 33) * 0x9e3779b97f4a7c15ull;
+      return h;
+    }
+
+    static inline uint64_t hashFinalize(uint64_t h)
+    {
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ull;
+      h ^= h >> 33;
+      return h;
+    }
+
+    static uint64_t hashBlock(const uint8_t *bytes,
+                              size_t numBytes,
+                              uint64_t seed)
+    {
+      uint64_t h = hashMix(seed, numBytes);
+
+      size_t i = 0;
+
+      for (; i + sizeof(uint64_t) <= numBytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(uint64_t));
+        h = hashMix(h, word);
+      }
+
+      uint64_t tail = 0;
+      if (i < numBytes) {
+        std::memcpy(&tail, bytes + i, numBytes - i);
+      }
+
+      return hashFinalize(hashMix(h, tail));
+    }
+
+    uint64_t hashBytes(const void *data, size_t numBytes, uint64_t seed)
+    {
+      const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+      if (numBytes <= HASH_BLOCK_SIZE) {
+        return hashBlock(bytes, numBytes, seed);
+      }
+
+      const size_t numBlocks =
+          (numBytes + HASH_BLOCK_SIZE - 1) / HASH_BLOCK_SIZE;
+
+      std::vector<uint64_t> blockHashes(numBlocks);
+
+      tasking::parallel_for(numBlocks, [&](size_t blockID) {
+        const size_t begin = blockID * HASH_BLOCK_SIZE;
+        const size_t end   = std::min(begin + HASH_BLOCK_SIZE, numBytes);
+
+        blockHashes[blockID] = hashBlock(bytes + begin, end - begin, blockID);
+      });
+
+      return hashBlock(reinterpret_cast<const uint8_t *>(blockHashes.data()),
+                       numBlocks * sizeof(uint64_t),
+                       seed);
+    }
+
+    uint64_t hashData(const Data *data, uint64_t seed)
+    {
+      if (!data) {
+        return hashValue(VKL_UNKNOWN, seed);
+      }
+
+      seed = hashValue(data->dataType, seed);
+      seed = hashValue(data->numItems, seed);
+
+      if (data->dataType == VKL_DATA) {
+        const Data *const *items = static_cast<const Data *const *>(data->data);
+
+        for (size_t i = 0; i < data->numItems; i++) {
+          seed = hashData(items[i], seed);
+        }
+
+        return seed;
+      }
+
+      return hashBytes(data->data, data->numBytes, seed);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // AcceleratorCacheWriter /////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+
+    AcceleratorCacheWriter::AcceleratorCacheWriter(const std::string &type,
+                                                   uint64_t inputHash)
+        : type(type), inputHash(inputHash)
+    {
+      if (type.size() >= sizeof(AcceleratorCacheHeader::type)) {
+        throw std::runtime_error("accelerator cache type name is too long");
+      }
+    }
+
+    void AcceleratorCacheWriter::addSection(const void *data, size_t numBytes)
+    {
+      sections.emplace_back(data, numBytes);
+    }
+
+    void AcceleratorCacheWriter::write(const std::string &filename) const
+    {
+      std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+      if (!file) {
+        throw std::runtime_error("could not open accelerator cache " +
+                                 filename + " for writing");
+      }
+
+      AcceleratorCacheHeader header{};
+      std::memcpy(header.magic, acceleratorCacheMagic, sizeof(header.magic));
+      header.version     = ACCELERATOR_CACHE_VERSION;
+      header.numSections = sections.size();
+      std::strncpy(header.type, type.c_str(), sizeof(header.type) - 1);
+      header.inputHash = inputHash;
+
+      // section table (offset and size of each section) follows the header
+      std::vector<uint64_t> table;
+
+      uint64_t offset =
+          sizeof(header) + sections.size() * 2 * sizeof(uint64_t);
+
+      for (const auto &s : sections) {
+        offset = (offset + ACCELERATOR_CACHE_ALIGNMENT - 1) /
+                 ACCELERATOR_CACHE_ALIGNMENT * ACCELERATOR_CACHE_ALIGNMENT;
+
+        table.push_back(offset);
+        table.push_back(s.second);
+
+        offset += s.second;
+      }
+
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char *>(table.data()),
+                 table.size() * sizeof(uint64_t));
+
+      const char padding[ACCELERATOR_CACHE_ALIGNMENT] = {};
+
+      for (size_t i = 0; i < sections.size(); i++) {
+        const uint64_t position = file.tellp();
+        file.write(padding, table[2 * i] - position);
+        file.write(static_cast<const char *>(sections[i].first),
+                   sections[i].second);
+      }
+
+      if (!file) {
+        throw std::runtime_error("could not write accelerator cache " +
+                                 filename);
+      }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // AcceleratorCache ///////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+
+    std::unique_ptr<AcceleratorCache> AcceleratorCache::open(
+        const std::string &filename,
+        const std::string &type,
+        uint64_t inputHash)
+    {
+      std::ifstream file(filename, std::ios::binary | std::ios::ate);
+
+      if (!file) {
+        return nullptr;
+      }
+
+      const uint64_t fileSize = file.tellg();
+      file.seekg(0);
+
+      // any file which cannot be used, stale or corrupt, is rebuilt
+      auto ignore = [&](const std::string &reason) {
+        LogMessageStream(VKL_LOG_WARNING)
+            << "accelerator cache " << filename << " " << reason
+            << ", rebuilding" << std::endl;
+        return nullptr;
+      };
+
+      AcceleratorCacheHeader header;
+
+      if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+          std::memcmp(header.magic,
+                      acceleratorCacheMagic,
+                      sizeof(header.magic)) != 0) {
+        return ignore("is not an accelerator cache");
+      }
+
+      header.type[sizeof(header.type) - 1] = '\0';
+
+      if (header.version != ACCELERATOR_CACHE_VERSION ||
+          type != header.type || inputHash != header.inputHash) {
+        return ignore("does not match the volume");
+      }
+
+      // the section table must fit in the file before it is allocated
+      const uint64_t tableEntrySize = 2 * sizeof(uint64_t);
+
+      if (header.numSections >
+          (fileSize - sizeof(header)) / tableEntrySize) {
+        return ignore("is truncated");
+      }
+
+      std::vector<uint64_t> table(2 * size_t(header.numSections));
+
+      if (!file.read(reinterpret_cast<char *>(table.data()),
+                     table.size() * sizeof(uint64_t))) {
+        return ignore("is truncated");
+      }
+
+      std::unique_ptr<AcceleratorCache> cache(new AcceleratorCache);
+
+      for (size_t i = 0; i < header.numSections; i++) {
+        const uint64_t offset   = table[2 * i];
+        const uint64_t numBytes = table[2 * i + 1];
+
+        if (offset % ACCELERATOR_CACHE_ALIGNMENT != 0 ||
+            numBytes > fileSize || offset > fileSize - numBytes) {
+          return ignore("is truncated");
+        }
+
+        cache->sections.emplace_back(offset, numBytes);
+      }
+
+      cache->mapping.reset(new Data(filename, 0, fileSize, VKL_UCHAR));
+
+      return cache;
+    }
+
+    const void *AcceleratorCache::sectionBytes(size_t i,
+                                               size_t &numBytes) const
+    {
+      if (i >= sections.size()) {
+        throw std::runtime_error("accelerator cache has too few sections");
+      }
+
+      numBytes = sections[i].second;
+
+      return static_cast<const char *>(mapping->data) + sections[i].first;
+    }
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
@@ -0,0 +1,136 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../common/Data.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // 64-bit hash of numBytes bytes at data, chained with seed; computed in
+    // parallel. used to tell whether a cached accelerator was built from the
+    // same inputs, not a cryptographic hash
+    uint64_t hashBytes(const void *data, size_t numBytes, uint64_t seed = 0);
+
+    template <typename T>
+    inline uint64_t hashValue(const T &value, uint64_t seed = 0)
+    {
+      return hashBytes(&value, sizeof(T), seed);
+    }
+
+    // hash of the type and contents of data (which may be NULL); arrays of
+    // VKL_DATA are hashed by the contents of their items
+    uint64_t hashData(const Data *data, uint64_t seed = 0);
+
+    // an accelerator cache file holds the acceleration structure of one
+    // volume as a list of sections, each aligned for direct use from a
+    // read-only memory mapping. it is tagged with the type of the structure
+    // and the hash of all inputs it was built from.
+    struct AcceleratorCacheWriter
+    {
+      AcceleratorCacheWriter(const std::string &type, uint64_t inputHash);
+
+      // data must stay valid until write()
+      void addSection(const void *data, size_t numBytes);
+
+      template <typename T>
+      void addSection(const std::vector<T> &items)
+      {
+        addSection(items.data(), items.size() * sizeof(T));
+      }
+
+      void write(const std::string &filename) const;
+
+     private:
+      std::string type;
+      uint64_t inputHash;
+      std::vector<std::pair<const void *, size_t>> sections;
+    };
+
+    struct AcceleratorCache
+    {
+      // maps filename; nullptr if there is no such file, if it holds a
+      // structure of a different type or built from different inputs, or if
+      // it is not a valid accelerator cache. all but the first case log a
+      // warning
+      static std::unique_ptr<AcceleratorCache> open(
+          const std::string &filename,
+          const std::string &type,
+          uint64_t inputHash);
+
+      size_t numSections() const;
+
+      // section i as an array of T; its size must be a multiple of sizeof(T)
+      template <typename T>
+      const T *section(size_t i, size_t &numItems) const;
+
+      // as above, for sections that must hold exactly numItems items
+      template <typename T>
+      const T *sectionOfSize(size_t i, size_t numItems) const;
+
+     private:
+      AcceleratorCache() = default;
+
+      const void *sectionBytes(size_t i, size_t &numBytes) const;
+
+      std::unique_ptr<Data> mapping;
+
+      // offset and size in bytes
+      std::vector<std::pair<uint64_t, uint64_t>> sections;
+    };
+
+    // Inlined definitions ////////////////////////////////////////////////////
+
+    inline size_t AcceleratorCache::numSections() const
+    {
+      return sections.size();
+    }
+
+    template <typename T>
+    inline const T *AcceleratorCache::section(size_t i, size_t &numItems) const
+    {
+      size_t numBytes;
+      const void *data = sectionBytes(i, numBytes);
+
+      if (numBytes % sizeof(T) != 0) {
+        throw std::runtime_error("accelerator cache section has wrong size");
+      }
+
+      numItems = numBytes / sizeof(T);
+      return static_cast<const T *>(data);
+    }
+
+    template <typename T>
+    inline const T *AcceleratorCache::sectionOfSize(size_t i,
+                                                    size_t numItems) const
+    {
+      size_t sectionItems;
+      const T *data = section<T>(i, sectionItems);
+
+      if (sectionItems != numItems) {
+        throw std::runtime_error("accelerator cache section has wrong size");
+      }
+
+      return data;
+    }
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
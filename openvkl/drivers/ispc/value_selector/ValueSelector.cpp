@@ -46,7 +46,8 @@ namespace openvkl {
                                           ranges.size(),
                                           (const ispc::box1f *)ranges.data(),
                                           values.size(),
-                                          (const float *)values.data());
+                                          (const float *)values.data(),
+                                          stepSize);
     }
 
     template <int W>
@@ -71,6 +72,16 @@ namespace openvkl {
       }
     }
 
+    template <int W>
+    void ValueSelector<W>::setStepSize(float stepSize)
+    {
+      if (!(stepSize >= 0.f)) {
+        throw std::runtime_error("step size must be non-negative");
+      }
+
+      this->stepSize = stepSize;
+    }
+
     template struct ValueSelector<4>;
     template struct ValueSelector<8>;
     template struct ValueSelector<16>;
@@ -40,6 +40,7 @@ namespace openvkl {
 
       void setRanges(const utility::ArrayView<const range1f> &ranges);
       void setValues(const utility::ArrayView<const float> &values);
+      void setStepSize(float stepSize);
 
       void *getISPCEquivalent() const;
 
@@ -48,6 +49,7 @@ namespace openvkl {
 
       std::vector<range1f> ranges;
       std::vector<float> values;
+      float stepSize{0.f};
 
       void *ispcEquivalent{nullptr};
     };
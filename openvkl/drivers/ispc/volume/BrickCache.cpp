@@ -0,0 +1,209 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "BrickCache.h"
+#include "../common/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    BrickCache::BrickCache(size_t bytesPerBrick,
+                           size_t maxBytes,
+                           uint64_t numBricks,
+                           const LoadFunction &loadFunction)
+        : bytesPerBrick(bytesPerBrick),
+          loadFunction(loadFunction),
+          slots(new Slot[numBricks])
+    {
+      // the budget holds at least one brick; it is split evenly over the
+      // shards, the first ones taking one more brick for the remainder
+      const size_t maxBricks = std::max(maxBytes / bytesPerBrick, size_t(1));
+
+      numShards = std::min(maxBricks, maxShards);
+      shards.reset(new Shard[numShards]);
+
+      for (size_t i = 0; i < numShards; i++) {
+        shards[i].maxBricks =
+            maxBricks / numShards + (i < maxBricks % numShards ? 1 : 0);
+      }
+    }
+
+    const void *BrickCache::pin(uint64_t brickID)
+    {
+      Slot &slot = slots[brickID];
+
+      slot.pinCount++;
+
+      const uint8_t *data = slot.data.load();
+
+      if (data) {
+        slot.referenced.store(true, std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return data;
+      }
+
+      return pinSlow(brickID);
+    }
+
+    void BrickCache::unpin(uint64_t brickID)
+    {
+      slots[brickID].pinCount--;
+    }
+
+    const void *BrickCache::pinSlow(uint64_t brickID)
+    {
+      Shard &shard = shardFor(brickID);
+      Slot &slot   = slots[brickID];
+
+      std::unique_lock<std::mutex> lock(shard.mutex);
+
+      // entries are never erased while pinned, so references to them stay
+      // valid while unlocked
+      auto it = shard.entries.find(brickID);
+
+      if (it != shard.entries.end()) {
+        Entry &entry = it->second;
+
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruPosition);
+
+        // another thread may still be loading the brick
+        shard.loadedCondition.wait(lock, [&]() { return entry.loaded; });
+
+        hits++;
+        return entry.data.get();
+      }
+
+      misses++;
+
+      std::unique_ptr<uint8_t[]> data = evict(shard);
+
+      if (!data) {
+        data.reset(new uint8_t[bytesPerBrick]);
+        bricksResident++;
+      }
+
+      Entry &entry = shard.entries[brickID];
+      entry.data   = std::move(data);
+      shard.lru.push_front(brickID);
+      entry.lruPosition = shard.lru.begin();
+
+      uint8_t *brick = entry.data.get();
+
+      lock.unlock();
+
+      // called from ISPC code, which cannot propagate exceptions
+      try {
+        loadFunction(brickID, brick);
+      } catch (const std::exception &e) {
+        postLogMessage(VKL_LOG_ERROR)
+            << "failed to load brick " << brickID << ": " << e.what();
+        std::memset(brick, 0, bytesPerBrick);
+      }
+
+      lock.lock();
+      entry.loaded = true;
+      slot.data.store(brick);
+      lock.unlock();
+
+      shard.loadedCondition.notify_all();
+
+      return brick;
+    }
+
+    VKLCacheStatistics BrickCache::getStatistics() const
+    {
+      VKLCacheStatistics statistics;
+      statistics.cacheHits      = hits;
+      statistics.cacheMisses    = misses;
+      statistics.cacheEvictions = evictions;
+      statistics.bytesResident  = bricksResident * bytesPerBrick;
+      return statistics;
+    }
+
+    BrickCache::Shard &BrickCache::shardFor(uint64_t brickID)
+    {
+      // neighboring bricks go to different shards
+      return shards[brickID % numShards];
+    }
+
+    std::unique_ptr<uint8_t[]> BrickCache::evict(Shard &shard)
+    {
+      std::unique_ptr<uint8_t[]> reuse;
+
+      // bricks pinned during earlier misses may have grown the shard beyond
+      // its budget, so this may evict several. the first pass skips (and
+      // clears) bricks referenced since the last scan; if all bricks are
+      // pinned, the shard grows beyond its budget.
+      for (int pass = 0; pass < 2; pass++) {
+        for (auto it = shard.lru.rbegin();
+             it != shard.lru.rend() &&
+             shard.entries.size() >= shard.maxBricks;) {
+          Slot &slot = slots[*it];
+
+          if (slot.referenced.exchange(false) && pass == 0) {
+            ++it;
+            continue;
+          }
+
+          if (slot.pinCount.load() != 0) {
+            ++it;
+            continue;
+          }
+
+          // a concurrent pin() either sees the cleared pointer and falls back
+          // to pinSlow(), which waits for the shard lock, or is seen here
+          uint8_t *data = slot.data.exchange(nullptr);
+
+          if (slot.pinCount.load() != 0) {
+            slot.data.store(data);
+            ++it;
+            continue;
+          }
+
+          auto entry = shard.entries.find(*it);
+
+          if (reuse) {
+            bricksResident--;
+          } else {
+            reuse = std::move(entry->second.data);
+          }
+
+          shard.entries.erase(entry);
+          it = decltype(it)(shard.lru.erase(std::next(it).base()));
+
+          evictions++;
+        }
+      }
+
+      return reuse;
+    }
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
+
+extern "C" const void *BrickCache_pin(void *cache, uint64_t brickID)
+{
+  return static_cast<openvkl::ispc_driver::BrickCache *>(cache)->pin(brickID);
+}
+
+extern "C" void BrickCache_unpin(void *cache, uint64_t brickID)
+{
+  static_cast<openvkl::ispc_driver::BrickCache *>(cache)->unpin(brickID);
+}
@@ -0,0 +1,127 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "openvkl/openvkl.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // bounded cache of fixed size bricks, loaded on demand. bricks are pinned
+    // while in use and are only evicted (roughly least recently used first)
+    // when unpinned. pinning a resident brick and unpinning take no locks;
+    // loads and evictions lock one of several shards, so concurrent misses
+    // on different bricks rarely contend.
+    struct BrickCache
+    {
+      // fill the given brick; must be thread safe
+      using LoadFunction = std::function<void(uint64_t brickID, void *brick)>;
+
+      // brick IDs are in [0, numBricks)
+      BrickCache(size_t bytesPerBrick,
+                 size_t maxBytes,
+                 uint64_t numBricks,
+                 const LoadFunction &loadFunction);
+
+      // returns the brick data, loading it if needed; stays valid until the
+      // matching unpin()
+      const void *pin(uint64_t brickID);
+
+      void unpin(uint64_t brickID);
+
+      VKLCacheStatistics getStatistics() const;
+
+     private:
+      // lock-free state of every brick. data is set only while the brick is
+      // resident and loaded; eviction clears it before checking pinCount, and
+      // pin() increments pinCount before reading it, so either eviction sees
+      // the pin or pin() sees the cleared pointer.
+      struct Slot
+      {
+        std::atomic<uint8_t *> data{nullptr};
+        std::atomic<int> pinCount{0};
+
+        // set on lock-free hits, which cannot reorder the LRU list; gives the
+        // brick a second chance on eviction
+        std::atomic<bool> referenced{false};
+      };
+
+      struct Entry
+      {
+        std::unique_ptr<uint8_t[]> data;
+        bool loaded{false};
+        std::list<uint64_t>::iterator lruPosition;
+      };
+
+      struct Shard
+      {
+        std::mutex mutex;
+        std::condition_variable loadedCondition;
+
+        std::unordered_map<uint64_t, Entry> entries;
+
+        // most recently used first
+        std::list<uint64_t> lru;
+
+        // share of the cache budget
+        size_t maxBricks{0};
+      };
+
+      static constexpr size_t maxShards = 16;
+
+      Shard &shardFor(uint64_t brickID);
+
+      // loads the brick, already pinned by the caller, or waits for another
+      // thread loading it
+      const void *pinSlow(uint64_t brickID);
+
+      // evicts unpinned bricks of the shard, least recently used first, until
+      // there is room for one more brick within its budget; returns the
+      // memory of one of them for reuse. shard must be locked.
+      std::unique_ptr<uint8_t[]> evict(Shard &shard);
+
+      size_t bytesPerBrick;
+      LoadFunction loadFunction;
+
+      std::unique_ptr<Slot[]> slots;
+
+      // at most maxShards, and no more than the budget has bricks
+      size_t numShards;
+
+      std::unique_ptr<Shard[]> shards;
+
+      std::atomic<uint64_t> hits{0};
+      std::atomic<uint64_t> misses{0};
+      std::atomic<uint64_t> evictions{0};
+      std::atomic<uint64_t> bricksResident{0};
+    };
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
+
+// entry points for the ISPC side (SharedStructuredVolume.ispc)
+extern "C" const void *BrickCache_pin(void *cache, uint64_t brickID);
+extern "C" void BrickCache_unpin(void *cache, uint64_t brickID);
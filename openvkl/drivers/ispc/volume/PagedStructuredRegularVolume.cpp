@@ -0,0 +1,388 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "PagedStructuredRegularVolume.h"
+
+#include <cmath>
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // value range of the width^3 voxels starting at lower in a brick, ignoring
+    // NaNs; NaN if all voxels are NaN (as in GridAccelerator_build())
+    template <typename T>
+    static range1f computeBrickRegionValueRange(const void *brick,
+                                                int brickStride,
+                                                const vec3i &lower,
+                                                int width)
+    {
+      const T *voxels = static_cast<const T *>(brick);
+
+      range1f valueRange(empty);
+
+      for (int z = lower.z; z < lower.z + width; z++) {
+        for (int y = lower.y; y < lower.y + width; y++) {
+          const T *line =
+              voxels + brickStride * (size_t(y) + size_t(brickStride) * z);
+
+          for (int x = lower.x; x < lower.x + width; x++) {
+            const float value = line[x];
+
+            if (!std::isnan(value)) {
+              valueRange.extend(value);
+            }
+          }
+        }
+      }
+
+      if (valueRange.empty()) {
+        valueRange = range1f(std::nanf(""));
+      }
+
+      return valueRange;
+    }
+
+    static range1f computeBrickRegionValueRange(VKLDataType voxelType,
+                                                const void *brick,
+                                                int brickStride,
+                                                const vec3i &lower,
+                                                int width)
+    {
+      switch (voxelType) {
+      case VKL_UCHAR:
+        return computeBrickRegionValueRange<uint8>(
+            brick, brickStride, lower, width);
+      case VKL_SHORT:
+        return computeBrickRegionValueRange<int16>(
+            brick, brickStride, lower, width);
+      case VKL_USHORT:
+        return computeBrickRegionValueRange<uint16>(
+            brick, brickStride, lower, width);
+      case VKL_FLOAT:
+        return computeBrickRegionValueRange<float>(
+            brick, brickStride, lower, width);
+      case VKL_DOUBLE:
+        return computeBrickRegionValueRange<double>(
+            brick, brickStride, lower, width);
+      default:
+        throw std::runtime_error("unsupported voxelType");
+      }
+    }
+
+    template <int W>
+    void PagedStructuredRegularVolume<W>::commit()
+    {
+      // not StructuredVolume<W>::commit(), as there is no "data" parameter
+
+      this->dimensions =
+          this->template getParam<vec3i>("dimensions", vec3i(128));
+      this->gridOrigin =
+          this->template getParam<vec3f>("gridOrigin", vec3f(0.f));
+      this->gridSpacing =
+          this->template getParam<vec3f>("gridSpacing", vec3f(1.f));
+
+      voxelType = (VKLDataType)this->template getParam<int>("voxelType",
+                                                            VKL_UNKNOWN);
+
+      if (voxelType != VKL_UCHAR && voxelType != VKL_SHORT &&
+          voxelType != VKL_USHORT && voxelType != VKL_FLOAT &&
+          voxelType != VKL_DOUBLE) {
+        throw std::runtime_error(
+            "voxelType must be one of VKL_UCHAR, VKL_SHORT, VKL_USHORT, "
+            "VKL_FLOAT or VKL_DOUBLE");
+      }
+
+      // bricks must hold whole macrocells, so the accelerator can be built
+      // from one brick at a time
+      this->commitMacrocellSize();
+
+      this->brickSize = this->template getParam<int>("brickSize", 32);
+
+      if (this->brickSize < this->macrocellSize || this->brickSize > 64 ||
+          (this->brickSize & (this->brickSize - 1))) {
+        throw std::runtime_error(
+            "brickSize must be a power of two in [macrocellSize, 64]");
+      }
+
+      const std::string filename =
+          this->template getParam<std::string>("filename", "");
+
+      loadVoxelsFunc = (VKLLoadVoxelsFunc)this->template getParam<void *>(
+          "loadVoxelsFunc", nullptr);
+      loadVoxelsUserData =
+          this->template getParam<void *>("loadVoxelsUserData", nullptr);
+
+      fileData.reset();
+
+      if (!filename.empty()) {
+        // set with vklSetULong(), or with vklSetInt() for small offsets
+        const int fileOffset32 = this->template getParam<int>("fileOffset", 0);
+
+        if (fileOffset32 < 0) {
+          throw std::runtime_error("fileOffset must not be negative");
+        }
+
+        const uint64_t fileOffset =
+            this->template getParam<uint64_t>("fileOffset", fileOffset32);
+
+        fileData.reset(new Data(filename,
+                                fileOffset,
+                                this->dimensions.long_product(),
+                                voxelType));
+      } else if (!loadVoxelsFunc) {
+        throw std::runtime_error(
+            "structured_regular_paged volumes require a filename or "
+            "loadVoxelsFunc");
+      }
+
+      const int maxCacheSizeMB =
+          this->template getParam<int>("maxCacheSizeMB", 1024);
+
+      if (maxCacheSizeMB <= 0) {
+        throw std::runtime_error("maxCacheSizeMB must be positive");
+      }
+
+      // must match SharedStructuredVolume_set()
+      numBricks =
+          vec3i(std::max((this->dimensions.x - 2) / this->brickSize + 1, 1),
+                std::max((this->dimensions.y - 2) / this->brickSize + 1, 1),
+                std::max((this->dimensions.z - 2) / this->brickSize + 1, 1));
+
+      const size_t brickStride = this->brickSize + 1;
+      bytesPerBrick =
+          sizeOf(voxelType) * brickStride * brickStride * brickStride;
+
+      brickCache.reset(new BrickCache(bytesPerBrick,
+                                      size_t(maxCacheSizeMB) << 20,
+                                      numBricks.long_product(),
+                                      [this](uint64_t brickID, void *brick) {
+                                        loadBrick(brickID, brick);
+                                      }));
+
+      if (!this->ispcEquivalent) {
+        this->ispcEquivalent = ispc::SharedStructuredVolume_Constructor();
+
+        if (!this->ispcEquivalent) {
+          throw std::runtime_error(
+              "could not create ISPC-side object for "
+              "PagedStructuredRegularVolume");
+        }
+      }
+
+      bool success =
+          ispc::SharedStructuredVolume_set(
+              this->ispcEquivalent,
+              nullptr,
+              voxelType,
+              (const ispc::vec3i &)this->dimensions,
+              ispc::structured_regular,
+              (const ispc::vec3f &)this->gridOrigin,
+              (const ispc::vec3f &)this->gridSpacing,
+              nullptr,
+              VKL_UNKNOWN,
+              this->brickSize) &&
+          ispc::SharedStructuredVolume_setBrickCache(this->ispcEquivalent,
+                                                     brickCache.get());
+
+      if (!success) {
+        ispc::SharedStructuredVolume_Destructor(this->ispcEquivalent);
+        this->ispcEquivalent = nullptr;
+
+        throw std::runtime_error(
+            "failed to commit PagedStructuredRegularVolume");
+      }
+
+      // must be last
+      buildAcceleratorStreaming();
+    }
+
+    template <int W>
+    VKLCacheStatistics PagedStructuredRegularVolume<W>::getCacheStatistics()
+        const
+    {
+      return brickCache ? brickCache->getStatistics() : VKLCacheStatistics{};
+    }
+
+    template <int W>
+    void PagedStructuredRegularVolume<W>::updateRegion(const box3i &)
+    {
+      throw std::runtime_error(
+          "structured_regular_paged volumes do not support region updates");
+    }
+
+    template <int W>
+    void PagedStructuredRegularVolume<W>::serializeAccelerator(
+        const std::string &) const
+    {
+      throw std::runtime_error(
+          "structured_regular_paged volumes do not support accelerator "
+          "caches");
+    }
+
+    template <int W>
+    void PagedStructuredRegularVolume<W>::loadBrick(uint64_t brickID,
+                                                    void *brick) const
+    {
+      const vec3i brickIndex(brickID % numBricks.x,
+                             (brickID / numBricks.x) % numBricks.y,
+                             brickID / (size_t(numBricks.x) * numBricks.y));
+
+      const int brickStride = this->brickSize + 1;
+
+      // voxels of the brick within the volume
+      const vec3i lower = brickIndex * this->brickSize;
+      const vec3i upper = min(lower + vec3i(brickStride), this->dimensions);
+      const vec3i size  = upper - lower;
+
+      const size_t bytesPerVoxel = sizeOf(voxelType);
+
+      const uint8 *src;
+      vec3i srcDimensions;
+      std::vector<uint8> scratch;
+
+      if (fileData) {
+        src = static_cast<const uint8 *>(fileData->data) +
+              bytesPerVoxel *
+                  (lower.x + this->dimensions.x *
+                                 (size_t(lower.y) +
+                                  size_t(this->dimensions.y) * lower.z));
+        srcDimensions = this->dimensions;
+      } else {
+        const vkl_box3i box{{lower.x, lower.y, lower.z},
+                            {upper.x, upper.y, upper.z}};
+
+        // interior bricks need no apron replication
+        if (size == vec3i(brickStride)) {
+          loadVoxelsFunc(loadVoxelsUserData, &box, brick);
+          return;
+        }
+
+        scratch.resize(size.long_product() * bytesPerVoxel);
+        loadVoxelsFunc(loadVoxelsUserData, &box, scratch.data());
+
+        src           = scratch.data();
+        srcDimensions = size;
+      }
+
+      // as in StructuredVolume<W>::buildBricks(), voxels beyond the volume
+      // bounds replicate the boundary voxel
+      uint8 *dst = static_cast<uint8 *>(brick);
+
+      for (int z = 0; z < brickStride; z++) {
+        for (int y = 0; y < brickStride; y++) {
+          const size_t srcY = std::min(y, size.y - 1);
+          const size_t srcZ = std::min(z, size.z - 1);
+
+          const uint8 *srcLine =
+              src + bytesPerVoxel * srcDimensions.x *
+                        (srcY + size_t(srcDimensions.y) * srcZ);
+
+          std::memcpy(dst, srcLine, size.x * bytesPerVoxel);
+
+          for (int x = size.x; x < brickStride; x++) {
+            std::memcpy(dst + x * bytesPerVoxel,
+                        srcLine + (size.x - 1) * bytesPerVoxel,
+                        bytesPerVoxel);
+          }
+
+          dst += brickStride * bytesPerVoxel;
+        }
+      }
+    }
+
+    template <int W>
+    void PagedStructuredRegularVolume<W>::buildAcceleratorStreaming()
+    {
+      void *accelerator =
+          ispc::SharedStructuredVolume_createAccelerator(this->ispcEquivalent,
+                                                         this->macrocellSize);
+
+      const int cellWidth     = this->macrocellSize;
+      const int cellsPerBrick = this->brickSize / cellWidth;
+      const int brickStride   = this->brickSize + 1;
+
+      // macrocells covering at least one volume cell; each lies within the
+      // brick holding its lower corner, including the upper boundary voxels
+      const vec3i numCells(
+          std::max((this->dimensions.x - 2) / cellWidth + 1, 1),
+          std::max((this->dimensions.y - 2) / cellWidth + 1, 1),
+          std::max((this->dimensions.z - 2) / cellWidth + 1, 1));
+
+      std::vector<range1f> cellValueRanges(numCells.long_product());
+
+      tasking::parallel_for(numBricks.long_product(), [&](size_t brickID) {
+        std::vector<uint8> brick(bytesPerBrick);
+        loadBrick(brickID, brick.data());
+
+        const vec3i brickIndex(brickID % numBricks.x,
+                               (brickID / numBricks.x) % numBricks.y,
+                               brickID / (size_t(numBricks.x) * numBricks.y));
+
+        const vec3i cellBegin = brickIndex * cellsPerBrick;
+        const vec3i cellEnd   = min(cellBegin + vec3i(cellsPerBrick), numCells);
+
+        for (int z = cellBegin.z; z < cellEnd.z; z++) {
+          for (int y = cellBegin.y; y < cellEnd.y; y++) {
+            for (int x = cellBegin.x; x < cellEnd.x; x++) {
+              const vec3i lower =
+                  vec3i(x, y, z) * cellWidth - brickIndex * this->brickSize;
+
+              cellValueRanges[x + numCells.x *
+                                      (size_t(y) + size_t(numCells.y) * z)] =
+                  computeBrickRegionValueRange(voxelType,
+                                               brick.data(),
+                                               brickStride,
+                                               lower,
+                                               cellWidth + 1);
+            }
+          }
+        }
+      });
+
+      ispc::GridAccelerator_setCellValueRanges(
+          accelerator,
+          (const ispc::vec3i &)numCells,
+          (const ispc::box1f *)cellValueRanges.data());
+
+      const vec3i acceleratorCells =
+          vec3i(ispc::GridAccelerator_getBricksPerDimension_x(accelerator),
+                ispc::GridAccelerator_getBricksPerDimension_y(accelerator),
+                ispc::GridAccelerator_getBricksPerDimension_z(accelerator)) *
+          ispc::GridAccelerator_getBrickWidth();
+
+      ispc::GridAccelerator_buildHierarchy(
+          accelerator,
+          (const ispc::vec3i &)vec3i(0),
+          (const ispc::vec3i &)acceleratorCells);
+
+      this->valueRange = range1f(empty);
+
+      for (const auto &r : cellValueRanges) {
+        if (!std::isnan(r.lower)) {
+          this->valueRange.extend(r);
+        }
+      }
+    }
+
+    VKL_REGISTER_VOLUME(PagedStructuredRegularVolume<4>,
+                        structured_regular_paged_4)
+    VKL_REGISTER_VOLUME(PagedStructuredRegularVolume<8>,
+                        structured_regular_paged_8)
+    VKL_REGISTER_VOLUME(PagedStructuredRegularVolume<16>,
+                        structured_regular_paged_16)
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
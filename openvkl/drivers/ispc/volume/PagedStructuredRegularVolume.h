@@ -0,0 +1,63 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <memory>
+#include "BrickCache.h"
+#include "StructuredRegularVolume.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // structured regular volume whose voxels are not held in memory: bricks
+    // are loaded on demand, from a raw file or a user callback, into a bounded
+    // BrickCache. sampling, gradients and iterators are those of the regular
+    // bricked layout, with brick accesses going through the cache.
+    template <int W>
+    struct PagedStructuredRegularVolume : public StructuredRegularVolume<W>
+    {
+      void commit() override;
+
+      VKLCacheStatistics getCacheStatistics() const override;
+
+      void updateRegion(const box3i &region) override;
+
+      // the accelerator is built while streaming the voxels, and not cached
+      void serializeAccelerator(const std::string &filename) const override;
+
+     private:
+      // fill one brick (including its apron) from the voxel source
+      void loadBrick(uint64_t brickID, void *brick) const;
+
+      // streams all bricks once, without going through the cache, to compute
+      // the macrocell value ranges of the accelerator and the value range
+      void buildAcceleratorStreaming();
+
+      VKLDataType voxelType{VKL_UNKNOWN};
+      vec3i numBricks;
+      size_t bytesPerBrick{0};
+
+      // voxel source: a mapped raw file, or a user callback
+      std::unique_ptr<Data> fileData;
+      VKLLoadVoxelsFunc loadVoxelsFunc{nullptr};
+      void *loadVoxelsUserData{nullptr};
+
+      std::unique_ptr<BrickCache> brickCache;
+    };
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
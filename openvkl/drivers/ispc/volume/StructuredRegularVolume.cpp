@@ -35,12 +35,15 @@ namespace openvkl {
 
       bool success = ispc::SharedStructuredVolume_set(
           this->ispcEquivalent,
-          this->voxelData->data,
+          this->voxelDataPtr(),
           this->voxelData->dataType,
           (const ispc::vec3i &)this->dimensions,
           ispc::structured_regular,
           (const ispc::vec3f &)this->gridOrigin,
-          (const ispc::vec3f &)this->gridSpacing);
+          (const ispc::vec3f &)this->gridSpacing,
+          this->labelDataPtr(),
+          this->labelDataType(),
+          this->brickSize);
 
       if (!success) {
         ispc::SharedStructuredVolume_Destructor(this->ispcEquivalent);
@@ -49,6 +52,9 @@ namespace openvkl {
         throw std::runtime_error("failed to commit StructuredRegularVolume");
       }
 
+      this->buildMipLevels(
+          ispc::structured_regular, this->gridOrigin, this->gridSpacing);
+
       // must be last
       this->buildAccelerator();
     }
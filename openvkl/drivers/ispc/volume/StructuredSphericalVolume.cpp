@@ -86,12 +86,15 @@ namespace openvkl {
 
       bool success = ispc::SharedStructuredVolume_set(
           this->ispcEquivalent,
-          this->voxelData->data,
+          this->voxelDataPtr(),
           this->voxelData->dataType,
           (const ispc::vec3i &)this->dimensions,
           ispc::structured_spherical,
           (const ispc::vec3f &)gridOriginRadians,
-          (const ispc::vec3f &)gridSpacingRadians);
+          (const ispc::vec3f &)gridSpacingRadians,
+          this->labelDataPtr(),
+          this->labelDataType(),
+          this->brickSize);
 
       if (!success) {
         ispc::SharedStructuredVolume_Destructor(this->ispcEquivalent);
@@ -100,6 +103,9 @@ namespace openvkl {
         throw std::runtime_error("failed to commit StructuredSphericalVolume");
       }
 
+      this->buildMipLevels(
+          ispc::structured_spherical, gridOriginRadians, gridSpacingRadians);
+
       // must be last
       this->buildAccelerator();
     }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "../common/AcceleratorCache.h"
 #include "../common/Data.h"
 #include "../common/math.h"
 #include "GridAccelerator_ispc.h"
@@ -23,9 +24,22 @@
 #include "Volume.h"
 #include "ospcommon/tasking/parallel_for.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
 namespace openvkl {
   namespace ispc_driver {
 
+    enum MipFilter
+    {
+      MIP_FILTER_AVERAGE,
+      MIP_FILTER_MIN,
+      MIP_FILTER_MAX
+    };
+
     template <int W>
     struct StructuredVolume : public Volume<W>
     {
@@ -36,40 +50,233 @@ namespace openvkl {
       void computeSample(const vvec3fn<1> &objectCoordinates,
                          vfloatn<1> &samples) const override;
 
+      void computeSampleLOD(const vvec3fn<1> &objectCoordinates,
+                            float lod,
+                            vfloatn<1> &sample) const override;
+
       void computeSampleV(const vintn<W> &valid,
                           const vvec3fn<W> &objectCoordinates,
                           vfloatn<W> &samples) const override;
 
       void computeSampleSegV(const vintn<W> &valid,
-                          const vvec3fn<W> &objectCoordinates,
-                          vfloatn<W> &samples, 
-                          uint8 *segmentation) const override;
-                          
+                             const vvec3fn<W> &objectCoordinates,
+                             vfloatn<W> &samples,
+                             uint8 *segmentation) const override;
+
+      void computeSampleStream(size_t count,
+                               const float *x,
+                               const float *y,
+                               const float *z,
+                               int stride,
+                               float *samples) const override;
+
+      void sampleRays(size_t numRays,
+                      const vec3f *origins,
+                      const vec3f *directions,
+                      const float *tStart,
+                      float dt,
+                      size_t numSteps,
+                      float *values,
+                      uint8 *labels) const override;
+
       void computeGradientV(const vintn<W> &valid,
                             const vvec3fn<W> &objectCoordinates,
                             vvec3fn<W> &gradients) const override;
 
+      void computeSampleAndGradientV(const vintn<W> &valid,
+                                     const vvec3fn<W> &objectCoordinates,
+                                     vfloatn<W> &samples,
+                                     vvec3fn<W> &gradients) const override;
+
       box3f getBoundingBox() const override;
 
       range1f getValueRange() const override;
 
+      void updateRegion(const box3i &region) override;
+
+      void serializeAccelerator(const std::string &filename) const override;
+
      protected:
+      // read and validate the macrocellSize parameter
+      void commitMacrocellSize();
+
+      // build the accelerator, or load it from the "acceleratorCache"
+      // parameter if that names a cache matching this volume
       void buildAccelerator();
 
+      bool loadAccelerator();
+
+      // hash of everything the accelerator is built from
+      uint64_t hashAccelerator() const;
+
+      // hash of the voxels the accelerator bounds, chained with seed
+      virtual uint64_t hashVoxelData(uint64_t seed) const;
+
+      // rebuild the accelerator cells covering the voxels [lower, upper]
+      // (inclusive), and the value range
+      void updateAccelerator(const vec3i &lower, const vec3i &upper);
+
+      // value range as the union of acceleratorBrickValueRanges
+      void reduceValueRange();
+
       range1f valueRange{empty};
 
+      void *accelerator{nullptr};
+
+      // value ranges of the cells of each accelerator brick, so that updates
+      // only need to reduce over the bricks they touch
+      std::vector<range1f> acceleratorBrickValueRanges;
+
       // parameters set in commit()
       vec3i dimensions;
       vec3f gridOrigin;
       vec3f gridSpacing;
       Data *voxelData{nullptr};
+      Data *labelData{nullptr};
+
+      // width, in cells, of the accelerator's macrocells
+      int macrocellSize{16};
+
+      // 0 for the linear (user) layout, otherwise the brick size of the
+      // internal bricked copy of the voxel data
+      int brickSize{0};
+      std::vector<uint8> brickedVoxels;
+
+      // relayout voxelData into bricks of brickSize^3 cells, each including a
+      // one-voxel apron on the upper sides (see SharedStructuredVolume.ih)
+      void buildBricks();
+
+      // (re)copy the bricks [begin, end) from voxelData
+      void copyBricks(const vec3i &begin, const vec3i &end);
+
+      vec3i bricksPerDimension() const;
+
+      // voxel pointer to pass to the ISPC side; the bricked copy if present
+      const void *voxelDataPtr() const;
+
+      // label pointer / type to pass to the ISPC side; null / VKL_UNKNOWN if
+      // no labels were provided
+      const void *labelDataPtr() const;
+      VKLDataType labelDataType() const;
+
+      // optional mip pyramid of up to numMipLevels coarser levels, built with
+      // mipFilter; level i + 1 holds float voxels at every other voxel of
+      // level i, each filtering its 3^3 neighborhood in level i
+      int numMipLevels{0};
+      MipFilter mipFilter{MIP_FILTER_AVERAGE};
+      std::vector<vec3i> mipLevelDimensions;
+      std::vector<std::vector<float>> mipLevelVoxels;
+      std::vector<void *> mipLevelEquivalents;
+
+      // build the mip pyramid and attach it to the ISPC-side object; must be
+      // called after SharedStructuredVolume_set(), with the same grid
+      void buildMipLevels(ispc::SharedStructuredVolumeGridType gridType,
+                          const vec3f &gridOrigin,
+                          const vec3f &gridSpacing);
+
+      // (re)compute the voxels [begin, end) of level > 0 from the level below
+      void filterMipLevel(int level, const vec3i &begin, const vec3i &end);
+
+      void destroyMipLevels();
     };
 
+    // filter the 3^3 neighborhood of every other voxel of the fine level into
+    // the coarse voxels [coarseBegin, coarseEnd), in parallel over bricks of
+    // the coarse level. NaN voxels are ignored; coarse voxels with only NaN
+    // neighbors become NaN.
+    template <typename T>
+    inline void downsampleMipLevel(const T *fine,
+                                   const vec3i &fineDimensions,
+                                   float *coarse,
+                                   const vec3i &coarseDimensions,
+                                   const vec3i &coarseBegin,
+                                   const vec3i &coarseEnd,
+                                   MipFilter filter)
+    {
+      constexpr int brickSize = 16;
+
+      const vec3i numBricks =
+          (coarseEnd - coarseBegin + brickSize - 1) / brickSize;
+
+      // tent weights of the average filter
+      const float weights[3] = {0.25f, 0.5f, 0.25f};
+
+      tasking::parallel_for(numBricks.long_product(), [&](size_t brickID) {
+        const vec3i brick(brickID % numBricks.x,
+                          (brickID / numBricks.x) % numBricks.y,
+                          brickID / (size_t(numBricks.x) * numBricks.y));
+
+        const vec3i begin = coarseBegin + brick * brickSize;
+        const vec3i end   = min(begin + vec3i(brickSize), coarseEnd);
+
+        for (int z = begin.z; z < end.z; z++) {
+          for (int y = begin.y; y < end.y; y++) {
+            for (int x = begin.x; x < end.x; x++) {
+              float sum       = 0.f;
+              float sumWeight = 0.f;
+              range1f minMax(empty);
+
+              for (int k = 0; k < 3; k++) {
+                const int fz = 2 * z + k - 1;
+                if (fz < 0 || fz >= fineDimensions.z)
+                  continue;
+
+                for (int j = 0; j < 3; j++) {
+                  const int fy = 2 * y + j - 1;
+                  if (fy < 0 || fy >= fineDimensions.y)
+                    continue;
+
+                  const T *fineLine =
+                      fine + fineDimensions.x *
+                                 (size_t(fy) + size_t(fineDimensions.y) * fz);
+
+                  for (int i = 0; i < 3; i++) {
+                    const int fx = 2 * x + i - 1;
+                    if (fx < 0 || fx >= fineDimensions.x)
+                      continue;
+
+                    const float value = fineLine[fx];
+
+                    if (std::isnan(value))
+                      continue;
+
+                    const float weight = weights[i] * weights[j] * weights[k];
+
+                    sum += weight * value;
+                    sumWeight += weight;
+                    minMax.extend(value);
+                  }
+                }
+              }
+
+              float value;
+
+              if (minMax.empty()) {
+                value = std::numeric_limits<float>::quiet_NaN();
+              } else if (filter == MIP_FILTER_AVERAGE) {
+                value = sum / sumWeight;
+              } else if (filter == MIP_FILTER_MIN) {
+                value = minMax.lower;
+              } else {
+                value = minMax.upper;
+              }
+
+              coarse[x + coarseDimensions.x *
+                             (size_t(y) + size_t(coarseDimensions.y) * z)] =
+                  value;
+            }
+          }
+        }
+      });
+    }
+
     // Inlined definitions ////////////////////////////////////////////////////
 
     template <int W>
     StructuredVolume<W>::~StructuredVolume()
     {
+      destroyMipLevels();
+
       if (this->ispcEquivalent) {
         ispc::SharedStructuredVolume_Destructor(this->ispcEquivalent);
       }
@@ -93,6 +300,65 @@ namespace openvkl {
         throw std::runtime_error(
             "incorrect data size for provided volume dimensions");
       }
+
+      labelData = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
+          "labels", nullptr);
+
+      if (labelData) {
+        if (labelData->dataType != VKL_UCHAR &&
+            labelData->dataType != VKL_USHORT) {
+          throw std::runtime_error(
+              "labels must be of type VKL_UCHAR or VKL_USHORT");
+        }
+
+        if (labelData->size() != this->dimensions.long_product()) {
+          throw std::runtime_error(
+              "incorrect labels size for provided volume dimensions");
+        }
+      }
+
+      brickSize = this->template getParam<int>("brickSize", 0);
+
+      if (brickSize != 0 &&
+          (brickSize < 2 || brickSize > 64 || (brickSize & (brickSize - 1)))) {
+        throw std::runtime_error(
+            "brickSize must be 0 (linear layout) or a power of two in [2, 64]");
+      }
+
+      buildBricks();
+
+      numMipLevels = this->template getParam<int>("mipLevels", 0);
+
+      if (numMipLevels < 0) {
+        throw std::runtime_error("mipLevels must be non-negative");
+      }
+
+      const std::string filter =
+          this->template getParam<std::string>("mipFilter", "average");
+
+      if (filter == "average") {
+        mipFilter = MIP_FILTER_AVERAGE;
+      } else if (filter == "min") {
+        mipFilter = MIP_FILTER_MIN;
+      } else if (filter == "max") {
+        mipFilter = MIP_FILTER_MAX;
+      } else {
+        throw std::runtime_error(
+            "mipFilter must be one of \"average\", \"min\" or \"max\"");
+      }
+
+      commitMacrocellSize();
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::commitMacrocellSize()
+    {
+      macrocellSize = this->template getParam<int>("macrocellSize", 16);
+
+      if (macrocellSize != 4 && macrocellSize != 8 && macrocellSize != 16 &&
+          macrocellSize != 32) {
+        throw std::runtime_error("macrocellSize must be 4, 8, 16 or 32");
+      }
     }
 
     template <int W>
@@ -103,6 +369,16 @@ namespace openvkl {
           this->ispcEquivalent, &objectCoordinates, &samples);
     }
 
+    template <int W>
+    inline void StructuredVolume<W>::computeSampleLOD(
+        const vvec3fn<1> &objectCoordinates,
+        float lod,
+        vfloatn<1> &sample) const
+    {
+      ispc::SharedStructuredVolume_sampleLOD_uniform_export(
+          this->ispcEquivalent, &objectCoordinates, lod, &sample);
+    }
+
     template <int W>
     inline void StructuredVolume<W>::computeSampleV(
         const vintn<W> &valid,
@@ -123,10 +399,75 @@ namespace openvkl {
         uint8 *segmentation) const
     {
       ispc::SharedStructuredVolume_sample_seg_export((const int *)&valid,
-                                                 this->ispcEquivalent,
-                                                 &objectCoordinates,
-                                                 &samples,
-                                                 segmentation);
+                                                     this->ispcEquivalent,
+                                                     &objectCoordinates,
+                                                     &samples,
+                                                     segmentation);
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::computeSampleStream(size_t count,
+                                                         const float *x,
+                                                         const float *y,
+                                                         const float *z,
+                                                         int stride,
+                                                         float *samples) const
+    {
+      ispc::SharedStructuredVolume_sample_stream_export(
+          this->ispcEquivalent, count, x, y, z, stride, samples);
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::sampleRays(size_t numRays,
+                                                const vec3f *origins,
+                                                const vec3f *directions,
+                                                const float *tStart,
+                                                float dt,
+                                                size_t numSteps,
+                                                float *values,
+                                                uint8 *labels) const
+    {
+      // the ISPC side counts rays and steps in 32-bit ints
+      constexpr size_t maxCount = std::numeric_limits<int>::max();
+
+      if (numSteps <= maxCount) {
+        for (size_t begin = 0; begin < numRays; begin += maxCount) {
+          const size_t outOffset = begin * numSteps;
+
+          ispc::SharedStructuredVolume_sampleRays_export(
+              this->ispcEquivalent,
+              std::min(maxCount, numRays - begin),
+              (const ispc::vec3f *)(origins + begin),
+              (const ispc::vec3f *)(directions + begin),
+              tStart + begin,
+              dt,
+              numSteps,
+              values + outOffset,
+              labels ? labels + outOffset : nullptr);
+        }
+
+        return;
+      }
+
+      // longer rays are marched in chunks of steps, each starting where the
+      // previous one ended
+      for (size_t i = 0; i < numRays; i++) {
+        for (size_t begin = 0; begin < numSteps; begin += maxCount) {
+          const size_t outOffset  = i * numSteps + begin;
+          const float chunkTStart = tStart[i] + float(begin) * dt;
+
+          ispc::SharedStructuredVolume_sampleRays_export(
+              this->ispcEquivalent,
+              1,
+              (const ispc::vec3f *)(origins + i),
+              (const ispc::vec3f *)(directions + i),
+              &chunkTStart,
+              dt,
+              std::min(maxCount, numSteps - begin),
+              values + outOffset,
+              labels ? labels + outOffset : nullptr);
+        }
+      }
     }
 
     template <int W>
@@ -141,6 +482,21 @@ namespace openvkl {
                                                    &gradients);
     }
 
+    template <int W>
+    inline void StructuredVolume<W>::computeSampleAndGradientV(
+        const vintn<W> &valid,
+        const vvec3fn<W> &objectCoordinates,
+        vfloatn<W> &samples,
+        vvec3fn<W> &gradients) const
+    {
+      ispc::SharedStructuredVolume_sampleAndGradient_export(
+          (const int *)&valid,
+          this->ispcEquivalent,
+          &objectCoordinates,
+          &samples,
+          &gradients);
+    }
+
     template <int W>
     inline box3f StructuredVolume<W>::getBoundingBox() const
     {
@@ -157,28 +513,494 @@ namespace openvkl {
       return valueRange;
     }
 
+    template <int W>
+    inline void StructuredVolume<W>::buildBricks()
+    {
+      brickedVoxels.clear();
+      brickedVoxels.shrink_to_fit();
+
+      if (brickSize == 0) {
+        return;
+      }
+
+      const vec3i numBricks = bricksPerDimension();
+
+      const int brickStride = brickSize + 1;
+
+      brickedVoxels.resize(numBricks.long_product() *
+                           sizeOf(voxelData->dataType) * brickStride *
+                           brickStride * brickStride);
+
+      copyBricks(vec3i(0), numBricks);
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::copyBricks(const vec3i &begin,
+                                                const vec3i &end)
+    {
+      const vec3i numBricks = bricksPerDimension();
+
+      const size_t bytesPerVoxel = sizeOf(voxelData->dataType);
+      const int brickStride      = brickSize + 1;
+      const size_t bytesPerBrick =
+          bytesPerVoxel * brickStride * brickStride * brickStride;
+
+      const uint8 *src = static_cast<const uint8 *>(voxelData->data);
+
+      const vec3i numCopies = end - begin;
+
+      tasking::parallel_for(numCopies.long_product(), [&](size_t copyID) {
+        const vec3i brick =
+            begin + vec3i(copyID % numCopies.x,
+                          (copyID / numCopies.x) % numCopies.y,
+                          copyID / (size_t(numCopies.x) * numCopies.y));
+
+        const size_t brickID =
+            brick.x + numBricks.x * (size_t(brick.y) +
+                                     size_t(numBricks.y) * brick.z);
+
+        const vec3i brickOrigin = brick * brickSize;
+
+        uint8 *dst = brickedVoxels.data() + brickID * bytesPerBrick;
+
+        // voxels beyond the volume bounds (apron of the last brick, partial
+        // bricks) replicate the boundary voxel; they are never interpolated
+        const int numValidX =
+            std::min(brickStride, dimensions.x - brickOrigin.x);
+
+        for (int z = 0; z < brickStride; z++) {
+          for (int y = 0; y < brickStride; y++) {
+            const size_t srcY = std::min(brickOrigin.y + y, dimensions.y - 1);
+            const size_t srcZ = std::min(brickOrigin.z + z, dimensions.z - 1);
+
+            const uint8 *srcLine =
+                src + bytesPerVoxel *
+                          (brickOrigin.x +
+                           dimensions.x * (srcY + dimensions.y * srcZ));
+
+            std::memcpy(dst, srcLine, numValidX * bytesPerVoxel);
+
+            for (int x = numValidX; x < brickStride; x++) {
+              std::memcpy(dst + x * bytesPerVoxel,
+                          srcLine + (numValidX - 1) * bytesPerVoxel,
+                          bytesPerVoxel);
+            }
+
+            dst += brickStride * bytesPerVoxel;
+          }
+        }
+      });
+    }
+
+    template <int W>
+    inline vec3i StructuredVolume<W>::bricksPerDimension() const
+    {
+      // must match SharedStructuredVolume_set()
+      return vec3i(std::max((dimensions.x - 2) / brickSize + 1, 1),
+                   std::max((dimensions.y - 2) / brickSize + 1, 1),
+                   std::max((dimensions.z - 2) / brickSize + 1, 1));
+    }
+
+    template <int W>
+    inline const void *StructuredVolume<W>::voxelDataPtr() const
+    {
+      return brickSize ? brickedVoxels.data() : voxelData->data;
+    }
+
+    template <int W>
+    inline const void *StructuredVolume<W>::labelDataPtr() const
+    {
+      return labelData ? labelData->data : nullptr;
+    }
+
+    template <int W>
+    inline VKLDataType StructuredVolume<W>::labelDataType() const
+    {
+      return labelData ? labelData->dataType : VKL_UNKNOWN;
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::buildMipLevels(
+        ispc::SharedStructuredVolumeGridType gridType,
+        const vec3f &gridOrigin,
+        const vec3f &gridSpacing)
+    {
+      destroyMipLevels();
+
+      vec3i levelDimensions = dimensions;
+      vec3f levelSpacing    = gridSpacing;
+
+      // coarse voxel i lies on fine voxel 2i, so a level covers the fine
+      // voxels [0, 2 * (levelDimensions - 1)]: all of them for odd fine
+      // dimensions, all but the last for even ones. stop before any
+      // dimension would drop below two voxels.
+      for (int level = 1;
+           level <= numMipLevels && reduce_min(levelDimensions) > 2;
+           level++) {
+        levelDimensions = (levelDimensions + 1) / 2;
+        levelSpacing    = levelSpacing * 2.f;
+
+        mipLevelDimensions.push_back(levelDimensions);
+        mipLevelVoxels.emplace_back(levelDimensions.long_product());
+
+        filterMipLevel(level, vec3i(0), levelDimensions);
+
+        void *levelEquivalent = ispc::SharedStructuredVolume_Constructor();
+        mipLevelEquivalents.push_back(levelEquivalent);
+
+        bool success = ispc::SharedStructuredVolume_set(
+            levelEquivalent,
+            mipLevelVoxels.back().data(),
+            VKL_FLOAT,
+            (const ispc::vec3i &)levelDimensions,
+            gridType,
+            (const ispc::vec3f &)gridOrigin,
+            (const ispc::vec3f &)levelSpacing,
+            nullptr,
+            VKL_UNKNOWN,
+            0);
+
+        if (!success) {
+          destroyMipLevels();
+          throw std::runtime_error("failed to build mip level");
+        }
+      }
+
+      ispc::SharedStructuredVolume_setMipLevels(this->ispcEquivalent,
+                                                mipLevelEquivalents.size(),
+                                                mipLevelEquivalents.data());
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::destroyMipLevels()
+    {
+      if (this->ispcEquivalent) {
+        ispc::SharedStructuredVolume_setMipLevels(
+            this->ispcEquivalent, 0, nullptr);
+      }
+
+      for (void *levelEquivalent : mipLevelEquivalents) {
+        ispc::SharedStructuredVolume_Destructor(levelEquivalent);
+      }
+
+      mipLevelEquivalents.clear();
+      mipLevelVoxels.clear();
+      mipLevelDimensions.clear();
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::filterMipLevel(int level,
+                                                    const vec3i &begin,
+                                                    const vec3i &end)
+    {
+      float *coarse                 = mipLevelVoxels[level - 1].data();
+      const vec3i &coarseDimensions = mipLevelDimensions[level - 1];
+
+      if (level > 1) {
+        downsampleMipLevel(mipLevelVoxels[level - 2].data(),
+                           mipLevelDimensions[level - 2],
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        return;
+      }
+
+      // the user's linear voxel data, not the bricked copy
+      const void *fine = voxelData->data;
+
+      switch (voxelData->dataType) {
+      case VKL_UCHAR:
+        downsampleMipLevel(static_cast<const uint8 *>(fine),
+                           dimensions,
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        break;
+      case VKL_SHORT:
+        downsampleMipLevel(static_cast<const int16 *>(fine),
+                           dimensions,
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        break;
+      case VKL_USHORT:
+        downsampleMipLevel(static_cast<const uint16 *>(fine),
+                           dimensions,
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        break;
+      case VKL_FLOAT:
+        downsampleMipLevel(static_cast<const float *>(fine),
+                           dimensions,
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        break;
+      case VKL_DOUBLE:
+        downsampleMipLevel(static_cast<const double *>(fine),
+                           dimensions,
+                           coarse,
+                           coarseDimensions,
+                           begin,
+                           end,
+                           mipFilter);
+        break;
+      default:
+        throw std::runtime_error("unsupported voxelType");
+      }
+    }
+
     template <int W>
     inline void StructuredVolume<W>::buildAccelerator()
     {
-      void *accelerator =
-          ispc::SharedStructuredVolume_createAccelerator(this->ispcEquivalent);
+      accelerator =
+          ispc::SharedStructuredVolume_createAccelerator(this->ispcEquivalent,
+                                                         macrocellSize);
+
+      vec3i acceleratorBricks;
+      acceleratorBricks.x =
+          ispc::GridAccelerator_getBricksPerDimension_x(accelerator);
+      acceleratorBricks.y =
+          ispc::GridAccelerator_getBricksPerDimension_y(accelerator);
+      acceleratorBricks.z =
+          ispc::GridAccelerator_getBricksPerDimension_z(accelerator);
+
+      const int numBricks = acceleratorBricks.long_product();
+
+      acceleratorBrickValueRanges.resize(numBricks);
+
+      if (!loadAccelerator()) {
+        const int numTasks =
+            ispc::GridAccelerator_getBuildTaskCount(accelerator);
+
+        tasking::parallel_for(numTasks, [&](int taskIndex) {
+          ispc::GridAccelerator_build(accelerator, taskIndex);
+        });
+
+        tasking::parallel_for(numBricks, [&](int brickIndex) {
+          range1f &brickValueRange = acceleratorBrickValueRanges[brickIndex];
+          ispc::GridAccelerator_computeBrickValueRange(
+              accelerator,
+              brickIndex,
+              brickValueRange.lower,
+              brickValueRange.upper);
+        });
+      }
+
+      const vec3i numCells =
+          acceleratorBricks * ispc::GridAccelerator_getBrickWidth();
+
+      ispc::GridAccelerator_buildHierarchy(accelerator,
+                                           (const ispc::vec3i &)vec3i(0),
+                                           (const ispc::vec3i &)numCells);
+
+      reduceValueRange();
+    }
+
+    template <int W>
+    inline bool StructuredVolume<W>::loadAccelerator()
+    {
+      const std::string filename =
+          this->template getParam<std::string>("acceleratorCache", "");
 
-      vec3i bricksPerDimension;
-      bricksPerDimension.x =
+      if (filename.empty()) {
+        return false;
+      }
+
+      auto cache = AcceleratorCache::open(
+          filename, "grid_accelerator", hashAccelerator());
+
+      if (!cache) {
+        return false;
+      }
+
+      // macrocell value ranges, in the layout of the accelerator, and the
+      // value ranges of its bricks
+      const size_t cellCount = ispc::GridAccelerator_getCellCount(accelerator);
+
+      const range1f *cellValueRanges;
+      const range1f *brickValueRanges;
+
+      try {
+        cellValueRanges =
+            cache->template sectionOfSize<range1f>(0, cellCount);
+        brickValueRanges = cache->template sectionOfSize<range1f>(
+            1, acceleratorBrickValueRanges.size());
+      } catch (const std::runtime_error &e) {
+        LogMessageStream(VKL_LOG_WARNING)
+            << "ignoring corrupt accelerator cache " << filename << ": "
+            << e.what() << std::endl;
+        return false;
+      }
+
+      std::memcpy(ispc::GridAccelerator_getCellValueRanges(accelerator),
+                  cellValueRanges,
+                  cellCount * sizeof(range1f));
+
+      std::copy(brickValueRanges,
+                brickValueRanges + acceleratorBrickValueRanges.size(),
+                acceleratorBrickValueRanges.begin());
+
+      postLogMessage(VKL_LOG_DEBUG) << "using accelerator cache " << filename;
+
+      return true;
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::serializeAccelerator(
+        const std::string &filename) const
+    {
+      if (!accelerator) {
+        throw std::runtime_error(
+            "volume must be committed before serializing its accelerator");
+      }
+
+      AcceleratorCacheWriter writer("grid_accelerator", hashAccelerator());
+
+      writer.addSection(ispc::GridAccelerator_getCellValueRanges(accelerator),
+                        ispc::GridAccelerator_getCellCount(accelerator) *
+                            sizeof(range1f));
+      writer.addSection(acceleratorBrickValueRanges);
+
+      writer.write(filename);
+    }
+
+    template <int W>
+    inline uint64_t StructuredVolume<W>::hashAccelerator() const
+    {
+      uint64_t hash = hashValue(dimensions);
+      hash          = hashValue(macrocellSize, hash);
+      return hashVoxelData(hash);
+    }
+
+    template <int W>
+    inline uint64_t StructuredVolume<W>::hashVoxelData(uint64_t seed) const
+    {
+      return hashData(voxelData, seed);
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::updateAccelerator(const vec3i &lower,
+                                                       const vec3i &upper)
+    {
+      const int cellWidth  = ispc::GridAccelerator_getCellWidth(accelerator);
+      const int brickWidth = ispc::GridAccelerator_getBrickWidth();
+
+      vec3i acceleratorBricks;
+      acceleratorBricks.x =
           ispc::GridAccelerator_getBricksPerDimension_x(accelerator);
-      bricksPerDimension.y =
+      acceleratorBricks.y =
           ispc::GridAccelerator_getBricksPerDimension_y(accelerator);
-      bricksPerDimension.z =
+      acceleratorBricks.z =
           ispc::GridAccelerator_getBricksPerDimension_z(accelerator);
 
-      const int numTasks =
-          bricksPerDimension.x * bricksPerDimension.y * bricksPerDimension.z;
-      tasking::parallel_for(numTasks, [&](int taskIndex) {
-        ispc::GridAccelerator_build(accelerator, taskIndex);
+      const vec3i numCells = acceleratorBricks * brickWidth;
+
+      // cell c covers voxels [c, c + 1] * cellWidth; cells padding the volume
+      // out to whole bricks are always empty
+      const vec3i cellBegin = max(lower - 1, vec3i(0)) / cellWidth;
+      const vec3i cellEnd   = min(upper / cellWidth + 1, numCells);
+
+      const vec3i numUpdates = cellEnd - cellBegin;
+
+      tasking::parallel_for(numUpdates.long_product(), [&](size_t updateID) {
+        const vec3i cellIndex =
+            cellBegin + vec3i(updateID % numUpdates.x,
+                              (updateID / numUpdates.x) % numUpdates.y,
+                              updateID / (size_t(numUpdates.x) * numUpdates.y));
+
+        ispc::GridAccelerator_buildCell(accelerator,
+                                        (const ispc::vec3i &)cellIndex);
       });
 
-      ispc::GridAccelerator_computeValueRange(
-          accelerator, valueRange.lower, valueRange.upper);
+      const vec3i brickBegin      = cellBegin / brickWidth;
+      const vec3i brickEnd        = (cellEnd - 1) / brickWidth + 1;
+      const vec3i numBrickUpdates = brickEnd - brickBegin;
+
+      tasking::parallel_for(
+          numBrickUpdates.long_product(), [&](size_t updateID) {
+            const vec3i brick =
+                brickBegin +
+                vec3i(updateID % numBrickUpdates.x,
+                      (updateID / numBrickUpdates.x) % numBrickUpdates.y,
+                      updateID / (size_t(numBrickUpdates.x) *
+                                  numBrickUpdates.y));
+
+            const int brickIndex =
+                brick.x + acceleratorBricks.x *
+                              (brick.y + acceleratorBricks.y * brick.z);
+
+            range1f &brickValueRange = acceleratorBrickValueRanges[brickIndex];
+            ispc::GridAccelerator_computeBrickValueRange(
+                accelerator,
+                brickIndex,
+                brickValueRange.lower,
+                brickValueRange.upper);
+          });
+
+      ispc::GridAccelerator_buildHierarchy(accelerator,
+                                           (const ispc::vec3i &)cellBegin,
+                                           (const ispc::vec3i &)cellEnd);
+
+      reduceValueRange();
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::reduceValueRange()
+    {
+      valueRange = range1f(empty);
+
+      for (const auto &brickValueRange : acceleratorBrickValueRanges) {
+        valueRange.extend(brickValueRange);
+      }
+    }
+
+    template <int W>
+    inline void StructuredVolume<W>::updateRegion(const box3i &region)
+    {
+      if (!this->ispcEquivalent || !accelerator) {
+        throw std::runtime_error(
+            "volume must be committed before updating a region");
+      }
+
+      // voxels [lower, upper] (inclusive) within the volume
+      const vec3i lower = max(region.lower, vec3i(0));
+      const vec3i upper = min(region.upper, dimensions) - 1;
+
+      if (lower.x > upper.x || lower.y > upper.y || lower.z > upper.z) {
+        return;
+      }
+
+      if (brickSize) {
+        // brick b holds voxels [b, b + 1] * brickSize, including its apron
+        copyBricks(max(lower - 1, vec3i(0)) / brickSize,
+                   min(upper / brickSize + 1, bricksPerDimension()));
+      }
+
+      // coarse voxel i filters the fine voxels [2i - 1, 2i + 1]
+      vec3i levelLower = lower;
+      vec3i levelUpper = upper;
+
+      for (size_t level = 1; level <= mipLevelVoxels.size(); level++) {
+        levelLower = levelLower / 2;
+        levelUpper =
+            min((levelUpper + 1) / 2, mipLevelDimensions[level - 1] - 1);
+
+        filterMipLevel(level, levelLower, levelUpper + 1);
+      }
+
+      updateAccelerator(lower, upper);
     }
 
   }  // namespace ispc_driver
@@ -0,0 +1,199 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "TemporalStructuredRegularVolume.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    template <int W>
+    TemporalStructuredRegularVolume<W>::~TemporalStructuredRegularVolume()
+    {
+      destroyTimesteps();
+    }
+
+    template <int W>
+    void TemporalStructuredRegularVolume<W>::commit()
+    {
+      // not StructuredVolume<W>::commit(), as voxels are given per timestep
+
+      const vec3i dimensions =
+          this->template getParam<vec3i>("dimensions", vec3i(128));
+      const vec3f gridOrigin =
+          this->template getParam<vec3f>("gridOrigin", vec3f(0.f));
+      const vec3f gridSpacing =
+          this->template getParam<vec3f>("gridSpacing", vec3f(1.f));
+
+      Data *timesteps = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
+          "timesteps", nullptr);
+
+      const int macrocellSize = this->macrocellSize;
+      this->commitMacrocellSize();
+
+      time = this->template getParam<float>("time", 0.f);
+
+      if (!(time >= 0.f && time <= 1.f)) {
+        throw std::runtime_error("time must be in [0, 1]");
+      }
+
+      if (!timesteps || timesteps->dataType != VKL_DATA ||
+          timesteps->size() == 0) {
+        throw std::runtime_error(
+            "structured_regular_temporal volumes require a non-empty "
+            "'timesteps' array of VKL_DATA");
+      }
+
+      Data **timestepVoxels = (Data **)timesteps->data;
+
+      for (size_t i = 0; i < timesteps->size(); i++) {
+        if (!timestepVoxels[i]) {
+          throw std::runtime_error("timesteps must not be NULL");
+        }
+
+        if (timestepVoxels[i]->dataType != timestepVoxels[0]->dataType) {
+          throw std::runtime_error(
+              "all timesteps must have the same VKLDataType");
+        }
+
+        if (timestepVoxels[i]->size() != dimensions.long_product()) {
+          throw std::runtime_error(
+              "incorrect timestep size for provided volume dimensions");
+        }
+      }
+
+      // only the time changed: keep the timesteps and the accelerator, so
+      // playing back a sequence does not rebuild anything
+      if (this->ispcEquivalent && !timestepEquivalents.empty() &&
+          timesteps == timestepsData.ptr && dimensions == this->dimensions &&
+          gridOrigin == this->gridOrigin && gridSpacing == this->gridSpacing &&
+          macrocellSize == this->macrocellSize) {
+        ispc::SharedStructuredVolume_setTimesteps(this->ispcEquivalent,
+                                                  timestepEquivalents.size(),
+                                                  timestepEquivalents.data(),
+                                                  time);
+        return;
+      }
+
+      this->dimensions  = dimensions;
+      this->gridOrigin  = gridOrigin;
+      this->gridSpacing = gridSpacing;
+      this->voxelData   = timestepVoxels[0];
+      timestepsData     = timesteps;
+
+      if (!this->ispcEquivalent) {
+        this->ispcEquivalent = ispc::SharedStructuredVolume_Constructor();
+
+        if (!this->ispcEquivalent) {
+          throw std::runtime_error(
+              "could not create ISPC-side object for "
+              "TemporalStructuredRegularVolume");
+        }
+      }
+
+      // the volume itself is set up on timestep 0 for its grid, bounding box
+      // and addressing; its sampling functions are then replaced by the time
+      // series'
+      destroyTimesteps();
+
+      for (size_t i = 0; i < timesteps->size(); i++) {
+        void *timestepEquivalent = ispc::SharedStructuredVolume_Constructor();
+        timestepEquivalents.push_back(timestepEquivalent);
+
+        bool success = ispc::SharedStructuredVolume_set(
+            timestepEquivalent,
+            timestepVoxels[i]->data,
+            timestepVoxels[i]->dataType,
+            (const ispc::vec3i &)this->dimensions,
+            ispc::structured_regular,
+            (const ispc::vec3f &)this->gridOrigin,
+            (const ispc::vec3f &)this->gridSpacing,
+            nullptr,
+            VKL_UNKNOWN,
+            0);
+
+        if (!success) {
+          destroyTimesteps();
+          timestepsData = nullptr;
+          throw std::runtime_error(
+              "failed to commit TemporalStructuredRegularVolume");
+        }
+      }
+
+      bool success = ispc::SharedStructuredVolume_set(
+          this->ispcEquivalent,
+          this->voxelData->data,
+          this->voxelData->dataType,
+          (const ispc::vec3i &)this->dimensions,
+          ispc::structured_regular,
+          (const ispc::vec3f &)this->gridOrigin,
+          (const ispc::vec3f &)this->gridSpacing,
+          nullptr,
+          VKL_UNKNOWN,
+          0);
+
+      if (!success) {
+        destroyTimesteps();
+        timestepsData = nullptr;
+        throw std::runtime_error(
+            "failed to commit TemporalStructuredRegularVolume");
+      }
+
+      ispc::SharedStructuredVolume_setTimesteps(this->ispcEquivalent,
+                                                timestepEquivalents.size(),
+                                                timestepEquivalents.data(),
+                                                time);
+
+      // must be last
+      this->buildAccelerator();
+    }
+
+    template <int W>
+    void TemporalStructuredRegularVolume<W>::computeSampleTime(
+        const vvec3fn<1> &objectCoordinates,
+        float time,
+        vfloatn<1> &sample) const
+    {
+      ispc::SharedStructuredVolume_sampleTime_uniform_export(
+          this->ispcEquivalent, &objectCoordinates, time, &sample);
+    }
+
+    template <int W>
+    uint64_t TemporalStructuredRegularVolume<W>::hashVoxelData(
+        uint64_t seed) const
+    {
+      // the accelerator bounds all timesteps
+      return hashData(timestepsData.ptr, seed);
+    }
+
+    template <int W>
+    void TemporalStructuredRegularVolume<W>::destroyTimesteps()
+    {
+      for (void *timestepEquivalent : timestepEquivalents) {
+        ispc::SharedStructuredVolume_Destructor(timestepEquivalent);
+      }
+
+      timestepEquivalents.clear();
+    }
+
+    VKL_REGISTER_VOLUME(TemporalStructuredRegularVolume<4>,
+                        structured_regular_temporal_4)
+    VKL_REGISTER_VOLUME(TemporalStructuredRegularVolume<8>,
+                        structured_regular_temporal_8)
+    VKL_REGISTER_VOLUME(TemporalStructuredRegularVolume<16>,
+                        structured_regular_temporal_16)
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
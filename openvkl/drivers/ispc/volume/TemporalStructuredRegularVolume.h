@@ -0,0 +1,59 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <vector>
+#include "StructuredRegularVolume.h"
+#include "ospcommon/memory/RefCount.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // structured regular volume over a series of timesteps, each holding the
+    // voxels of the whole grid. sampling interpolates linearly between the two
+    // timesteps nearest to the time parameter (or an explicit time); a single
+    // accelerator bounds the values of all timesteps, so iterators are valid
+    // at any time.
+    template <int W>
+    struct TemporalStructuredRegularVolume : public StructuredRegularVolume<W>
+    {
+      ~TemporalStructuredRegularVolume();
+
+      void commit() override;
+
+      void computeSampleTime(const vvec3fn<1> &objectCoordinates,
+                             float time,
+                             vfloatn<1> &sample) const override;
+
+     protected:
+      uint64_t hashVoxelData(uint64_t seed) const override;
+
+     private:
+      void destroyTimesteps();
+
+      // the timesteps array of the last commit; also keeps the timesteps
+      // themselves alive
+      ospcommon::memory::Ref<Data> timestepsData;
+
+      // one ISPC-side volume per timestep, attached to ispcEquivalent
+      std::vector<void *> timestepEquivalents;
+
+      float time{0.f};
+    };
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
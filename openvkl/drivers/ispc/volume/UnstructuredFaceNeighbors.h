@@ -0,0 +1,150 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "openvkl/openvkl.h"
+#include "ospcommon/tasking/parallel_for.h"
+
+namespace openvkl {
+  namespace ispc_driver {
+
+    // Find the cell sharing each face of each cell of an unstructured mesh.
+    // cellType(c) returns the VKLUnstructuredCellType of cell c, and
+    // vertexId(c, i) the global ID of local vertex i of cell c. The result
+    // holds 6 entries per cell, with faces in the order of the face normals
+    // of UnstructuredVolume; faces on the boundary are -1.
+    template <typename CellTypeFunc, typename VertexIdFunc>
+    inline std::vector<uint64_t> computeFaceNeighbors(uint64_t nCells,
+                                                      CellTypeFunc cellType,
+                                                      VertexIdFunc vertexId)
+    {
+      // local vertices of each face; triangles are marked by noVertex in
+      // their last slot
+      constexpr uint32_t noVertex = uint32_t(-1);
+
+      const uint32_t tetrahedronFaces[4][4] = {{0, 1, 2, noVertex},
+                                               {0, 1, 3, noVertex},
+                                               {1, 2, 3, noVertex},
+                                               {0, 2, 3, noVertex}};
+      const uint32_t hexahedronFaces[6][4] = {{0, 1, 2, 3},
+                                              {0, 1, 5, 4},
+                                              {1, 2, 6, 5},
+                                              {2, 3, 7, 6},
+                                              {0, 3, 7, 4},
+                                              {4, 5, 6, 7}};
+      const uint32_t wedgeFaces[5][4]   = {{0, 1, 2, noVertex},
+                                         {0, 1, 4, 3},
+                                         {1, 2, 5, 4},
+                                         {0, 2, 5, 3},
+                                         {3, 4, 5, noVertex}};
+      const uint32_t pyramidFaces[5][4] = {{0, 1, 2, 3},
+                                           {0, 1, 4, noVertex},
+                                           {1, 2, 4, noVertex},
+                                           {2, 3, 4, noVertex},
+                                           {0, 3, 4, noVertex}};
+
+      // faces are keyed by their sorted vertex IDs, followed by triangleKey
+      // for triangles. keys of unused face slots start with unusedKey, so
+      // they sort last, and are unique per cell face
+      constexpr uint64_t triangleKey = uint64_t(-2);
+      constexpr uint64_t unusedKey   = uint64_t(-1);
+
+      // a face, identified by its key, and the cell face it belongs to
+      // (cell ID * 6 + face)
+      struct Face
+      {
+        std::array<uint64_t, 4> vertices;
+        uint64_t cellFace;
+
+        bool operator<(const Face &other) const
+        {
+          return vertices < other.vertices;
+        }
+      };
+
+      std::vector<uint64_t> faceNeighbors(nCells * 6, uint64_t(-1));
+
+      std::vector<Face> faces(nCells * 6);
+
+      ospcommon::tasking::parallel_for(nCells, [&](uint64_t taskIndex) {
+        const uint32_t(*cellFaces)[4] = nullptr;
+        uint32_t numFaces             = 0;
+
+        switch (cellType(taskIndex)) {
+        case VKL_TETRAHEDRON:
+          cellFaces = tetrahedronFaces;
+          numFaces  = 4;
+          break;
+        case VKL_HEXAHEDRON:
+          cellFaces = hexahedronFaces;
+          numFaces  = 6;
+          break;
+        case VKL_WEDGE:
+          cellFaces = wedgeFaces;
+          numFaces  = 5;
+          break;
+        case VKL_PYRAMID:
+          cellFaces = pyramidFaces;
+          numFaces  = 5;
+          break;
+        }
+
+        for (uint32_t f = 0; f < 6; f++) {
+          Face &face    = faces[taskIndex * 6 + f];
+          face.cellFace = taskIndex * 6 + f;
+
+          if (f >= numFaces) {
+            face.vertices = {unusedKey, unusedKey, taskIndex, f};
+            continue;
+          }
+
+          const bool triangle = cellFaces[f][3] == noVertex;
+          const int faceSize  = triangle ? 3 : 4;
+
+          for (int i = 0; i < faceSize; i++)
+            face.vertices[i] = vertexId(taskIndex, cellFaces[f][i]);
+
+          std::sort(face.vertices.begin(), face.vertices.begin() + faceSize);
+
+          if (triangle)
+            face.vertices[3] = triangleKey;
+        }
+      });
+
+      // faces shared by two cells are adjacent after sorting
+      std::sort(faces.begin(), faces.end());
+
+      for (size_t i = 0; i + 1 < faces.size(); i++) {
+        if (faces[i].vertices[0] == unusedKey)
+          break;
+
+        if (faces[i].vertices == faces[i + 1].vertices) {
+          faceNeighbors[faces[i].cellFace]     = faces[i + 1].cellFace / 6;
+          faceNeighbors[faces[i + 1].cellFace] = faces[i].cellFace / 6;
+          i++;
+        }
+      }
+
+      return faceNeighbors;
+    }
+
+  }  // namespace ispc_driver
+}  // namespace openvkl
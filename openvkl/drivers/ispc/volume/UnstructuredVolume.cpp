@@ -15,8 +15,11 @@
 // ======================================================================== //
 
 #include "UnstructuredVolume.h"
+#include "UnstructuredFaceNeighbors.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "../common/Data.h"
-#include "ospcommon/containers/AlignedVector.h"
 #include "ospcommon/tasking/parallel_for.h"
 
 // Map cell type to its vertices count
@@ -40,43 +43,393 @@ inline uint32_t getVerticesCount(uint8_t cellType)
 namespace openvkl {
   namespace ispc_driver {
 
+    // value ranges in inner nodes are stored as half floats
+
+    static float halfToFloat(uint16_t h)
+    {
+      const uint32_t exponent = (h >> 10) & 0x1f;
+      const uint32_t mantissa = h & 0x3ff;
+
+      float f;
+
+      if (exponent == 0)
+        f = std::ldexp(float(mantissa), -24);
+      else if (exponent == 0x1f)
+        f = mantissa ? std::numeric_limits<float>::quiet_NaN()
+                     : std::numeric_limits<float>::infinity();
+      else
+        f = std::ldexp(float(mantissa | 0x400), int(exponent) - 25);
+
+      return (h & 0x8000) ? -f : f;
+    }
+
+    // the nearest half float to f towards +inf if roundUp, or towards -inf
+    // otherwise; NaN becomes the infinity in that direction
+    static uint16_t floatToHalf(float f, bool roundUp)
+    {
+      if (std::isnan(f))
+        return roundUp ? 0x7c00 : 0xfc00;
+
+      const float a = std::fabs(f);
+
+      // magnitude rounded towards zero
+      uint16_t h;
+
+      if (std::isinf(a)) {
+        h = 0x7c00;
+      } else if (a >= 65504.f) {
+        h = 0x7bff;
+      } else if (a < std::ldexp(1.f, -14)) {
+        h = uint16_t(a * std::ldexp(1.f, 24));
+      } else {
+        int e;
+        const float m = std::frexp(a, &e);
+        h = uint16_t(((e + 14) << 10) | uint16_t((2.f * m - 1.f) * 1024.f));
+      }
+
+      if (f < 0.f)
+        h |= 0x8000;
+
+      // moving away from zero by one step increments the magnitude bits
+      if (halfToFloat(h) != f && (f < 0.f) != roundUp)
+        h++;
+
+      return h;
+    }
+
+    // bound v quantized to 16 bits relative to origin and scale, rounded
+    // down for lower bounds and up for upper bounds. the dequantized bound
+    // is checked, so that rounding errors are corrected for; the traversal
+    // pads the bounds for its own rounding (dequantizeBounds())
+    static uint16_t quantizeBound(float v,
+                                  float origin,
+                                  float scale,
+                                  bool roundUp)
+    {
+      if (scale == 0.f)
+        return 0;
+
+      const float q = (v - origin) / scale;
+      int i = int(roundUp ? std::ceil(q) : std::floor(q));
+      i     = std::max(0, std::min(i, 0xffff));
+
+      if (roundUp) {
+        while (i < 0xffff && origin + float(i) * scale < v)
+          i++;
+      } else {
+        while (i > 0 && origin + float(i) * scale > v)
+          i--;
+      }
+
+      return i;
+    }
+
     static void tabIndent(int indent)
     {
       for (int i = 0; i < indent; i++)
         std::cerr << "\t";
     }
 
-    static void dumpBVH(Node *root, int indent = 0)
+    template <int N>
+    static void dumpBVH(const uint8_t *nodes, uint64_t offset, int indent = 0)
     {
+      auto root = (const Node *)(nodes + offset);
       if (root->nominalLength < 0) {
-        auto leaf = (LeafNode *)root;
+        auto leaf = (const LeafNode *)root;
         tabIndent(indent);
-        std::cerr << "id: " << leaf->cellID << " bounds: " << leaf->bounds
-                  << " range: " << leaf->valueRange
-                  << " nom: " << leaf->nominalLength << std::endl;
+        std::cerr << "ids:";
+        for (uint32_t i = 0; i < leaf->numCells; i++)
+          std::cerr << " " << leaf->cellIDs[i];
+        std::cerr << " nom: " << leaf->nominalLength << std::endl;
       } else {
-        auto inner = (InnerNode *)root;
+        auto inner = (const InnerNode<N> *)root;
         tabIndent(indent);
-        std::cerr << "range: " << inner->valueRange
-                  << " nom: " << inner->nominalLength << std::endl;
+        std::cerr << "nom: " << inner->nominalLength << std::endl;
 
-        tabIndent(indent);
-        std::cerr << "bounds[0]: " << inner->bounds[0] << std::endl;
-        dumpBVH(inner->children[0], indent + 1);
+        for (int i = 0; i < N; i++) {
+          if (!inner->childOffsets[i])
+            continue;
 
-        tabIndent(indent);
-        std::cerr << "bounds[1]: " << inner->bounds[1] << std::endl;
-        dumpBVH(inner->children[1], indent + 1);
+          tabIndent(indent);
+          std::cerr << "bounds[" << i << "]: " << inner->getChildBounds(i)
+                    << " range[" << i
+                    << "]: " << halfToFloat(inner->valueLower[i]) << " "
+                    << halfToFloat(inner->valueUpper[i]) << std::endl;
+          dumpBVH<N>(nodes,
+                     uint64_t(inner->childOffsets[i]) * bvhNodeAlignment,
+                     indent + 1);
+        }
       }
     }
 
+    template <int N>
+    static size_t flatBVHSize(const BuildNode *node)
+    {
+      if (node->nominalLength < 0)
+        return LeafNode::byteSize(((const BuildLeafNode *)node)->numCells);
+
+      auto inner  = (const BuildInnerNode<N> *)node;
+      size_t size = InnerNode<N>::byteSize();
+
+      for (int i = 0; i < N; i++) {
+        if (inner->children[i])
+          size += flatBVHSize<N>(inner->children[i]);
+      }
+
+      return size;
+    }
+
+    // write the subtree at node, at the given depth, to nodes + end in
+    // depth-first order, advancing end; returns the offset of its root
+    template <int N>
+    static uint64_t flattenNode(const BuildNode *node,
+                                uint8_t *nodes,
+                                unsigned int depth,
+                                uint64_t &end)
+    {
+      // the sampling traversal stack is sized for bvhMaxDepth
+      if (depth > bvhMaxDepth) {
+        throw std::runtime_error("unstructured volume BVH is too deep");
+      }
+
+      const uint64_t offset = end;
+
+      if (node->nominalLength < 0) {
+        auto buildLeaf = (const BuildLeafNode *)node;
+        auto leaf      = new (nodes + offset) LeafNode;
+
+        leaf->nominalLength = buildLeaf->nominalLength;
+        leaf->numCells      = buildLeaf->numCells;
+        std::copy(buildLeaf->cellIDs,
+                  buildLeaf->cellIDs + buildLeaf->numCells,
+                  leaf->cellIDs);
+
+        end += LeafNode::byteSize(buildLeaf->numCells);
+        return offset;
+      }
+
+      auto buildInner = (const BuildInnerNode<N> *)node;
+      auto inner      = new (nodes + offset) InnerNode<N>;
+      end += InnerNode<N>::byteSize();
+
+      inner->nominalLength = buildInner->nominalLength;
+
+      box3f innerBounds = empty;
+      for (int i = 0; i < N; i++) {
+        if (buildInner->children[i])
+          innerBounds.extend(box3f(buildInner->bounds[i].lower,
+                                   buildInner->bounds[i].upper));
+      }
+
+      // the largest quantized value must reach the upper bound
+      inner->origin = innerBounds.lower;
+      inner->scale  = (innerBounds.upper - innerBounds.lower) / 65535.f;
+
+      for (int d = 0; d < 3; d++) {
+        while (inner->origin[d] + 65535.f * inner->scale[d] <
+               innerBounds.upper[d]) {
+          inner->scale[d] = std::nextafter(
+              inner->scale[d], std::numeric_limits<float>::infinity());
+        }
+      }
+
+      for (int i = 0; i < N; i++) {
+        const BuildNode *child = buildInner->children[i];
+
+        if (!child) {
+          inner->lowerX[i] = inner->lowerY[i] = inner->lowerZ[i] = 0xffff;
+          inner->upperX[i] = inner->upperY[i] = inner->upperZ[i] = 0;
+          inner->valueLower[i]   = floatToHalf(inf, false);
+          inner->valueUpper[i]   = floatToHalf(neg_inf, true);
+          inner->childOffsets[i] = 0;
+          continue;
+        }
+
+        const box3fa &b = buildInner->bounds[i];
+        const vec3f &o  = inner->origin;
+        const vec3f &s  = inner->scale;
+
+        inner->lowerX[i] = quantizeBound(b.lower.x, o.x, s.x, false);
+        inner->lowerY[i] = quantizeBound(b.lower.y, o.y, s.y, false);
+        inner->lowerZ[i] = quantizeBound(b.lower.z, o.z, s.z, false);
+        inner->upperX[i] = quantizeBound(b.upper.x, o.x, s.x, true);
+        inner->upperY[i] = quantizeBound(b.upper.y, o.y, s.y, true);
+        inner->upperZ[i] = quantizeBound(b.upper.z, o.z, s.z, true);
+
+        inner->valueLower[i] = floatToHalf(child->valueRange.lower, false);
+        inner->valueUpper[i] = floatToHalf(child->valueRange.upper, true);
+
+        inner->childOffsets[i] =
+            flattenNode<N>(child, nodes, depth + 1, end) / bvhNodeAlignment;
+      }
+
+      return offset;
+    }
+
+    template <int N>
+    static void flattenBVH(const BuildNode *root,
+                           containers::AlignedVector<uint8_t> &nodes)
+    {
+      const size_t size = flatBVHSize<N>(root);
+
+      if (size / bvhNodeAlignment > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("unstructured volume BVH is too large");
+      }
+
+      nodes.resize(size);
+
+      uint64_t end = 0;
+      flattenNode<N>(root, nodes.data(), 0, end);
+    }
+
+    template <int N>
+    static void setInnerNodeCallbacks(RTCBuildArguments &arguments)
+    {
+      arguments.createNode      = BuildInnerNode<N>::create;
+      arguments.setNodeChildren = BuildInnerNode<N>::setChildren;
+      arguments.setNodeBounds   = BuildInnerNode<N>::setBounds;
+    }
+
+    template <int N>
+    static box3f buildNodeBounds(const BuildNode *node)
+    {
+      if (node->nominalLength < 0) {
+        auto &val = ((const BuildLeafNode *)node)->bounds;
+        return box3f(val.lower, val.upper);
+      }
+
+      auto inner   = (const BuildInnerNode<N> *)node;
+      box3f bounds = empty;
+
+      for (int i = 0; i < N; i++) {
+        if (inner->children[i])
+          bounds.extend(box3f(inner->bounds[i].lower, inner->bounds[i].upper));
+      }
+
+      return bounds;
+    }
+
+    // the subtrees below this many nodes of a level are refit in parallel
+    static constexpr size_t refitParallelNodes = 1024;
+
+    // recompute the value ranges in the subtree at offset from those of the
+    // cells in its leaves, bottom-up; returns the value range of the subtree.
+    // numLevelNodes is the number of nodes on the level of this node in a
+    // full tree
+    template <int N, typename CellValueRange>
+    static range1f refitNode(uint8_t *nodes,
+                             uint64_t offset,
+                             size_t numLevelNodes,
+                             const CellValueRange &cellValueRange)
+    {
+      auto node = (Node *)(nodes + offset);
+
+      if (node->nominalLength < 0) {
+        auto leaf         = (const LeafNode *)node;
+        range1f leafRange = empty;
+
+        for (uint32_t i = 0; i < leaf->numCells; i++)
+          leafRange.extend(cellValueRange(leaf->cellIDs[i]));
+
+        return leafRange;
+      }
+
+      auto inner = (InnerNode<N> *)node;
+
+      range1f childRanges[N];
+
+      auto refitChild = [&](size_t i) {
+        if (inner->childOffsets[i]) {
+          childRanges[i] = refitNode<N>(
+              nodes,
+              uint64_t(inner->childOffsets[i]) * bvhNodeAlignment,
+              numLevelNodes * N,
+              cellValueRange);
+        }
+      };
+
+      if (numLevelNodes < refitParallelNodes) {
+        tasking::parallel_for(N, refitChild);
+      } else {
+        for (int i = 0; i < N; i++)
+          refitChild(i);
+      }
+
+      range1f innerRange = empty;
+
+      for (int i = 0; i < N; i++) {
+        if (!inner->childOffsets[i])
+          continue;
+
+        inner->valueLower[i] = floatToHalf(childRanges[i].lower, false);
+        inner->valueUpper[i] = floatToHalf(childRanges[i].upper, true);
+        innerRange.extend(childRanges[i]);
+      }
+
+      return innerRange;
+    }
+
+    // whether the subtree at end is laid out as by flattenNode() within the
+    // numBytes of nodes, no deeper than bvhMaxDepth and with leaves only
+    // referencing cells below nCells, advancing end past it. this guards
+    // BVHs mapped from an accelerator cache, which may be corrupt
+    template <int N>
+    static bool validNode(const uint8_t *nodes,
+                          size_t numBytes,
+                          uint64_t nCells,
+                          unsigned int depth,
+                          uint64_t &end)
+    {
+      const uint64_t offset = end;
+
+      if (depth > bvhMaxDepth || numBytes - offset < LeafNode::byteSize(1))
+        return false;
+
+      auto node = (const Node *)(nodes + offset);
+
+      if (node->nominalLength < 0) {
+        auto leaf = (const LeafNode *)node;
+
+        if (leaf->numCells == 0 ||
+            LeafNode::byteSize(leaf->numCells) > numBytes - offset)
+          return false;
+
+        for (uint32_t i = 0; i < leaf->numCells; i++) {
+          if (leaf->cellIDs[i] >= nCells)
+            return false;
+        }
+
+        end += LeafNode::byteSize(leaf->numCells);
+        return true;
+      }
+
+      if (InnerNode<N>::byteSize() > numBytes - offset)
+        return false;
+
+      auto inner = (const InnerNode<N> *)node;
+      end += InnerNode<N>::byteSize();
+
+      // children follow their parent in order, each after the subtree of
+      // the previous one
+      for (int i = 0; i < N; i++) {
+        if (!inner->childOffsets[i])
+          continue;
+
+        if (uint64_t(inner->childOffsets[i]) * bvhNodeAlignment != end ||
+            !validNode<N>(nodes, numBytes, nCells, depth + 1, end))
+          return false;
+      }
+
+      return true;
+    }
+
     template <int W>
     UnstructuredVolume<W>::~UnstructuredVolume()
     {
-      if (rtcBVH)
-        rtcReleaseBVH(rtcBVH);
-      if (rtcDevice)
-        rtcReleaseDevice(rtcDevice);
+      if (hintedCellWalks > 0)
+        postLogMessage(VKL_LOG_DEBUG)
+            << "unstructured volume found " << hintedCellWalks
+            << " hinted samples by walking cells";
     }
 
     template <int W>
@@ -99,8 +452,9 @@ namespace openvkl {
           "cell.index", nullptr);
       cellValue = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
           "cell.data", nullptr);
-      cellType = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
-          "cell.type", nullptr);
+      Data *cellTypeParam =
+          (Data *)this->template getParam<ManagedObject::VKL_PTR>("cell.type",
+                                                                  nullptr);
 
       if (!vertexPosition) {
         throw std::runtime_error(
@@ -116,7 +470,8 @@ namespace openvkl {
         throw std::runtime_error(
             "unstructured volume must have 'vertex.data' or 'cell.data'");
       }
-      if ((!indexPrefixed && !cellType) || (indexPrefixed && cellType)) {
+      if ((!indexPrefixed && !cellTypeParam) ||
+          (indexPrefixed && cellTypeParam)) {
         throw std::runtime_error(
             "unstructured volume must have one of 'cell.type' or "
             "'indexPrefixed'");
@@ -149,11 +504,31 @@ namespace openvkl {
       }
       nCells = cellIndex->size();
 
-      if (cellType) {
+      hexIterative = this->template getParam<bool>("hexIterative", false);
+
+      bvhWidth = this->template getParam<int>("bvhWidth", 2);
+      if (bvhWidth != 2 && bvhWidth != 4 && bvhWidth != 8) {
+        throw std::runtime_error(
+            "unstructured volume 'bvhWidth' must be 2, 4 or 8");
+      }
+
+      bvhLeafSize = this->template getParam<int>("bvhLeafSize", 1);
+      if (bvhLeafSize < 1 || bvhLeafSize > 32) {
+        throw std::runtime_error(
+            "unstructured volume 'bvhLeafSize' must be in [1, 32]");
+      }
+
+      // when only the values changed, the BVH is refit rather than rebuilt,
+      // and the cell types derived from the index are kept
+      const uint64_t newGeometryHash = hashGeometry(cellTypeParam);
+      const bool valuesOnly          = geometryUnchanged(newGeometryHash);
+
+      if (cellTypeParam) {
+        cellType = cellTypeParam;
         if (nCells != cellType->size())
           throw std::runtime_error(
               "unstructured volume #cells does not match #cell.type");
-      } else {
+      } else if (!valuesOnly) {
         cellType = new Data(nCells, VKL_UCHAR, nullptr, VKL_DATA_DEFAULT);
         uint8_t *typeArray = (uint8_t *)cellType->data;
         for (int i = 0; i < nCells; i++) {
@@ -179,20 +554,25 @@ namespace openvkl {
         }
       }
 
-      hexIterative = this->template getParam<bool>("hexIterative", false);
+      // tolerances, normals and neighbors depend on the geometry only
+      if (!valuesOnly) {
+        iterativeTolerance.clear();
+        faceNormals.clear();
+        faceNeighbors.clear();
 
-      bool needTolerances = false;
-      for (int i = 0; i < nCells; i++) {
-        auto cell = ((uint8_t *)cellType->data)[i];
-        if (cell == VKL_WEDGE || cell == VKL_PYRAMID ||
-            (cell == VKL_HEXAHEDRON && hexIterative)) {
-          needTolerances = true;
-          break;
+        bool needTolerances = false;
+        for (int i = 0; i < nCells; i++) {
+          auto cell = ((uint8_t *)cellType->data)[i];
+          if (cell == VKL_WEDGE || cell == VKL_PYRAMID ||
+              (cell == VKL_HEXAHEDRON && hexIterative)) {
+            needTolerances = true;
+            break;
+          }
         }
-      }
 
-      if (needTolerances)
-        calculateIterativeTolerance();
+        if (needTolerances)
+          calculateIterativeTolerance();
+      }
 
       auto precompute =
           this->template getParam<bool>("precomputedNormals", false);
@@ -207,7 +587,27 @@ namespace openvkl {
         }
       }
 
-      buildBvhAndCalculateBounds();
+      auto precomputeNeighbors =
+          this->template getParam<bool>("precomputedNeighbors", false);
+      if (precomputeNeighbors) {
+        if (faceNeighbors.empty()) {
+          calculateFaceNeighbors();
+        }
+      } else {
+        if (!faceNeighbors.empty()) {
+          faceNeighbors.clear();
+          faceNeighbors.shrink_to_fit();
+        }
+      }
+
+      if (valuesOnly) {
+        postLogMessage(VKL_LOG_DEBUG)
+            << "refitting unstructured volume BVH to new values";
+        refitBVH();
+      } else {
+        buildBvhAndCalculateBounds();
+        setGeometry(newGeometryHash);
+      }
 
       if (!this->ispcEquivalent) {
         this->ispcEquivalent = ispc::VKLUnstructuredVolume_Constructor();
@@ -225,9 +625,13 @@ namespace openvkl {
           cell32Bit,
           indexPrefixed,
           (const uint8_t *)cellType->data,
-          (void *)(rtcRoot),
+          nCells,
+          (void *)(bvhNodes),
+          bvhWidth,
+          (const ispc::box1f &)valueRange,
           faceNormals.empty() ? nullptr
                               : (const ispc::vec3f *)faceNormals.data(),
+          faceNeighbors.empty() ? nullptr : faceNeighbors.data(),
           iterativeTolerance.empty() ? nullptr : iterativeTolerance.data(),
           hexIterative);
     }
@@ -261,6 +665,27 @@ namespace openvkl {
       return bBox;
     }
 
+    template <int W>
+    range1f UnstructuredVolume<W>::getCellValueRange(uint64_t id) const
+    {
+      if (cellValue) {
+        const float value = ((const float *)(cellValue->data))[id];
+        return range1f(value, value);
+      }
+
+      const uint64_t cOffset = getCellOffset(id);
+      const uint32_t maxIdx =
+          getVerticesCount(((const uint8_t *)(cellType->data))[id]);
+
+      range1f range = empty;
+      for (uint32_t i = 0; i < maxIdx; i++) {
+        const uint64_t vId = getVertexId(cOffset + i);
+        range.extend(((const float *)(vertexValue->data))[vId]);
+      }
+
+      return range;
+    }
+
     void errorFunction(void *userPtr, enum RTCError error, const char *str)
     {
       LogMessageStream(VKL_LOG_WARNING)
@@ -270,72 +695,269 @@ namespace openvkl {
     template <int W>
     void UnstructuredVolume<W>::buildBvhAndCalculateBounds()
     {
-      rtcDevice = rtcNewDevice(NULL);
-      if (!rtcDevice) {
-        throw std::runtime_error("cannot create device");
+      if (!loadBVH()) {
+        RTCDevice rtcDevice = rtcNewDevice(NULL);
+        if (!rtcDevice) {
+          throw std::runtime_error("cannot create device");
+        }
+        rtcSetDeviceErrorFunction(rtcDevice, errorFunction, NULL);
+
+        containers::AlignedVector<RTCBuildPrimitive> prims;
+        containers::AlignedVector<range1f> range;
+        prims.resize(nCells);
+        range.resize(nCells);
+
+        tasking::parallel_for(nCells, [&](uint64_t taskIndex) {
+          box4f bound              = getCellBBox(taskIndex);
+          prims[taskIndex].lower_x = bound.lower.x;
+          prims[taskIndex].lower_y = bound.lower.y;
+          prims[taskIndex].lower_z = bound.lower.z;
+          prims[taskIndex].geomID  = taskIndex >> 32;
+          prims[taskIndex].upper_x = bound.upper.x;
+          prims[taskIndex].upper_y = bound.upper.y;
+          prims[taskIndex].upper_z = bound.upper.z;
+          prims[taskIndex].primID  = taskIndex & 0xffffffff;
+          range[taskIndex]         = range1f(bound.lower.w, bound.upper.w);
+        });
+
+        RTCBVH rtcBVH = rtcNewBVH(rtcDevice);
+        if (!rtcBVH) {
+          rtcReleaseDevice(rtcDevice);
+          throw std::runtime_error("bvh creation failure");
+        }
+
+        RTCBuildArguments arguments      = rtcDefaultBuildArguments();
+        arguments.byteSize               = sizeof(arguments);
+        arguments.buildFlags             = RTC_BUILD_FLAG_NONE;
+        arguments.buildQuality           = RTC_BUILD_QUALITY_MEDIUM;
+        arguments.maxBranchingFactor     = bvhWidth;
+        arguments.maxDepth               = bvhMaxDepth;
+        arguments.sahBlockSize           = 1;
+        arguments.minLeafSize            = 1;
+        arguments.maxLeafSize            = bvhLeafSize;
+        arguments.traversalCost          = 1.0f;
+        arguments.intersectionCost       = 10.0f;
+        arguments.bvh                    = rtcBVH;
+        arguments.primitives             = prims.data();
+        arguments.primitiveCount         = prims.size();
+        arguments.primitiveArrayCapacity = prims.size();
+        arguments.createLeaf             = BuildLeafNode::create;
+        arguments.splitPrimitive         = nullptr;
+        arguments.buildProgress          = nullptr;
+        arguments.userPtr                = range.data();
+
+        switch (bvhWidth) {
+        case 4:
+          setInnerNodeCallbacks<4>(arguments);
+          break;
+        case 8:
+          setInnerNodeCallbacks<8>(arguments);
+          break;
+        default:
+          setInnerNodeCallbacks<2>(arguments);
+        }
+
+        BuildNode *buildRoot = (BuildNode *)rtcBuildBVH(&arguments);
+
+        // release the primitives before the BVH is flattened, to lower peak
+        // memory use
+        containers::AlignedVector<RTCBuildPrimitive>().swap(prims);
+        containers::AlignedVector<range1f>().swap(range);
+
+        if (buildRoot) {
+          flattenBVH(buildRoot);
+        }
+
+        // the flattened copy does not refer to the Embree nodes
+        rtcReleaseBVH(rtcBVH);
+        rtcReleaseDevice(rtcDevice);
+
+        if (!buildRoot) {
+          throw std::runtime_error("bvh build failure");
+        }
+      }
+    }
+
+    template <int W>
+    void UnstructuredVolume<W>::flattenBVH(const BuildNode *buildRoot)
+    {
+      acceleratorCache.reset();
+
+      switch (bvhWidth) {
+      case 4:
+        bounds = buildNodeBounds<4>(buildRoot);
+        ispc_driver::flattenBVH<4>(buildRoot, flatBVH);
+        break;
+      case 8:
+        bounds = buildNodeBounds<8>(buildRoot);
+        ispc_driver::flattenBVH<8>(buildRoot, flatBVH);
+        break;
+      default:
+        bounds = buildNodeBounds<2>(buildRoot);
+        ispc_driver::flattenBVH<2>(buildRoot, flatBVH);
       }
-      rtcSetDeviceErrorFunction(rtcDevice, errorFunction, NULL);
 
-      containers::AlignedVector<RTCBuildPrimitive> prims;
-      containers::AlignedVector<range1f> range;
-      prims.resize(nCells);
-      range.resize(nCells);
+      valueRange = buildRoot->valueRange;
 
-      tasking::parallel_for(nCells, [&](uint64_t taskIndex) {
-        box4f bound              = getCellBBox(taskIndex);
-        prims[taskIndex].lower_x = bound.lower.x;
-        prims[taskIndex].lower_y = bound.lower.y;
-        prims[taskIndex].lower_z = bound.lower.z;
-        prims[taskIndex].geomID  = taskIndex >> 32;
-        prims[taskIndex].upper_x = bound.upper.x;
-        prims[taskIndex].upper_y = bound.upper.y;
-        prims[taskIndex].upper_z = bound.upper.z;
-        prims[taskIndex].primID  = taskIndex & 0xffffffff;
-        range[taskIndex]         = range1f(bound.lower.w, bound.upper.w);
-      });
+      bvhNodes = flatBVH.data();
+      bvhBytes = flatBVH.size();
+    }
 
-      rtcBVH = rtcNewBVH(rtcDevice);
-      if (!rtcBVH) {
-        throw std::runtime_error("bvh creation failure");
-      }
-
-      RTCBuildArguments arguments      = rtcDefaultBuildArguments();
-      arguments.byteSize               = sizeof(arguments);
-      arguments.buildFlags             = RTC_BUILD_FLAG_NONE;
-      arguments.buildQuality           = RTC_BUILD_QUALITY_MEDIUM;
-      arguments.maxBranchingFactor     = 2;
-      arguments.maxDepth               = 1024;
-      arguments.sahBlockSize           = 1;
-      arguments.minLeafSize            = 1;
-      arguments.maxLeafSize            = 1;
-      arguments.traversalCost          = 1.0f;
-      arguments.intersectionCost       = 10.0f;
-      arguments.bvh                    = rtcBVH;
-      arguments.primitives             = prims.data();
-      arguments.primitiveCount         = prims.size();
-      arguments.primitiveArrayCapacity = prims.size();
-      arguments.createNode             = InnerNode::create;
-      arguments.setNodeChildren        = InnerNode::setChildren;
-      arguments.setNodeBounds          = InnerNode::setBounds;
-      arguments.createLeaf             = LeafNode::create;
-      arguments.splitPrimitive         = nullptr;
-      arguments.buildProgress          = nullptr;
-      arguments.userPtr                = range.data();
-
-      rtcRoot = (Node *)rtcBuildBVH(&arguments);
-      if (!rtcRoot) {
-        throw std::runtime_error("bvh build failure");
-      }
-
-      if (rtcRoot->nominalLength < 0) {
-        auto &val = ((LeafNode *)rtcRoot)->bounds;
-        bounds    = box3f(val.lower, val.upper);
-      } else {
-        auto &vals = ((InnerNode *)rtcRoot)->bounds;
-        bounds     = box3f(vals[0].lower, vals[0].upper);
-        bounds.extend(box3f(vals[1].lower, vals[1].upper));
+    template <int W>
+    bool UnstructuredVolume<W>::geometryUnchanged(uint64_t hash)
+    {
+      return bvhNodes && hash == geometryHash &&
+             this->template getParam<std::string>("acceleratorCache", "") ==
+                 geometryAcceleratorCache;
+    }
+
+    template <int W>
+    void UnstructuredVolume<W>::setGeometry(uint64_t hash)
+    {
+      geometryHash = hash;
+      geometryAcceleratorCache =
+          this->template getParam<std::string>("acceleratorCache", "");
+    }
+
+    template <int W>
+    uint64_t UnstructuredVolume<W>::hashGeometry(
+        const Data *cellTypeParam) const
+    {
+      uint64_t hash = hashData(vertexPosition);
+      hash          = hashData(index, hash);
+      hash          = hashValue(indexPrefixed, hash);
+      hash          = hashData(cellIndex, hash);
+      hash          = hashData(cellTypeParam, hash);
+      hash          = hashValue(hexIterative, hash);
+      hash          = hashValue(bvhWidth, hash);
+      return hashValue(bvhLeafSize, hash);
+    }
+
+    template <int W>
+    void UnstructuredVolume<W>::refitBVH()
+    {
+      // nodes used in place from an accelerator cache are read-only
+      if (acceleratorCache) {
+        postLogMessage(VKL_LOG_DEBUG)
+            << "copying unstructured volume BVH from accelerator cache";
+        flatBVH.resize(bvhBytes);
+        std::copy(bvhNodes, bvhNodes + bvhBytes, flatBVH.data());
+        acceleratorCache.reset();
+
+        bvhNodes = flatBVH.data();
+      }
+
+      auto cellValueRange = [&](uint64_t id) { return getCellValueRange(id); };
+
+      switch (bvhWidth) {
+      case 4:
+        valueRange = refitNode<4>(flatBVH.data(), 0, 1, cellValueRange);
+        break;
+      case 8:
+        valueRange = refitNode<8>(flatBVH.data(), 0, 1, cellValueRange);
+        break;
+      default:
+        valueRange = refitNode<2>(flatBVH.data(), 0, 1, cellValueRange);
+      }
+    }
+
+    template <int W>
+    bool UnstructuredVolume<W>::loadBVH()
+    {
+      const std::string filename =
+          this->template getParam<std::string>("acceleratorCache", "");
+
+      if (filename.empty()) {
+        return false;
+      }
+
+      auto cache =
+          AcceleratorCache::open(filename, "unstructured_bvh", hashBVH());
+
+      if (!cache) {
+        return false;
+      }
+
+      size_t numBytes;
+      const uint8_t *nodes;
+      const box3f *cachedBounds;
+      const range1f *cachedValueRange;
+
+      try {
+        nodes            = cache->template section<uint8_t>(0, numBytes);
+        cachedBounds     = cache->template sectionOfSize<box3f>(1, 1);
+        cachedValueRange = cache->template sectionOfSize<range1f>(2, 1);
+      } catch (const std::runtime_error &e) {
+        LogMessageStream(VKL_LOG_WARNING)
+            << "ignoring corrupt accelerator cache " << filename << ": "
+            << e.what() << std::endl;
+        return false;
+      }
+
+      uint64_t end = 0;
+      bool valid;
+
+      switch (bvhWidth) {
+      case 4:
+        valid = validNode<4>(nodes, numBytes, nCells, 0, end);
+        break;
+      case 8:
+        valid = validNode<8>(nodes, numBytes, nCells, 0, end);
+        break;
+      default:
+        valid = validNode<2>(nodes, numBytes, nCells, 0, end);
+      }
+
+      if (!valid || end != numBytes) {
+        LogMessageStream(VKL_LOG_WARNING)
+            << "ignoring corrupt accelerator cache " << filename << std::endl;
+        return false;
       }
-      valueRange = rtcRoot->valueRange;
+
+      bounds     = *cachedBounds;
+      valueRange = *cachedValueRange;
+
+      // the nodes are used in place from the mapping
+      acceleratorCache = std::move(cache);
+
+      flatBVH.clear();
+
+      bvhNodes = nodes;
+      bvhBytes = numBytes;
+
+      postLogMessage(VKL_LOG_DEBUG) << "using accelerator cache " << filename;
+
+      return true;
+    }
+
+    template <int W>
+    uint64_t UnstructuredVolume<W>::hashBVH() const
+    {
+      uint64_t hash = hashData(vertexPosition);
+      hash          = hashData(index, hash);
+      hash          = hashValue(indexPrefixed, hash);
+      hash          = hashData(cellIndex, hash);
+      hash          = hashData(cellType, hash);
+      hash          = hashData(vertexValue, hash);
+      hash          = hashData(cellValue, hash);
+      hash          = hashValue(bvhWidth, hash);
+      return hashValue(bvhLeafSize, hash);
+    }
+
+    template <int W>
+    void UnstructuredVolume<W>::serializeAccelerator(
+        const std::string &filename) const
+    {
+      if (!bvhNodes) {
+        throw std::runtime_error(
+            "volume must be committed before serializing its accelerator");
+      }
+
+      AcceleratorCacheWriter writer("unstructured_bvh", hashBVH());
+      writer.addSection(bvhNodes, bvhBytes);
+      writer.addSection(&bounds, sizeof(box3f));
+      writer.addSection(&valueRange, sizeof(range1f));
+      writer.write(filename);
     }
 
     template <int W>
@@ -436,6 +1058,19 @@ namespace openvkl {
       });
     }
 
+    template <int W>
+    void UnstructuredVolume<W>::calculateFaceNeighbors()
+    {
+      const uint8_t *typeArray = (const uint8_t *)cellType->data;
+
+      faceNeighbors = computeFaceNeighbors(
+          nCells,
+          [&](uint64_t cellId) { return typeArray[cellId]; },
+          [&](uint64_t cellId, uint32_t vertex) {
+            return getVertexId(getCellOffset(cellId) + vertex);
+          });
+    }
+
     // Calculate all normals for arbitrary polyhedron
     // based on given vertices order
     template <int W>
@@ -16,34 +16,60 @@
 
 #pragma once
 
+#include "../common/AcceleratorCache.h"
 #include "../common/Data.h"
 #include "../common/math.h"
 #include "../iterator/UnstructuredIterator.h"
 #include "UnstructuredVolume_ispc.h"
 #include "Volume.h"
 #include "embree3/rtcore.h"
+#include "ospcommon/containers/AlignedVector.h"
+
+#include <atomic>
 
 namespace openvkl {
   namespace ispc_driver {
 
-    struct Node
+    // nodes of the BVH while Embree builds it. the BVH is of width 2, 4 or 8,
+    // with leaves of one or more cells; once built, it is converted to the
+    // compact layout below
+    struct BuildNode
     {
-      // 1 + 2 float = 3x4 = 18 bytes
-      float nominalLength;  // set to negative for LeafNode;
+      float nominalLength;  // set to negative for BuildLeafNode;
       range1f valueRange;
     };
 
-    struct LeafNode : public Node
+    struct BuildLeafNode : public BuildNode
     {
-      // 18 + 8 + 4 * 6 bytes = 50
       box3fa bounds;
-      uint64_t cellID;
+      uint32_t numCells;
+
+      // numCells cell IDs; leaves with more than one cell are allocated with
+      // room for the others following the node
+      uint64_t cellIDs[1];
 
-      LeafNode(unsigned id, const box3fa &bounds, const range1f &range)
-          : cellID(id), bounds(bounds)
+      BuildLeafNode(const RTCBuildPrimitive *prims,
+                    size_t numPrims,
+                    const range1f *ranges)
+          : numCells(numPrims)
       {
-        nominalLength = -reduce_min(bounds.upper - bounds.lower);
-        valueRange    = range;
+        bounds     = empty;
+        valueRange = empty;
+
+        float minExtent = inf;
+
+        for (size_t i = 0; i < numPrims; i++) {
+          auto id = (uint64_t(prims[i].geomID) << 32) | prims[i].primID;
+          const box3fa &cellBounds = *(const box3fa *)&prims[i];
+
+          cellIDs[i] = id;
+          bounds.extend(cellBounds);
+          valueRange.extend(ranges[id]);
+          minExtent =
+              min(minExtent, reduce_min(cellBounds.upper - cellBounds.lower));
+        }
+
+        nominalLength = -minExtent;
       }
 
       static void *create(RTCThreadLocalAllocator alloc,
@@ -51,35 +77,37 @@ namespace openvkl {
                           size_t numPrims,
                           void *userPtr)
       {
-        assert(numPrims == 1);
-
-        auto id    = (uint64_t(prims->geomID) << 32) | prims->primID;
-        auto range = ((range1f *)userPtr)[id];
-
-        void *ptr = rtcThreadLocalAlloc(alloc, sizeof(LeafNode), 16);
-        return (void *)new (ptr) LeafNode(id, *(const box3fa *)prims, range);
+        const size_t size =
+            sizeof(BuildLeafNode) + (numPrims - 1) * sizeof(uint64_t);
+        void *ptr = rtcThreadLocalAlloc(alloc, size, 16);
+        return (void *)new (ptr)
+            BuildLeafNode(prims, numPrims, (const range1f *)userPtr);
       }
     };
 
-    struct InnerNode : public Node
+    template <int N>
+    struct BuildInnerNode : public BuildNode
     {
-      // 18 + 16 + 2 * 4 * 6 = 82 bytes
-      box3fa bounds[2];
-      Node *children[2];
+      static constexpr int width = N;
 
-      InnerNode()
+      box3fa bounds[N];
+      BuildNode *children[N];
+
+      BuildInnerNode()
       {
-        children[0] = children[1] = nullptr;
-        bounds[0] = bounds[1] = empty;
+        for (int i = 0; i < N; i++) {
+          children[i] = nullptr;
+          bounds[i]   = empty;
+        }
       }
 
       static void *create(RTCThreadLocalAllocator alloc,
                           unsigned int numChildren,
                           void *userPtr)
       {
-        assert(numChildren == 2);
-        void *ptr = rtcThreadLocalAlloc(alloc, sizeof(InnerNode), 16);
-        return (void *)new (ptr) InnerNode;
+        assert(numChildren <= N);
+        void *ptr = rtcThreadLocalAlloc(alloc, sizeof(BuildInnerNode), 16);
+        return (void *)new (ptr) BuildInnerNode;
       }
 
       static void setChildren(void *nodePtr,
@@ -87,15 +115,19 @@ namespace openvkl {
                               unsigned int numChildren,
                               void *userPtr)
       {
-        assert(numChildren == 2);
-        auto innerNode = (InnerNode *)nodePtr;
-        for (size_t i = 0; i < 2; i++)
-          innerNode->children[i] = (Node *)childPtr[i];
-        innerNode->nominalLength =
-            min(fabs(innerNode->children[0]->nominalLength),
-                fabs(innerNode->children[1]->nominalLength));
-        innerNode->valueRange = innerNode->children[0]->valueRange;
-        innerNode->valueRange.extend(innerNode->children[1]->valueRange);
+        assert(numChildren <= N);
+        auto innerNode = (BuildInnerNode *)nodePtr;
+
+        innerNode->nominalLength = inf;
+        innerNode->valueRange    = empty;
+
+        for (size_t i = 0; i < numChildren; i++) {
+          innerNode->children[i] = (BuildNode *)childPtr[i];
+          innerNode->nominalLength =
+              min(innerNode->nominalLength,
+                  fabs(innerNode->children[i]->nominalLength));
+          innerNode->valueRange.extend(innerNode->children[i]->valueRange);
+        }
       }
 
       static void setBounds(void *nodePtr,
@@ -103,16 +135,90 @@ namespace openvkl {
                             unsigned int numChildren,
                             void *userPtr)
       {
-        assert(numChildren == 2);
-        for (size_t i = 0; i < 2; i++)
-          ((InnerNode *)nodePtr)->bounds[i] = *(const box3fa *)bounds[i];
+        assert(numChildren <= N);
+        for (size_t i = 0; i < numChildren; i++)
+          ((BuildInnerNode *)nodePtr)->bounds[i] = *(const box3fa *)bounds[i];
+      }
+    };
+
+    // nodes of the BVH used for sampling and iteration; see
+    // UnstructuredVolume.ih. nodes are stored in depth-first order in a
+    // single relocatable buffer starting with the root, each at a multiple of
+    // bvhNodeAlignment bytes
+    static constexpr size_t bvhNodeAlignment = 8;
+
+    // maximum depth of the BVH, with the root at depth 0. the sampling
+    // traversal stack holds bvhMaxDepth * (N - 1) nodes for width N; must
+    // match BVH_MAX_DEPTH in UnstructuredVolume.ih
+    static constexpr unsigned int bvhMaxDepth = 128;
+
+    inline size_t alignBVHNodeSize(size_t size)
+    {
+      return (size + bvhNodeAlignment - 1) & ~(bvhNodeAlignment - 1);
+    }
+
+    struct Node
+    {
+      float nominalLength;  // set to negative for LeafNode;
+    };
+
+    struct LeafNode : public Node
+    {
+      uint32_t numCells;
+
+      // numCells cell IDs, the others following the node
+      uint64_t cellIDs[1];
+
+      static size_t byteSize(size_t numCells)
+      {
+        return alignBVHNodeSize(sizeof(LeafNode) +
+                                (numCells - 1) * sizeof(uint64_t));
+      }
+    };
+
+    // inner node of width N. the value ranges of the children are kept here
+    // rather than in the children, so that they can be rejected without
+    // being touched; the value range of the root is that of the volume
+    template <int N>
+    struct InnerNode : public Node
+    {
+      static constexpr int width = N;
+
+      // bounds of child i are origin + q * scale for the quantized bounds q,
+      // rounded outward; slots without a child have empty bounds
+      vec3f origin;
+      vec3f scale;
+      uint16_t lowerX[N];
+      uint16_t lowerY[N];
+      uint16_t lowerZ[N];
+      uint16_t upperX[N];
+      uint16_t upperY[N];
+      uint16_t upperZ[N];
+
+      // half floats, rounded outward
+      uint16_t valueLower[N];
+      uint16_t valueUpper[N];
+
+      // offsets from the root in units of bvhNodeAlignment bytes; 0 for
+      // slots without a child
+      uint32_t childOffsets[N];
+
+      static size_t byteSize()
+      {
+        return alignBVHNodeSize(sizeof(InnerNode));
+      }
+
+      box3f getChildBounds(int i) const
+      {
+        return box3f(origin + vec3f(lowerX[i], lowerY[i], lowerZ[i]) * scale,
+                     origin + vec3f(upperX[i], upperY[i], upperZ[i]) * scale);
       }
     };
 
     template <int W>
     struct UnstructuredVolume : public Volume<W>
     {
-      ~UnstructuredVolume();
+      ~UnstructuredVolume() override;
 
       void commit() override;
 
@@ -133,11 +239,22 @@ namespace openvkl {
                           const vvec3fn<W> &objectCoordinates,
                           vfloatn<W> &samples) const override;
 
+      void computeSampleHint(const vvec3fn<1> &objectCoordinates,
+                             uint64_t &hint,
+                             vfloatn<1> &sample) const override;
+
       void computeSampleSegV(const vintn<W> &valid,
                           const vvec3fn<W> &objectCoordinates,
-                          vfloatn<W> &samples, 
+                          vfloatn<W> &samples,
                           uint8 *segmentation) const override;
 
+      void computeSampleStream(size_t count,
+                               const float *x,
+                               const float *y,
+                               const float *z,
+                               int stride,
+                               float *samples) const override;
+
       void computeGradientV(const vintn<W> &valid,
                             const vvec3fn<W> &objectCoordinates,
                             vvec3fn<W> &gradients) const override;
@@ -150,12 +267,42 @@ namespace openvkl {
 
       const Node *getNodeRoot() const
       {
-        return rtcRoot;
+        return (const Node *)bvhNodes;
       }
 
+      void serializeAccelerator(const std::string &filename) const override;
+
      private:
       void buildBvhAndCalculateBounds();
 
+      // hash of the contents of the geometry parameters, so that changes
+      // made in place to shared data are detected as well
+      uint64_t hashGeometry(const Data *cellTypeParam) const;
+
+      // whether the BVH, normals, neighbors and tolerances were derived from
+      // the geometry parameters with the given hash, so that only the values
+      // changed
+      bool geometryUnchanged(uint64_t hash);
+
+      // remember the geometry parameters for geometryUnchanged()
+      void setGeometry(uint64_t hash);
+
+      // recompute the value ranges in the BVH from the current values,
+      // keeping its structure and bounds
+      void refitBVH();
+
+      // convert the Embree BVH at buildRoot into flatBVH, and set bounds and
+      // valueRange from it
+      void flattenBVH(const BuildNode *buildRoot);
+
+      // point bvhNodes at the flattened BVH in the "acceleratorCache"
+      // parameter, if that names a cache matching this volume, and set
+      // bounds and valueRange from it
+      bool loadBVH();
+
+      // hash of everything the BVH is built from
+      uint64_t hashBVH() const;
+
       // Read 32/64-bit integer value from given array
       uint64_t readInteger(const void *array, bool is32Bit, uint64_t id) const;
 
@@ -163,11 +310,16 @@ namespace openvkl {
       uint64_t getCellOffset(uint64_t id) const;
       uint64_t getVertexId(uint64_t id) const;
 
+      range1f getCellValueRange(uint64_t id) const;
+
       void calculateCellNormals(const uint64_t cellId,
                                 const uint32_t faces[6][3],
                                 const uint32_t facesCount);
       void calculateFaceNormals();
 
+      // find the cell sharing each face of each cell
+      void calculateFaceNeighbors();
+
       void calculateTolerance(const uint64_t cellId,
                               const uint32_t edge[][2],
                               const uint32_t count);
@@ -192,12 +344,31 @@ namespace openvkl {
       bool indexPrefixed{false};
       bool hexIterative{false};
 
+      // branching factor of the BVH, and maximum number of cells per leaf
+      int bvhWidth{2};
+      int bvhLeafSize{1};
+
       std::vector<vec3f> faceNormals;
+
+      // 6 per cell, in the order of faceNormals; -1 for faces on the boundary
+      std::vector<uint64_t> faceNeighbors;
       std::vector<float> iterativeTolerance;
 
-      RTCBVH rtcBVH{0};
-      RTCDevice rtcDevice{0};
-      Node *rtcRoot{nullptr};
+      // the compact BVH; either flatBVH or a section of acceleratorCache
+      const uint8_t *bvhNodes{nullptr};
+      size_t bvhBytes{0};
+
+      containers::AlignedVector<uint8_t> flatBVH;
+      std::unique_ptr<AcceleratorCache> acceleratorCache;
+
+      // the geometry parameters of the last commit, by hashGeometry()
+      uint64_t geometryHash{0};
+      // a new cache is loaded even if the geometry is unchanged
+      std::string geometryAcceleratorCache;
+
+      // hinted samples whose cell was found by walking across faces from the
+      // hinted cell; counted with debug logging only
+      mutable std::atomic<size_t> hintedCellWalks{0};
     };
 
     // Inlined definitions ////////////////////////////////////////////////////
@@ -217,13 +388,66 @@ namespace openvkl {
     inline void UnstructuredVolume<W>::computeSampleSegV(
         const vintn<W> &valid,
         const vvec3fn<W> &objectCoordinates,
-        vfloatn<W> &samples, 
+        vfloatn<W> &samples,
         uint8 *segmentation) const
     {
       ispc::VKLUnstructuredVolume_sample_export((const int *)&valid,
                                                 this->ispcEquivalent,
                                                 &objectCoordinates,
                                                 &samples);
+
+      // no label channel; report the background label for all active lanes
+      for (int i = 0; i < W; i++)
+        if (valid[i])
+          segmentation[i] = 0;
+    }
+
+    template <int W>
+    inline void UnstructuredVolume<W>::computeSampleHint(
+        const vvec3fn<1> &objectCoordinates,
+        uint64_t &hint,
+        vfloatn<1> &sample) const
+    {
+      // a single active lane, as in Volume<W>::computeSample()
+      vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
+
+      vintn<W> validW;
+      for (int i = 0; i < W; i++)
+        validW[i] = i == 0 ? 1 : 0;
+
+      ocW.fill_inactive_lanes(validW);
+
+      uint64_t hintsW[W] = {hint};
+      vfloatn<W> samplesW;
+      vintn<W> cellsWalkedW;
+
+      ispc::VKLUnstructuredVolume_sampleHint_export((const int *)&validW,
+                                                    this->ispcEquivalent,
+                                                    &ocW,
+                                                    hintsW,
+                                                    &samplesW,
+                                                    &cellsWalkedW);
+
+      hint      = hintsW[0];
+      sample[0] = samplesW[0];
+
+      // only counted for the debug message on release, so that sampling
+      // does not share a counter across threads otherwise
+      if (cellsWalkedW[0] > 0 && logLevel() <= VKL_LOG_DEBUG)
+        hintedCellWalks++;
+    }
+
+    template <int W>
+    inline void UnstructuredVolume<W>::computeSampleStream(
+        size_t count,
+        const float *x,
+        const float *y,
+        const float *z,
+        int stride,
+        float *samples) const
+    {
+      ispc::VKLUnstructuredVolume_sample_stream_export(
+          this->ispcEquivalent, count, x, y, z, stride, samples);
     }
 
     template <int W>
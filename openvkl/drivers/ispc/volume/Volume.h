@@ -16,12 +16,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "../common/ManagedObject.h"
 #include "../common/objectFactory.h"
 #include "../iterator/DefaultIterator.h"
 #include "../value_selector/ValueSelector.h"
 #include "openvkl/openvkl.h"
 #include "ospcommon/math/box.h"
+#include "ospcommon/tasking/schedule.h"
 
 #define THROW_NOT_IMPLEMENTED                          \
   throw std::runtime_error(std::string(__FUNCTION__) + \
@@ -32,14 +39,81 @@ using namespace ospcommon;
 namespace openvkl {
   namespace ispc_driver {
 
+    template <int W>
+    struct Volume;
+
+    // a query's use of the committed instance of a volume (see
+    // Volume::committedInstance()); counted as a reader of that instance
+    // while alive, unless it is the handle itself
+    template <int W>
+    class CommittedVolume
+    {
+     public:
+      CommittedVolume(Volume<W> *instance, std::atomic<int> *readers)
+          : instance(instance), readers(readers)
+      {
+      }
+
+      CommittedVolume(CommittedVolume &&other)
+          : instance(other.instance), readers(other.readers)
+      {
+        other.readers = nullptr;
+      }
+
+      CommittedVolume(const CommittedVolume &) = delete;
+      CommittedVolume &operator=(const CommittedVolume &) = delete;
+
+      ~CommittedVolume()
+      {
+        if (readers)
+          readers->fetch_sub(1);
+      }
+
+      Volume<W> *operator->() const
+      {
+        return instance;
+      }
+
+      Volume<W> &operator*() const
+      {
+        return *instance;
+      }
+
+     private:
+      Volume<W> *instance;
+      std::atomic<int> *readers;
+    };
+
     template <int W>
     struct Volume : public ManagedObject
     {
-      Volume()                   = default;
-      virtual ~Volume() override = default;
+      Volume() = default;
+      virtual ~Volume() override;
 
       static Volume *createInstance(const std::string &type);
 
+      // asynchronous commits (see vklCommitAsync()) build the new state in a
+      // separate instance of the same type, from a snapshot of the current
+      // parameters, and atomically swap it in once committed. all queries
+      // through the handle go to the committed instance.
+      std::shared_future<void> commitAsync();
+
+      // the committed instance, for the duration of a query. as long as the
+      // handle itself is committed (i.e. until an async commit completes),
+      // this only loads a pointer. otherwise the query counts as a reader of
+      // the current epoch, and swaps wait for the readers of earlier epochs
+      // before releasing the instances they replace. iterators are not
+      // counted once initialized, so an instance returned for an iterator is
+      // kept alive after being swapped out, for up to maxRetiredInstances
+      // further swaps, until the handle is committed synchronously, or
+      // until it is destroyed
+      CommittedVolume<W> committedInstance(bool forIterator = false);
+
+      // a synchronous commit of the handle itself makes it the committed
+      // instance again. it mutates the handle in place, so no queries or
+      // iterators may be in use on the volume at the same time
+      void resetCommittedInstance();
+
       // volumes must provide their own iterator implementations based on
       // their internal acceleration structures.
 
@@ -96,6 +170,26 @@ namespace openvkl {
       virtual void computeSample(const vvec3fn<1> &objectCoordinates,
                                  vfloatn<1> &samples) const;
 
+      // sample at a level of detail, where level 0 is the full resolution and
+      // each further level halves it; volumes without multiple resolutions
+      // ignore lod and use computeSample()
+      virtual void computeSampleLOD(const vvec3fn<1> &objectCoordinates,
+                                    float lod,
+                                    vfloatn<1> &sample) const;
+
+      // sample at a time in [0, 1]; volumes which do not vary in time ignore
+      // time and use computeSample()
+      virtual void computeSampleTime(const vvec3fn<1> &objectCoordinates,
+                                     float time,
+                                     vfloatn<1> &sample) const;
+
+      // sample using and updating hint, which locates the previous sample;
+      // volumes without cells to search for ignore hint and use
+      // computeSample()
+      virtual void computeSampleHint(const vvec3fn<1> &objectCoordinates,
+                                     uint64_t &hint,
+                                     vfloatn<1> &sample) const;
+
       virtual void computeSampleSeg(const vvec3fn<1> &objectCoordinates,
                                  vfloatn<1> &samples, uint8 *segmentation) const;
 
@@ -103,31 +197,276 @@ namespace openvkl {
                                   const vvec3fn<W> &objectCoordinates,
                                   vfloatn<W> &samples) const = 0;
 
+      // as computeSampleV(), additionally writing one segmentation label per
+      // lane into segmentation[0..W-1]
       virtual void computeSampleSegV(const vintn<W> &valid,
-                                  const vvec3fn<W> &objectCoordinates,
-                                  vfloatn<W> &samples, uint8 *segmentation) const = 0;
-
+                                     const vvec3fn<W> &objectCoordinates,
+                                     vfloatn<W> &samples,
+                                     uint8 *segmentation) const = 0;
+
+      // sample count coordinates, where coordinate i is read at offset
+      // i * stride from each of x, y and z. count is bounded by the driver's
+      // stream chunk size. volumes should override this with a single kernel
+      // over the whole stream; the default implementation uses
+      // computeSampleV() on packets of width W.
+      virtual void computeSampleStream(size_t count,
+                                       const float *x,
+                                       const float *y,
+                                       const float *z,
+                                       int stride,
+                                       float *samples) const;
+
+      // march numRays rays at a fixed step dt, writing numSteps samples per
+      // ray in ray-major order, and labels if labels is not null. volumes
+      // should override this with a single kernel over all rays; the default
+      // implementation uses computeSampleSegV() on packets of width W.
+      virtual void sampleRays(size_t numRays,
+                              const vec3f *origins,
+                              const vec3f *directions,
+                              const float *tStart,
+                              float dt,
+                              size_t numSteps,
+                              float *values,
+                              uint8 *labels) const;
 
       virtual void computeGradientV(const vintn<W> &valid,
                                     const vvec3fn<W> &objectCoordinates,
                                     vvec3fn<W> &gradients) const;
 
+      // sample value and gradient at the same coordinates; volumes that can
+      // share work between the two should override this, the default
+      // implementation calls computeSampleV() and computeGradientV()
+      virtual void computeSampleAndGradientV(
+          const vintn<W> &valid,
+          const vvec3fn<W> &objectCoordinates,
+          vfloatn<W> &samples,
+          vvec3fn<W> &gradients) const;
+
       virtual box3f getBoundingBox() const = 0;
 
       virtual range1f getValueRange() const = 0;
 
+      // only volumes paging their data on demand keep statistics
+      virtual VKLCacheStatistics getCacheStatistics() const;
+
+      // the voxels in region [lower, upper) of the (committed) volume's data
+      // have changed; update all derived state without a full commit
+      virtual void updateRegion(const box3i &region);
+
+      // write the acceleration structure to filename; volumes that support
+      // this load it again from their "acceleratorCache" parameter on commit
+      virtual void serializeAccelerator(const std::string &filename) const;
+
       void *getISPCEquivalent() const;
 
      protected:
       void *ispcEquivalent{nullptr};
+
+     private:
+      // swap in a committed instance, unless a newer commit already has been
+      void swapCommittedInstance(Volume<W> *instance, uint64_t commitId);
+
+      // make instance the committed one, and release the previous one once
+      // no query can still be taking a reference to it
+      void exchangeCommittedInstance(Volume<W> *instance);
+
+      // wait until no query can still be using an instance that was
+      // committed before the call
+      void waitForReaders();
+
+      void releaseRetiredInstances();
+
+      // number of swapped out instances kept for iterators
+      static constexpr size_t maxRetiredInstances = 2;
+
+      // type this volume has been created as, used for its async instances
+      std::string registeredType;
+
+      std::atomic<Volume<W> *> committed{this};
+
+      // queries using an asynchronously committed instance, counted by the
+      // parity of the epoch they started in. readers entering after a swap
+      // advanced the epoch do not delay the readers of the previous one
+      // from draining, so swaps cannot be starved by continuous queries
+      std::atomic<unsigned int> readerEpoch{0};
+      std::atomic<int> activeReaders[2]{{0}, {0}};
+
+      std::atomic<bool> iteratorsInitialized{false};
+
+      // swapped out instances that iterators may still be using, oldest
+      // first
+      std::vector<Volume<W> *> retired;
+
+      std::mutex swapMutex;
+      uint64_t lastCommitId{0};
+      uint64_t swappedCommitId{0};
     };
 
     // Inlined definitions ////////////////////////////////////////////////////
 
+    template <int W>
+    inline Volume<W>::~Volume()
+    {
+      if (committed.load() != this)
+        committed.load()->refDec();
+
+      releaseRetiredInstances();
+    }
+
     template <int W>
     inline Volume<W> *Volume<W>::createInstance(const std::string &type)
     {
-      return createInstanceHelper<Volume<W>, VKL_VOLUME>(type);
+      auto *volume = createInstanceHelper<Volume<W>, VKL_VOLUME>(type);
+
+      if (volume)
+        volume->registeredType = type;
+
+      return volume;
+    }
+
+    template <int W>
+    inline std::shared_future<void> Volume<W>::commitAsync()
+    {
+      Volume<W> *instance = createInstance(registeredType);
+
+      if (!instance) {
+        throw std::runtime_error("could not create volume of type " +
+                                 registeredType + " for async commit");
+      }
+
+      // snapshot the parameters; object parameters are shared, not copied
+      std::for_each(
+          params_begin(), params_end(), [&](std::shared_ptr<Param> &p) {
+            auto &param = *p;
+            Param *copy = instance->findParam(param.name, true);
+
+            if (param.data.is<VKL_PTR>())
+              copy->set(param.data.get<VKL_PTR>());
+            else
+              copy->data = param.data;
+          });
+
+      uint64_t commitId;
+      {
+        std::lock_guard<std::mutex> lock(swapMutex);
+        commitId = ++lastCommitId;
+      }
+
+      // keep the handle alive while the commit is in flight
+      refInc();
+
+      auto promise = std::make_shared<std::promise<void>>();
+      std::shared_future<void> future = promise->get_future().share();
+
+      tasking::schedule([=]() {
+        try {
+          instance->commit();
+          swapCommittedInstance(instance, commitId);
+          promise->set_value();
+        } catch (...) {
+          instance->refDec();
+          promise->set_exception(std::current_exception());
+        }
+
+        refDec();
+      });
+
+      return future;
+    }
+
+    template <int W>
+    inline CommittedVolume<W> Volume<W>::committedInstance(bool forIterator)
+    {
+      // the handle is owned by the application and never released by swaps
+      if (committed.load(std::memory_order_acquire) == this)
+        return CommittedVolume<W>(this, nullptr);
+
+      std::atomic<int> &readers = activeReaders[readerEpoch.load() & 1];
+      readers.fetch_add(1);
+
+      // loaded again once counted, so that swaps wait for this query
+      Volume<W> *instance = committed.load();
+
+      // set while counted as a reader, so that a concurrent swap sees it
+      if (forIterator && !instance->iteratorsInitialized.load())
+        instance->iteratorsInitialized.store(true);
+
+      return CommittedVolume<W>(instance, &readers);
+    }
+
+    template <int W>
+    inline void Volume<W>::resetCommittedInstance()
+    {
+      std::lock_guard<std::mutex> lock(swapMutex);
+      swappedCommitId = ++lastCommitId;
+
+      if (committed.load() != this)
+        exchangeCommittedInstance(this);
+
+      releaseRetiredInstances();
+    }
+
+    template <int W>
+    inline void Volume<W>::swapCommittedInstance(Volume<W> *instance,
+                                                 uint64_t commitId)
+    {
+      std::lock_guard<std::mutex> lock(swapMutex);
+
+      // commits may complete out of order; never replace a newer state
+      if (commitId < swappedCommitId) {
+        instance->refDec();
+        return;
+      }
+
+      swappedCommitId = commitId;
+
+      exchangeCommittedInstance(instance);
+    }
+
+    template <int W>
+    inline void Volume<W>::exchangeCommittedInstance(Volume<W> *instance)
+    {
+      Volume<W> *previous = committed.exchange(instance);
+
+      // the handle itself is owned by the application
+      if (previous == this)
+        return;
+
+      waitForReaders();
+
+      if (!previous->iteratorsInitialized.load()) {
+        previous->refDec();
+        return;
+      }
+
+      retired.push_back(previous);
+
+      if (retired.size() > maxRetiredInstances) {
+        retired.front()->refDec();
+        retired.erase(retired.begin());
+      }
+    }
+
+    template <int W>
+    inline void Volume<W>::waitForReaders()
+    {
+      // a reader may load the epoch just before it advances, and only be
+      // counted afterwards; advancing twice waits for such readers as well
+      for (int i = 0; i < 2; i++) {
+        const unsigned int epoch = readerEpoch.fetch_add(1);
+
+        while (activeReaders[epoch & 1].load() != 0)
+          std::this_thread::yield();
+      }
+    }
+
+    template <int W>
+    inline void Volume<W>::releaseRetiredInstances()
+    {
+      for (Volume<W> *instance : retired)
+        instance->refDec();
+
+      retired.clear();
     }
 
     template <int W>
@@ -216,8 +555,8 @@ namespace openvkl {
     inline void Volume<W>::computeSampleSeg(const vvec3fn<1> &objectCoordinates,
                                          vfloatn<1> &sample, uint8 *segmentation) const
     {
-      // gracefully degrade to use computeSampleV(); see
-      // ISPCDriver<W>::computeSampleAnyWidth()
+      // gracefully degrade to use computeSampleSegV(); see
+      // ISPCDriver<W>::computeSampleSegAnyWidth()
 
       vvec3fn<W> ocW = static_cast<vvec3fn<W>>(objectCoordinates);
 
@@ -228,11 +567,95 @@ namespace openvkl {
       ocW.fill_inactive_lanes(validW);
 
       vfloatn<W> samplesW;
+      uint8 segmentationW[W];
 
-      computeSampleSegV(validW, ocW, samplesW, segmentation);
-      // computeSampleV(validW, ocW, samplesW);
+      computeSampleSegV(validW, ocW, samplesW, segmentationW);
 
-      sample[0] = samplesW[0];
+      sample[0]       = samplesW[0];
+      segmentation[0] = segmentationW[0];
+    }
+
+    template <int W>
+    inline void Volume<W>::computeSampleStream(size_t count,
+                                               const float *x,
+                                               const float *y,
+                                               const float *z,
+                                               int stride,
+                                               float *samples) const
+    {
+      for (size_t packBegin = 0; packBegin < count; packBegin += W) {
+        vintn<W> validW;
+        vvec3fn<W> ocW;
+
+        for (int i = 0; i < W; i++) {
+          const size_t index = packBegin + i;
+          validW[i]          = index < count;
+
+          if (validW[i]) {
+            ocW.x[i] = x[index * stride];
+            ocW.y[i] = y[index * stride];
+            ocW.z[i] = z[index * stride];
+          }
+        }
+
+        ocW.fill_inactive_lanes(validW);
+
+        vfloatn<W> samplesW;
+
+        computeSampleV(validW, ocW, samplesW);
+
+        for (int i = 0; i < W && packBegin + i < count; i++)
+          samples[packBegin + i] = samplesW[i];
+      }
+    }
+
+    template <int W>
+    inline void Volume<W>::sampleRays(size_t numRays,
+                                      const vec3f *origins,
+                                      const vec3f *directions,
+                                      const float *tStart,
+                                      float dt,
+                                      size_t numSteps,
+                                      float *values,
+                                      uint8 *labels) const
+    {
+      for (size_t r = 0; r < numRays; r++) {
+        float *rayValues = values + r * numSteps;
+        uint8 *rayLabels = labels ? labels + r * numSteps : nullptr;
+
+        for (size_t packBegin = 0; packBegin < numSteps; packBegin += W) {
+          vintn<W> validW;
+          vvec3fn<W> ocW;
+
+          for (int i = 0; i < W; i++) {
+            const size_t step = packBegin + i;
+            validW[i]         = step < numSteps;
+
+            if (validW[i]) {
+              const vec3f c =
+                  origins[r] + (tStart[r] + step * dt) * directions[r];
+
+              ocW.x[i] = c.x;
+              ocW.y[i] = c.y;
+              ocW.z[i] = c.z;
+            }
+          }
+
+          ocW.fill_inactive_lanes(validW);
+
+          vfloatn<W> samplesW;
+          uint8 labelsW[W];
+
+          computeSampleSegV(validW, ocW, samplesW, labelsW);
+
+          for (int i = 0; i < W && packBegin + i < numSteps; i++) {
+            rayValues[packBegin + i] = samplesW[i];
+
+            if (rayLabels)
+              rayLabels[packBegin + i] = labelsW[i];
+          }
+        }
+      }
     }
 
     template <int W>
@@ -243,6 +666,59 @@ namespace openvkl {
       THROW_NOT_IMPLEMENTED;
     }
 
+    template <int W>
+    inline void Volume<W>::computeSampleAndGradientV(
+        const vintn<W> &valid,
+        const vvec3fn<W> &objectCoordinates,
+        vfloatn<W> &samples,
+        vvec3fn<W> &gradients) const
+    {
+      computeSampleV(valid, objectCoordinates, samples);
+      computeGradientV(valid, objectCoordinates, gradients);
+    }
+
+    template <int W>
+    inline void Volume<W>::computeSampleLOD(
+        const vvec3fn<1> &objectCoordinates, float, vfloatn<1> &sample) const
+    {
+      computeSample(objectCoordinates, sample);
+    }
+
+    template <int W>
+    inline void Volume<W>::computeSampleTime(
+        const vvec3fn<1> &objectCoordinates, float, vfloatn<1> &sample) const
+    {
+      computeSample(objectCoordinates, sample);
+    }
+
+    template <int W>
+    inline void Volume<W>::computeSampleHint(
+        const vvec3fn<1> &objectCoordinates,
+        uint64_t &,
+        vfloatn<1> &sample) const
+    {
+      computeSample(objectCoordinates, sample);
+    }
+
+    template <int W>
+    inline VKLCacheStatistics Volume<W>::getCacheStatistics() const
+    {
+      return VKLCacheStatistics{};
+    }
+
+    template <int W>
+    inline void Volume<W>::updateRegion(const box3i &region)
+    {
+      THROW_NOT_IMPLEMENTED;
+    }
+
+    template <int W>
+    inline void Volume<W>::serializeAccelerator(
+        const std::string &filename) const
+    {
+      THROW_NOT_IMPLEMENTED;
+    }
+
     template <int W>
     inline void *Volume<W>::getISPCEquivalent() const
     {
@@ -15,7 +15,9 @@
 // ======================================================================== //
 
 #include "AMRAccel.h"
+#include <cmath>
 #include <set>
+#include "ospcommon/tasking/parallel_for.h"
 
 namespace openvkl {
   namespace ispc_driver {
@@ -24,28 +26,91 @@ namespace openvkl {
       /*! constructor that constructs the actual accel from the amr data */
       AMRAccel::AMRAccel(const AMRData &input)
       {
-        box3f bounds = empty;
+        initLevels(input);
+
         std::vector<const AMRData::Brick *> brickVec;
-        for (auto &b : input.brick) {
+        for (auto &b : input.brick)
           brickVec.push_back(&b);
-          bounds.extend(b.worldBounds);
+
+        node.resize(1);
+        buildRec(0, worldBounds, brickVec);
+
+        buildTraversal();
+      }
+
+      /*! cache sections: nodes, leaf bounds, leaf value ranges, offset of
+          each leaf's brick list (plus the end of the last one), and the
+          brick lists as indices into input.brick */
+      AMRAccel::AMRAccel(const AMRData &input, const AcceleratorCache &cache)
+      {
+        initLevels(input);
+
+        size_t numNodes;
+        const Node *cachedNode = cache.section<Node>(0, numNodes);
+
+        if (numNodes == 0) {
+          throw std::runtime_error("accelerator cache section has wrong size");
         }
-        this->worldBounds = bounds;
-
-        for (auto &b : brickVec) {
-          if (b->level >= static_cast<int>(level.size()))
-            level.resize(b->level + 1);
-          level[b->level].level         = b->level;
-          level[b->level].cellWidth     = b->cellWidth;
-          level[b->level].halfCellWidth = 0.5f * b->cellWidth;
-          level[b->level].rcpCellWidth  = 1.f / b->cellWidth;
+
+        node.assign(cachedNode, cachedNode + numNodes);
+
+        size_t numLeaves;
+        const box3f *leafBounds = cache.section<box3f>(1, numLeaves);
+        const range1f *leafValueRange =
+            cache.sectionOfSize<range1f>(2, numLeaves);
+        const uint64_t *brickListBegin =
+            cache.sectionOfSize<uint64_t>(3, numLeaves + 1);
+
+        size_t numBrickRefs;
+        const uint32_t *brickID = cache.section<uint32_t>(4, numBrickRefs);
+
+        if (brickListBegin[numLeaves] != numBrickRefs) {
+          throw std::runtime_error("accelerator cache section has wrong size");
         }
 
-        node.resize(1);
-        buildRec(0, bounds, brickVec);
+        // validate before allocating any brick lists. children are stored
+        // after their parent, as by buildRec(), so that traversal always
+        // terminates, and every leaf lists at least its finest brick
+        for (size_t i = 0; i < numNodes; i++) {
+          const Node &n = node[i];
+
+          if (n.isLeaf() ? n.ofs >= numLeaves
+                         : n.ofs <= i || n.ofs + 1 >= numNodes) {
+            throw std::runtime_error("accelerator cache is corrupted");
+          }
+        }
+
+        for (size_t i = 0; i < numLeaves; i++) {
+          if (brickListBegin[i] >= brickListBegin[i + 1]) {
+            throw std::runtime_error("accelerator cache is corrupted");
+          }
+        }
+
+        for (size_t j = 0; j < numBrickRefs; j++) {
+          if (brickID[j] >= input.brick.size()) {
+            throw std::runtime_error("accelerator cache is corrupted");
+          }
+        }
+
+        leaf.resize(numLeaves);
+
+        for (size_t i = 0; i < numLeaves; i++) {
+          const uint64_t begin = brickListBegin[i];
+          const uint64_t end   = brickListBegin[i + 1];
+
+          leaf[i].bounds     = leafBounds[i];
+          leaf[i].valueRange = leafValueRange[i];
+          leaf[i].brickList  = new const AMRData::Brick *[end - begin + 1];
+
+          for (uint64_t j = begin; j < end; j++)
+            leaf[i].brickList[j - begin] = &input.brick[brickID[j]];
+
+          leaf[i].brickList[end - begin] = nullptr;
+        }
+
+        buildTraversal();
       }
 
-      /*! destructor that frees all allocated memory */
       AMRAccel::~AMRAccel()
       {
         for (auto &l : leaf)
@@ -55,6 +120,126 @@ namespace openvkl {
         node.clear();
       }
 
+      void AMRAccel::serialize(const AMRData &input,
+                               const std::string &filename,
+                               uint64_t inputHash) const
+      {
+        std::vector<box3f> leafBounds;
+        std::vector<range1f> leafValueRange;
+        std::vector<uint64_t> brickListBegin;
+        std::vector<uint32_t> brickID;
+
+        for (const auto &l : leaf) {
+          leafBounds.push_back(l.bounds);
+          leafValueRange.push_back(l.valueRange);
+          brickListBegin.push_back(brickID.size());
+
+          for (const AMRData::Brick **b = l.brickList; *b; b++)
+            brickID.push_back(*b - input.brick.data());
+        }
+
+        brickListBegin.push_back(brickID.size());
+
+        AcceleratorCacheWriter writer("amr_kdtree", inputHash);
+        writer.addSection(node);
+        writer.addSection(leafBounds);
+        writer.addSection(leafValueRange);
+        writer.addSection(brickListBegin);
+        writer.addSection(brickID);
+        writer.write(filename);
+      }
+
+      void AMRAccel::initLevels(const AMRData &input)
+      {
+        worldBounds = input.worldBounds();
+
+        for (auto &b : input.brick) {
+          if (b.level >= static_cast<int>(level.size()))
+            level.resize(b.level + 1);
+          level[b.level].level         = b.level;
+          level[b.level].cellWidth     = b.cellWidth;
+          level[b.level].halfCellWidth = 0.5f * b.cellWidth;
+          level[b.level].rcpCellWidth  = 1.f / b.cellWidth;
+        }
+      }
+
+      void AMRAccel::buildTraversal()
+      {
+        nodeDimAndOfs.resize(node.size());
+        nodePos.resize(node.size());
+
+        for (size_t i = 0; i < node.size(); i++) {
+          nodeDimAndOfs[i] = (node[i].dim << 30) | node[i].ofs;
+          nodePos[i]       = node[i].pos;
+        }
+
+        updateLeafBricks();
+
+        // about one grid cell per leaf, at most 64 cells per dimension
+        const vec3f size = worldBounds.size();
+        const float numCells =
+            std::min(float(leaf.size()), 64.f * 64.f * 64.f);
+        const float cellWidth =
+            std::cbrt(size.x * size.y * size.z / numCells);
+
+        for (int dim = 0; dim < 3; dim++) {
+          topLevelGridDims[dim] =
+              std::min(std::max(int(std::ceil(size[dim] / cellWidth)), 1), 64);
+        }
+
+        topLevelGridScale = vec3f(topLevelGridDims) / size;
+
+        topLevelGrid.resize(topLevelGridDims.long_product());
+
+        const vec3f gridCellWidth = size / vec3f(topLevelGridDims);
+
+        tasking::parallel_for(topLevelGridDims.z, [&](int z) {
+          for (int y = 0; y < topLevelGridDims.y; y++) {
+            for (int x = 0; x < topLevelGridDims.x; x++) {
+              // grow the cell a little, so that positions mapped to it
+              // by the ispc side, with rounding, still lie in its node
+              const vec3f lower =
+                  worldBounds.lower + vec3f(x, y, z) * gridCellWidth;
+              const box3f cellBounds(lower - 0.01f * gridCellWidth,
+                                     lower + 1.01f * gridCellWidth);
+
+              uint32 nodeID = 0;
+
+              while (!node[nodeID].isLeaf()) {
+                const Node &n = node[nodeID];
+
+                if (cellBounds.upper[n.dim] < n.pos)
+                  nodeID = n.ofs;
+                else if (cellBounds.lower[n.dim] >= n.pos)
+                  nodeID = n.ofs + 1;
+                else
+                  break;
+              }
+
+              topLevelGrid[x + topLevelGridDims.x *
+                                   (y + size_t(topLevelGridDims.y) * z)] =
+                  nodeID;
+            }
+          }
+        });
+      }
+
+      void AMRAccel::updateLeafBricks()
+      {
+        leafBrick.resize(leaf.size());
+
+        for (size_t i = 0; i < leaf.size(); i++) {
+          const AMRData::Brick &brick = *leaf[i].brickList[0];
+
+          leafBrick[i].value            = brick.value;
+          leafBrick[i].bounds           = leaf[i].bounds;
+          leafBrick[i].lower            = brick.worldBounds.lower;
+          leafBrick[i].cellWidth        = brick.cellWidth;
+          leafBrick[i].worldToGridScale = brick.worldToGridScale;
+          leafBrick[i].f_dims           = brick.f_dims;
+        }
+      }
+
       void AMRAccel::makeLeaf(index_t nodeID,
                               const box3f &bounds,
                               const std::vector<const AMRData::Brick *> &brick)
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "../../common/AcceleratorCache.h"
 #include "AMRData.h"
 
 namespace openvkl {
@@ -34,6 +35,11 @@ namespace openvkl {
       {
         /*! constructor that constructs the actual accel from the amr data */
         AMRAccel(const AMRData &input);
+        /*! constructor that restores the accel for the amr data from a
+            cache written by serialize(); leaf value ranges are restored
+            as well. throws if the cache is not a valid accel for the
+            data */
+        AMRAccel(const AMRData &input, const AcceleratorCache &cache);
         /*! destructor that frees all allocated memory */
         ~AMRAccel();
 
@@ -96,8 +102,43 @@ namespace openvkl {
           };
         };
 
+        /*! the bounds of a leaf and the fields of its finest brick that
+            sampling needs, stored inline so that finding a cell in the
+            finest brick does not go through the leaf's brickList. layout
+            must match AMRLeafBrick on the ispc side */
+        struct LeafBrick
+        {
+          //! data values of the finest brick
+          const float *value;
+          //! bounds of the leaf
+          box3f bounds;
+          //! lower world bounds of the finest brick
+          vec3f lower;
+          //! cell width of the finest brick
+          float cellWidth;
+          //! rcp(bounds.upper-bounds.lower) of the finest brick
+          vec3f worldToGridScale;
+          //! dimensions of the finest brick, in float
+          vec3f f_dims;
+        };
+
         void buildLevelInfo();
 
+        /*! build the flattened tree used for traversal on the ispc side
+            (node fields in separate arrays, inline leaf bricks, and the
+            top level grid) from node[] and leaf[] */
+        void buildTraversal();
+
+        /*! refresh the inline leaf bricks after the brick values have
+            been replaced */
+        void updateLeafBricks();
+
+        /*! write the accel, including leaf value ranges, to filename;
+            bricks are stored as indices into input.brick */
+        void serialize(const AMRData &input,
+                       const std::string &filename,
+                       uint64_t inputHash) const;
+
         inline const Level &finestLevel() const
         {
           return level.back();
@@ -112,7 +153,23 @@ namespace openvkl {
         //! world bounds of domain
         box3f worldBounds;
 
+        //! split dimension and offset of each node, packed as on the ispc side
+        std::vector<uint32> nodeDimAndOfs;
+        //! split position of each node
+        std::vector<float> nodePos;
+        //! inline finest brick of each leaf
+        std::vector<LeafBrick> leafBrick;
+
+        /*! uniform grid over worldBounds giving, for each of its cells,
+            the deepest node containing the cell, so that traversal does
+            not need to start at the root */
+        std::vector<uint32> topLevelGrid;
+        vec3i topLevelGridDims;
+        //! grid cells per unit of worldBounds
+        vec3f topLevelGridScale;
+
        private:
+        void initLevels(const AMRData &input);
         void makeLeaf(index_t nodeID,
                       const box3f &bounds,
                       const std::vector<const AMRData::Brick *> &brickIDs);
@@ -67,6 +67,24 @@ namespace openvkl {
         }
       }
 
+      void AMRData::setBlockData(const Data &blockDataData)
+      {
+        if (blockDataData.numItems != brick.size())
+          throw std::runtime_error(
+              "amr volume 'block.data' must have one entry per block");
+
+        const Data **allBlocksData = (const Data **)blockDataData.data;
+
+        for (size_t i = 0; i < brick.size(); i++) {
+          if (allBlocksData[i]->size() != brick[i].dims.long_product())
+            throw std::runtime_error(
+                "amr volume 'block.data' entry does not match its block size");
+        }
+
+        for (size_t i = 0; i < brick.size(); i++)
+          brick[i].value = (const float *)allBlocksData[i]->data;
+      }
+
     }  // namespace amr
   }    // namespace ispc_driver
 }  // namespace openvkl
@@ -89,6 +89,11 @@ namespace openvkl {
         //! our own, internal representation of a brick
         std::vector<Brick> brick;
 
+        /*! point the bricks to new data, given as one array per brick in
+            the same order as on construction; all other brick fields
+            are kept */
+        void setBlockData(const Data &blockDataData);
+
         /*! compute world-space bounding box (lot in _logical_ space,
             but in _absolute_ space, with proper cell width as specified
             in each level */
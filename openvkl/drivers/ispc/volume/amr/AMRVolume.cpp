@@ -31,6 +31,41 @@
 namespace openvkl {
   namespace ispc_driver {
 
+    // determine voxelType from set of block data; they must all be the same
+    static VKLDataType getBlockDataType(const Data &blockDataData)
+    {
+      std::set<VKLDataType> blockDataTypes;
+
+      for (int i = 0; i < blockDataData.numItems; i++)
+        blockDataTypes.insert(((Data **)blockDataData.data)[i]->dataType);
+
+      if (blockDataTypes.size() != 1)
+        throw std::runtime_error(
+            "all block.data entries must have same VKLDataType");
+
+      const VKLDataType voxelType = *blockDataTypes.begin();
+
+      switch (voxelType) {
+      case VKL_UCHAR:
+        break;
+      case VKL_SHORT:
+        break;
+      case VKL_USHORT:
+        break;
+      case VKL_FLOAT:
+        break;
+      case VKL_DOUBLE:
+        break;
+      default:
+        throw std::runtime_error(
+            "AMR volume 'block.data' entries have invalid VKLDataType. "
+            "must be one of: VKL_UCHAR, VKL_SHORT, "
+            "VKL_USHORT, VKL_FLOAT, VKL_DOUBLE");
+      }
+
+      return voxelType;
+    }
+
     template <int W>
     AMRVolume<W>::AMRVolume()
     {
@@ -46,6 +81,8 @@ namespace openvkl {
     template <int W>
     void AMRVolume<W>::commit()
     {
+      const VKLAMRMethod previousMethod = amrMethod;
+
       amrMethod =
           (VKLAMRMethod)this->template getParam<int>("method", VKL_AMR_CURRENT);
 
@@ -56,30 +93,68 @@ namespace openvkl {
       else if (amrMethod == VKL_AMR_OCTANT)
         ispc::AMR_install_octant(this->ispcEquivalent);
 
-      if (data != nullptr)  // TODO: support data updates
-        return;
-
-      blockBoundsData = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
-          "block.bounds", nullptr);
-      if (blockBoundsData.ptr == nullptr)
+      Data *blockBounds = (Data *)this->template getParam<
+          ManagedObject::VKL_PTR>("block.bounds", nullptr);
+      if (blockBounds == nullptr)
         throw std::runtime_error("amr volume must have 'block.bounds' array");
 
-      refinementLevelsData =
-          (Data *)this->template getParam<ManagedObject::VKL_PTR>("block.level",
-                                                                  nullptr);
-      if (refinementLevelsData.ptr == nullptr)
+      Data *refinementLevels = (Data *)this->template getParam<
+          ManagedObject::VKL_PTR>("block.level", nullptr);
+      if (refinementLevels == nullptr)
         throw std::runtime_error("amr volume must have 'block.level' array");
 
-      cellWidthsData = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
-          "cellWidth", nullptr);
-      if (cellWidthsData.ptr == nullptr)
+      Data *cellWidths = (Data *)this->template getParam<
+          ManagedObject::VKL_PTR>("cellWidth", nullptr);
+      if (cellWidths == nullptr)
         throw std::runtime_error("amr volume must have 'cellWidth' array");
 
-      blockDataData = (Data *)this->template getParam<ManagedObject::VKL_PTR>(
-          "block.data", nullptr);
-      if (blockDataData.ptr == nullptr)
+      Data *blockData = (Data *)this->template getParam<
+          ManagedObject::VKL_PTR>("block.data", nullptr);
+      if (blockData == nullptr)
         throw std::runtime_error("amr volume must have 'block.data' array");
 
+      const vec3f newGridOrigin =
+          this->template getParam<vec3f>("gridOrigin", vec3f(0.f));
+      const vec3f newGridSpacing =
+          this->template getParam<vec3f>("gridSpacing", vec3f(1.f));
+
+      // new block data over the same blocks (e.g. the next time step of a
+      // series), a new grid transform or method keep the k-d tree; the leaf
+      // value ranges are recomputed, as they are sampled with the method
+      if (data != nullptr && blockBounds == blockBoundsData.ptr &&
+          refinementLevels == refinementLevelsData.ptr &&
+          cellWidths == cellWidthsData.ptr) {
+        postLogMessage(VKL_LOG_DEBUG) << "keeping the AMR volume k-d tree";
+
+        const bool blockDataChanged = blockData != blockDataData.ptr;
+        const bool gridChanged      = newGridOrigin != gridOrigin ||
+                                 newGridSpacing != gridSpacing;
+
+        if (blockDataChanged)
+          updateBlockData(blockData);
+
+        if (gridChanged) {
+          gridOrigin  = newGridOrigin;
+          gridSpacing = newGridSpacing;
+          setGrid();
+        }
+
+        if (blockDataChanged || gridChanged || amrMethod != previousMethod)
+          computeValueRanges(true);
+
+        return;
+      }
+
+      gridOrigin  = newGridOrigin;
+      gridSpacing = newGridSpacing;
+
+      blockBoundsData      = blockBounds;
+      refinementLevelsData = refinementLevels;
+      cellWidthsData       = cellWidths;
+      blockDataData        = blockData;
+
+      voxelType = getBlockDataType(*blockDataData);
+
       // create the AMR data structure. This creates the logical blocks, which
       // contain the actual data and block-level metadata, such as cell width
       // and refinement level
@@ -92,56 +167,81 @@ namespace openvkl {
       // representation of the blocks in the AMRData object. In short, blocks at
       // the highest refinement level (i.e. with the most detail) are leaf
       // nodes, and parents have progressively lower resolution
-      accel = make_unique<amr::AMRAccel>(*data);
+      // the accel, including the value range of each leaf, may instead come
+      // from a cache written by vklVolumeSerializeAccelerator()
+      const std::string cacheFilename =
+          this->template getParam<std::string>("acceleratorCache", "");
 
-      float coarsestCellWidth = *std::max_element(
-          cellWidthsData->begin<float>(), cellWidthsData->end<float>());
+      std::unique_ptr<AcceleratorCache> cache;
 
-      float samplingStep = 0.1f * coarsestCellWidth;
+      if (!cacheFilename.empty()) {
+        cache =
+            AcceleratorCache::open(cacheFilename, "amr_kdtree", hashAccel());
+      }
+
+      std::unique_ptr<amr::AMRAccel> newAccel;
+
+      if (cache) {
+        try {
+          newAccel = make_unique<amr::AMRAccel>(*data, *cache);
+          postLogMessage(VKL_LOG_DEBUG)
+              << "using accelerator cache " << cacheFilename;
+        } catch (const std::runtime_error &e) {
+          LogMessageStream(VKL_LOG_WARNING)
+              << "ignoring corrupt accelerator cache " << cacheFilename
+              << ": " << e.what() << std::endl;
+          cache.reset();
+        }
+      }
+
+      if (!newAccel)
+        newAccel = make_unique<amr::AMRAccel>(*data);
+
+      accel = std::move(newAccel);
 
       bounds = accel->worldBounds;
 
-      const vec3f gridSpacing =
-          this->template getParam<vec3f>("gridSpacing", vec3f(1.f));
-      const vec3f gridOrigin =
-          this->template getParam<vec3f>("gridOrigin", vec3f(0.f));
+      setGrid();
+      setAMR();
 
-      // determine voxelType from set of block data; they must all be the same
-      std::set<VKLDataType> blockDataTypes;
+      // leaf value ranges restored from the cache are kept
+      computeValueRanges(!cache);
+    }
 
-      for (int i = 0; i < blockDataData->numItems; i++)
-        blockDataTypes.insert(((Data **)blockDataData->data)[i]->dataType);
+    template <int W>
+    void AMRVolume<W>::updateBlockData(Data *blockData)
+    {
+      const VKLDataType blockDataType = getBlockDataType(*blockData);
 
-      if (blockDataTypes.size() != 1)
-        throw std::runtime_error(
-            "all block.data entries must have same VKLDataType");
+      data->setBlockData(*blockData);
 
-      voxelType = *blockDataTypes.begin();
+      blockDataData = blockData;
+      voxelType     = blockDataType;
 
-      switch (voxelType) {
-      case VKL_UCHAR:
-        break;
-      case VKL_SHORT:
-        break;
-      case VKL_USHORT:
-        break;
-      case VKL_FLOAT:
-        break;
-      case VKL_DOUBLE:
-        break;
-      default:
-        throw std::runtime_error(
-            "AMR volume 'block.data' entries have invalid VKLDataType. "
-            "must be one of: VKL_UCHAR, VKL_SHORT, "
-            "VKL_USHORT, VKL_FLOAT, VKL_DOUBLE");
-      }
+      // the leaves point to the bricks of data; only their inline copies
+      // of the finest brick, and the voxel accessor, need to be updated
+      accel->updateLeafBricks();
+      setAMR();
+    }
+
+    template <int W>
+    void AMRVolume<W>::setGrid()
+    {
+      float coarsestCellWidth = *std::max_element(
+          cellWidthsData->begin<float>(), cellWidthsData->end<float>());
+
+      float samplingStep = 0.1f * coarsestCellWidth;
 
       ispc::AMRVolume_set(this->ispcEquivalent,
                           (ispc::box3f &)bounds,
                           samplingStep,
                           (const ispc::vec3f &)gridOrigin,
                           (const ispc::vec3f &)gridSpacing);
+    }
 
+    template <int W>
+    void AMRVolume<W>::setAMR()
+    {
       ispc::AMRVolume_setAMR(this->ispcEquivalent,
                              accel->node.size(),
                              &accel->node[0],
@@ -149,21 +249,88 @@ namespace openvkl {
                              &accel->leaf[0],
                              accel->level.size(),
                              &accel->level[0],
+                             &accel->nodeDimAndOfs[0],
+                             &accel->nodePos[0],
+                             &accel->leafBrick[0],
+                             &accel->topLevelGrid[0],
+                             (const ispc::vec3i &)accel->topLevelGridDims,
+                             (const ispc::vec3f &)accel->topLevelGridScale,
                              voxelType,
                              (ispc::box3f &)bounds);
+    }
 
+    template <int W>
+    void AMRVolume<W>::computeValueRanges(bool computeLeafValueRanges)
+    {
       // parse the k-d tree to compute the voxel range of each leaf node.
       // This enables empty space skipping within the hierarchical structure
-      tasking::parallel_for(accel->leaf.size(), [&](size_t leafID) {
-        ispc::AMRVolume_computeValueRangeOfLeaf(this->ispcEquivalent, leafID);
-      });
+      if (computeLeafValueRanges) {
+        tasking::parallel_for(accel->leaf.size(), [&](size_t leafID) {
+          ispc::AMRVolume_computeValueRangeOfLeaf(this->ispcEquivalent,
+                                                  leafID);
+        });
+      }
 
       // compute value range over the full volume
+      valueRange = range1f(empty);
+
       for (const auto &l : accel->leaf) {
         valueRange.extend(l.valueRange);
       }
     }
 
+    template <int W>
+    void AMRVolume<W>::initIntervalIteratorV(
+        const vintn<W> &valid,
+        vVKLIntervalIteratorN<W> &iterator,
+        const vvec3fn<W> &origin,
+        const vvec3fn<W> &direction,
+        const vrange1fn<W> &tRange,
+        const ValueSelector<W> *valueSelector)
+    {
+      iterator = toVKLIntervalIterator<W>(AMRIterator<W>(
+          valid, this, origin, direction, tRange, valueSelector));
+    }
+
+    template <int W>
+    void AMRVolume<W>::iterateIntervalV(const vintn<W> &valid,
+                                        vVKLIntervalIteratorN<W> &iterator,
+                                        vVKLIntervalN<W> &interval,
+                                        vintn<W> &result)
+    {
+      AMRIterator<W> *ai = fromVKLIntervalIterator<AMRIterator<W>>(&iterator);
+
+      ai->iterateInterval(valid, result);
+
+      interval =
+          *reinterpret_cast<const vVKLIntervalN<W> *>(ai->getCurrentInterval());
+    }
+
+    template <int W>
+    void AMRVolume<W>::initHitIteratorV(const vintn<W> &valid,
+                                        vVKLHitIteratorN<W> &iterator,
+                                        const vvec3fn<W> &origin,
+                                        const vvec3fn<W> &direction,
+                                        const vrange1fn<W> &tRange,
+                                        const ValueSelector<W> *valueSelector)
+    {
+      iterator = toVKLHitIterator<W>(AMRIterator<W>(
+          valid, this, origin, direction, tRange, valueSelector));
+    }
+
+    template <int W>
+    void AMRVolume<W>::iterateHitV(const vintn<W> &valid,
+                                   vVKLHitIteratorN<W> &iterator,
+                                   vVKLHitN<W> &hit,
+                                   vintn<W> &result)
+    {
+      AMRIterator<W> *ai = fromVKLHitIterator<AMRIterator<W>>(&iterator);
+
+      ai->iterateHit(valid, result);
+
+      hit = *reinterpret_cast<const vVKLHitN<W> *>(ai->getCurrentHit());
+    }
+
     template <int W>
     void AMRVolume<W>::computeSampleV(const vintn<W> &valid,
                                       const vvec3fn<W> &objectCoordinates,
@@ -185,14 +352,34 @@ namespace openvkl {
                                     this->ispcEquivalent,
                                     &objectCoordinates,
                                     &samples);
+
+      // no label channel; report the background label for all active lanes
+      for (int i = 0; i < W; i++)
+        if (valid[i])
+          segmentation[i] = 0;
     }
-                          
+
+    template <int W>
+    void AMRVolume<W>::computeSampleStream(size_t count,
+                                           const float *x,
+                                           const float *y,
+                                           const float *z,
+                                           int stride,
+                                           float *samples) const
+    {
+      ispc::AMRVolume_sample_stream_export(
+          this->ispcEquivalent, count, x, y, z, stride, samples);
+    }
+
     template <int W>
     void AMRVolume<W>::computeGradientV(const vintn<W> &valid,
                                         const vvec3fn<W> &objectCoordinates,
                                         vvec3fn<W> &gradients) const
     {
-      THROW_NOT_IMPLEMENTED;
+      ispc::AMRVolume_gradient_export((const int *)&valid,
+                                      this->ispcEquivalent,
+                                      &objectCoordinates,
+                                      &gradients);
     }
 
     template <int W>
@@ -207,6 +394,29 @@ namespace openvkl {
       return valueRange;
     }
 
+    template <int W>
+    void AMRVolume<W>::serializeAccelerator(const std::string &filename) const
+    {
+      if (!accel) {
+        throw std::runtime_error(
+            "volume must be committed before serializing its accelerator");
+      }
+
+      accel->serialize(*data, filename, hashAccel());
+    }
+
+    template <int W>
+    uint64_t AMRVolume<W>::hashAccel() const
+    {
+      uint64_t hash = hashData(blockBoundsData.ptr);
+      hash          = hashData(refinementLevelsData.ptr, hash);
+      hash          = hashData(cellWidthsData.ptr, hash);
+      hash          = hashData(blockDataData.ptr, hash);
+
+      // the leaf value ranges are sampled with the method
+      return hashValue(amrMethod, hash);
+    }
+
     VKL_REGISTER_VOLUME(AMRVolume<4>, amr_4);
     VKL_REGISTER_VOLUME(AMRVolume<8>, amr_8);
     VKL_REGISTER_VOLUME(AMRVolume<16>, amr_16);
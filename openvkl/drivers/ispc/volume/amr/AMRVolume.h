@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "../../iterator/AMRIterator.h"
 #include "../Volume.h"
 #include "AMRAccel.h"
 #include "ospcommon/memory/RefCount.h"
@@ -35,6 +36,31 @@ namespace openvkl {
 
       void commit() override;
 
+      void initIntervalIteratorV(
+          const vintn<W> &valid,
+          vVKLIntervalIteratorN<W> &iterator,
+          const vvec3fn<W> &origin,
+          const vvec3fn<W> &direction,
+          const vrange1fn<W> &tRange,
+          const ValueSelector<W> *valueSelector) override;
+
+      void iterateIntervalV(const vintn<W> &valid,
+                            vVKLIntervalIteratorN<W> &iterator,
+                            vVKLIntervalN<W> &interval,
+                            vintn<W> &result) override;
+
+      void initHitIteratorV(const vintn<W> &valid,
+                            vVKLHitIteratorN<W> &iterator,
+                            const vvec3fn<W> &origin,
+                            const vvec3fn<W> &direction,
+                            const vrange1fn<W> &tRange,
+                            const ValueSelector<W> *valueSelector) override;
+
+      void iterateHitV(const vintn<W> &valid,
+                       vVKLHitIteratorN<W> &iterator,
+                       vVKLHitN<W> &hit,
+                       vintn<W> &result) override;
+
       void computeSampleV(const vintn<W> &valid,
                           const vvec3fn<W> &objectCoordinates,
                           vfloatn<W> &samples) const override;
@@ -44,12 +70,38 @@ namespace openvkl {
                           vfloatn<W> &samples, 
                           uint8 *segmentation) const override;
 
+      void computeSampleStream(size_t count,
+                               const float *x,
+                               const float *y,
+                               const float *z,
+                               int stride,
+                               float *samples) const override;
+
       void computeGradientV(const vintn<W> &valid,
                             const vvec3fn<W> &objectCoordinates,
                             vvec3fn<W> &gradients) const override;
       box3f getBoundingBox() const override;
       range1f getValueRange() const override;
 
+      void serializeAccelerator(const std::string &filename) const override;
+
+      // hash of everything the accel is built from
+      uint64_t hashAccel() const;
+
+      // point the bricks to new data for the same blocks, keeping the accel;
+      // the value ranges must be recomputed after
+      void updateBlockData(Data *blockData);
+
+      // pass the bounds and grid transform to the ispc side
+      void setGrid();
+
+      // pass the accel to the ispc side
+      void setAMR();
+
+      // set the volume value range, and optionally first the value range of
+      // each leaf
+      void computeValueRanges(bool computeLeafValueRanges);
+
       std::unique_ptr<amr::AMRData> data;
       std::unique_ptr<amr::AMRAccel> accel;
 
@@ -60,8 +112,10 @@ namespace openvkl {
       VKLDataType voxelType;
       range1f valueRange{empty};
       box3f bounds;
+      vec3f gridOrigin{0.f};
+      vec3f gridSpacing{1.f};
 
-      VKLAMRMethod amrMethod;
+      VKLAMRMethod amrMethod{VKL_AMR_CURRENT};
     };
 
   }  // namespace ispc_driver
@@ -54,6 +54,14 @@ OPENVKL_INTERFACE VKLData vklNewData(size_t numItems,
                                      VKLDataCreationFlags dataCreationFlags
                                          VKL_DEFAULT_VAL(= VKL_DATA_DEFAULT));
 
+// create a read-only data object backed by a memory mapping of numItems items
+// of dataType, starting at byte offset in the given file. no copy is made; the
+// file must not be modified or truncated while the data object is alive.
+OPENVKL_INTERFACE VKLData vklNewDataFromFile(const char *filename,
+                                             size_t offset,
+                                             size_t numItems,
+                                             VKLDataType dataType);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -21,6 +21,16 @@
 struct Driver;
 typedef struct Driver *VKLDriver;
 
+#ifdef __cplusplus
+struct Fence : public ManagedObject
+{
+};
+#else
+typedef ManagedObject Fence;
+#endif
+
+typedef Fence *VKLFence;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,6 +65,18 @@ OPENVKL_INTERFACE int vklGetNativeSIMDWidth();
 
 OPENVKL_INTERFACE void vklCommit(VKLObject object);
 
+// commit object without blocking the calling thread. volumes are committed in
+// the background, and other calls keep using the previously committed state
+// until the returned fence is ready. the fence must be released with
+// vklRelease()
+OPENVKL_INTERFACE VKLFence vklCommitAsync(VKLObject object);
+
+// block until the commit of fence completed
+OPENVKL_INTERFACE void vklWait(VKLFence fence);
+
+// returns 1 if the commit of fence completed, 0 otherwise
+OPENVKL_INTERFACE int vklIsReady(VKLFence fence);
+
 OPENVKL_INTERFACE void vklRelease(VKLObject object);
 
 OPENVKL_INTERFACE void vklShutdown();
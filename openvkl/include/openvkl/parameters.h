@@ -16,6 +16,12 @@
 
 #pragma once
 
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
 #include "common.h"
 
 #ifdef __cplusplus
@@ -26,6 +32,7 @@ OPENVKL_INTERFACE void vklSetBool(VKLObject object, const char *name, int b);
 OPENVKL_INTERFACE void vklSetFloat(VKLObject object, const char *name, float x);
 OPENVKL_INTERFACE void vklSetVec3f(VKLObject object, const char *name, float x, float y, float z);
 OPENVKL_INTERFACE void vklSetInt(VKLObject object, const char *name, int x);
+OPENVKL_INTERFACE void vklSetULong(VKLObject object, const char *name, uint64_t x);
 OPENVKL_INTERFACE void vklSetVec3i(VKLObject object, const char *name, int x, int y, int z);
 OPENVKL_INTERFACE void vklSetData(VKLObject object, const char *name, VKLData data);
 OPENVKL_INTERFACE void vklSetString(VKLObject object, const char *name, const char *s);
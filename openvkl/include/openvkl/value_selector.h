@@ -45,6 +45,10 @@ void vklValueSelectorSetValues(VKLValueSelector valueSelector,
                                size_t numValues,
                                const float *values);
 
+OPENVKL_INTERFACE
+void vklValueSelectorSetStepSize(VKLValueSelector valueSelector,
+                                 float stepSize);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
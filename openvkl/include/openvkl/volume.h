@@ -48,6 +48,22 @@ typedef enum
   VKL_PYRAMID = 14
 } VKLUnstructuredCellType;
 
+// callback supplying the voxels of structured_regular_paged volumes: write the
+// voxels with indices in [box->lower, box->upper) to voxels, x fastest. may be
+// called concurrently from multiple threads.
+typedef void (*VKLLoadVoxelsFunc)(void *userData,
+                                  const vkl_box3i *box,
+                                  void *voxels);
+
+// counters of volumes paging their data on demand; all zero for other volumes
+typedef struct
+{
+  uint64_t cacheHits;
+  uint64_t cacheMisses;
+  uint64_t cacheEvictions;
+  uint64_t bytesResident;
+} VKLCacheStatistics;
+
 // AMR volume interpolation methods
 typedef enum
 # if __cplusplus >= 201103L
@@ -69,6 +85,33 @@ VKLVolume vklNewVolume(const char *type);
 OPENVKL_INTERFACE
 float vklComputeSample(VKLVolume volume, const vkl_vec3f *objectCoordinates);
 
+// sample at a level of detail: 0 is the full resolution, and each further
+// level halves it. fractional levels interpolate between the two nearest
+// levels; lod is clamped to the levels the volume provides (see the mipLevels
+// parameter of structured volumes)
+OPENVKL_INTERFACE
+float vklComputeSampleLOD(VKLVolume volume,
+                          const vkl_vec3f *objectCoordinates,
+                          float lod);
+
+// sample a time-varying volume at the given time in [0, 1], overriding its
+// time parameter; volumes which do not vary in time ignore time (see
+// structured_regular_temporal volumes)
+OPENVKL_INTERFACE
+float vklComputeSampleTime(VKLVolume volume,
+                           const vkl_vec3f *objectCoordinates,
+                           float time);
+
+// sample using a hint, which locates the previous sample of the same caller:
+// for volumes made of cells (see unstructured volumes), successive nearby
+// samples (e.g. when ray marching) are then found without searching the
+// whole volume. *hint is updated on each call; initialize it to 0 for the
+// first sample. other volumes ignore hint
+OPENVKL_INTERFACE
+float vklComputeSampleHint(VKLVolume volume,
+                           const vkl_vec3f *objectCoordinates,
+                           uint64_t *hint);
+
 OPENVKL_INTERFACE
 float vklComputeSampleSeg(VKLVolume volume, const vkl_vec3f *objectCoordinates, uint8_t *segmentation);
 
@@ -90,6 +133,59 @@ void vklComputeSample16(const int *valid,
                         const vkl_vvec3f16 *objectCoordinates,
                         float *samples);
 
+// as above, additionally writing one segmentation label per lane
+OPENVKL_INTERFACE
+void vklComputeSampleSeg4(const int *valid,
+                          VKLVolume volume,
+                          const vkl_vvec3f4 *objectCoordinates,
+                          float *samples,
+                          uint8_t *segmentation);
+
+OPENVKL_INTERFACE
+void vklComputeSampleSeg8(const int *valid,
+                          VKLVolume volume,
+                          const vkl_vvec3f8 *objectCoordinates,
+                          float *samples,
+                          uint8_t *segmentation);
+
+OPENVKL_INTERFACE
+void vklComputeSampleSeg16(const int *valid,
+                           VKLVolume volume,
+                           const vkl_vvec3f16 *objectCoordinates,
+                           float *samples,
+                           uint8_t *segmentation);
+
+// sample an arbitrary number of coordinates given in SoA layout, i.e. as
+// separate x, y and z arrays of length count
+OPENVKL_INTERFACE
+void vklComputeSampleStream(VKLVolume volume,
+                            size_t count,
+                            const float *x,
+                            const float *y,
+                            const float *z,
+                            float *samples);
+
+// sample an arbitrary number of coordinates given in AoS layout
+OPENVKL_INTERFACE
+void vklComputeSampleStreamAOS(VKLVolume volume,
+                               size_t count,
+                               const vkl_vec3f *objectCoordinates,
+                               float *samples);
+
+// march numRays rays at a fixed step dt; sample j of ray i is taken at
+// origins[i] + (tStart[i] + j * dt) * directions[i]. outValues (and outLabels,
+// if not NULL) receive numRays * numSteps entries in ray-major order.
+OPENVKL_INTERFACE
+void vklSampleRays(VKLVolume volume,
+                   size_t numRays,
+                   const vkl_vec3f *origins,
+                   const vkl_vec3f *directions,
+                   const float *tStart,
+                   float dt,
+                   size_t numSteps,
+                   float *outValues,
+                   uint8_t *outLabels);
+
 OPENVKL_INTERFACE
 vkl_vec3f vklComputeGradient(VKLVolume volume,
                              const vkl_vec3f *objectCoordinates);
@@ -112,11 +208,55 @@ void vklComputeGradient16(const int *valid,
                           const vkl_vvec3f16 *objectCoordinates,
                           vkl_vvec3f16 *gradients);
 
+// compute the sample value and the gradient at the same coordinates, sharing
+// work between the two where the volume type allows it
+OPENVKL_INTERFACE
+float vklComputeSampleAndGradient(VKLVolume volume,
+                                  const vkl_vec3f *objectCoordinates,
+                                  vkl_vec3f *gradient);
+
+OPENVKL_INTERFACE
+void vklComputeSampleAndGradient4(const int *valid,
+                                  VKLVolume volume,
+                                  const vkl_vvec3f4 *objectCoordinates,
+                                  float *samples,
+                                  vkl_vvec3f4 *gradients);
+
+OPENVKL_INTERFACE
+void vklComputeSampleAndGradient8(const int *valid,
+                                  VKLVolume volume,
+                                  const vkl_vvec3f8 *objectCoordinates,
+                                  float *samples,
+                                  vkl_vvec3f8 *gradients);
+
+OPENVKL_INTERFACE
+void vklComputeSampleAndGradient16(const int *valid,
+                                   VKLVolume volume,
+                                   const vkl_vvec3f16 *objectCoordinates,
+                                   float *samples,
+                                   vkl_vvec3f16 *gradients);
+
 OPENVKL_INTERFACE
 vkl_box3f vklGetBoundingBox(VKLVolume volume);
 
 OPENVKL_INTERFACE vkl_range1f vklGetValueRange(VKLVolume volume);
 
+// counters are reset when the volume is committed
+OPENVKL_INTERFACE
+VKLCacheStatistics vklGetCacheStatistics(VKLVolume volume);
+
+// notify a committed volume that the voxels in region [lower, upper) of its
+// (shared) data have changed; derived state is updated for that region only.
+// must not be called concurrently with any other use of the volume
+OPENVKL_INTERFACE
+void vklVolumeUpdateRegion(VKLVolume volume, const vkl_box3i *region);
+
+// write the acceleration structure of a committed volume to filename, for use
+// as the "acceleratorCache" parameter of later commits of volumes with the
+// same data
+OPENVKL_INTERFACE
+void vklVolumeSerializeAccelerator(VKLVolume volume, const char *filename);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
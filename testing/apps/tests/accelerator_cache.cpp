@@ -0,0 +1,346 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include "../../external/catch.hpp"
+#include "comparison_utility.h"
+#include "openvkl_testing.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static const char *cacheFilename = "vkl_accelerator_cache_test.bin";
+
+// messages of the driver, which tell whether a cache was used
+static std::vector<std::string> logMessages;
+
+static void logFunction(const char *message)
+{
+  logMessages.push_back(message);
+}
+
+static size_t countLogMessages(const std::string &text)
+{
+  return std::count_if(
+      logMessages.begin(), logMessages.end(), [&](const std::string &m) {
+        return m.find(text) != std::string::npos;
+      });
+}
+
+// commit a copy of the testing volume with the cache written by the original
+template <typename VOLUME_TYPE>
+static void cached_matches_built(std::unique_ptr<VOLUME_TYPE> built,
+                                 std::unique_ptr<VOLUME_TYPE> loaded)
+{
+  VKLVolume builtVolume = built->getVKLVolume();
+
+  vklVolumeSerializeAccelerator(builtVolume, cacheFilename);
+
+  VKLVolume loadedVolume = loaded->getVKLVolume();
+
+  logMessages.clear();
+  vklSetString(loadedVolume, "acceleratorCache", cacheFilename);
+  vklCommit(loadedVolume);
+
+  REQUIRE(countLogMessages("using accelerator cache") == 1);
+
+  compare_volumes(loadedVolume, builtVolume);
+
+  std::remove(cacheFilename);
+}
+
+// a two level AMR volume; the AMR volume does not rebuild on recommit, so the
+// cache must be set before the first commit
+static VKLVolume newAMRVolume(const char *acceleratorCache)
+{
+  const std::vector<box3i> blockBounds{box3i(vec3i(0), vec3i(7)),
+                                       box3i(vec3i(4), vec3i(11))};
+  const std::vector<int> refinementLevels{0, 1};
+  const std::vector<float> cellWidths{1.f, 0.5f};
+
+  std::vector<VKLData> blockData;
+
+  for (int b = 0; b < 2; b++) {
+    std::vector<float> values(8 * 8 * 8);
+    for (size_t i = 0; i < values.size(); i++) {
+      values[i] = std::sin(0.1f * (i + 1) * (b + 1));
+    }
+    blockData.push_back(vklNewData(values.size(), VKL_FLOAT, values.data()));
+  }
+
+  VKLData blockDataData =
+      vklNewData(blockData.size(), VKL_DATA, blockData.data());
+  VKLData boundsData =
+      vklNewData(blockBounds.size(), VKL_BOX3I, blockBounds.data());
+  VKLData levelsData =
+      vklNewData(refinementLevels.size(), VKL_INT, refinementLevels.data());
+  VKLData widthsData =
+      vklNewData(cellWidths.size(), VKL_FLOAT, cellWidths.data());
+
+  VKLVolume volume = vklNewVolume("amr");
+  vklSetData(volume, "block.data", blockDataData);
+  vklSetData(volume, "block.bounds", boundsData);
+  vklSetData(volume, "block.level", levelsData);
+  vklSetData(volume, "cellWidth", widthsData);
+
+  if (acceleratorCache)
+    vklSetString(volume, "acceleratorCache", acceleratorCache);
+
+  vklCommit(volume);
+
+  vklRelease(blockDataData);
+  vklRelease(boundsData);
+  vklRelease(levelsData);
+  vklRelease(widthsData);
+
+  for (auto &d : blockData)
+    vklRelease(d);
+
+  return volume;
+}
+
+TEST_CASE("Accelerator cache", "[volume_accelerator_cache]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklDriverSetLogFunc(driver, logFunction);
+  vklDriverSetInt(driver, "logLevel", VKL_LOG_DEBUG);
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  SECTION("structured regular")
+  {
+    for (int macrocellSize : {4, 16}) {
+      INFO("macrocellSize = " << macrocellSize);
+
+      auto built = ospcommon::make_unique<WaveletStructuredRegularVolumeFloat>(
+          vec3i(67, 50, 33), vec3f(0.f), vec3f(1.f));
+      auto loaded = ospcommon::make_unique<WaveletStructuredRegularVolumeFloat>(
+          vec3i(67, 50, 33), vec3f(0.f), vec3f(1.f));
+
+      vklSetInt(built->getVKLVolume(), "macrocellSize", macrocellSize);
+      vklCommit(built->getVKLVolume());
+      vklSetInt(loaded->getVKLVolume(), "macrocellSize", macrocellSize);
+
+      cached_matches_built(std::move(built), std::move(loaded));
+    }
+  }
+
+  SECTION("structured spherical")
+  {
+    cached_matches_built(
+        ospcommon::make_unique<WaveletStructuredSphericalVolumeFloat>(
+            vec3i(32), vec3f(0.f), vec3f(1.f, 5.f, 10.f)),
+        ospcommon::make_unique<WaveletStructuredSphericalVolumeFloat>(
+            vec3i(32), vec3f(0.f), vec3f(1.f, 5.f, 10.f)));
+  }
+
+  SECTION("unstructured")
+  {
+    for (auto primType : {VKL_HEXAHEDRON, VKL_TETRAHEDRON, VKL_WEDGE}) {
+      INFO("primType = " << primType);
+
+      cached_matches_built(
+          ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+              vec3i(16), vec3f(0.f), vec3f(1.f), primType, true),
+          ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+              vec3i(16), vec3f(0.f), vec3f(1.f), primType, true));
+    }
+  }
+
+  SECTION("amr")
+  {
+    VKLVolume built = newAMRVolume(nullptr);
+    vklVolumeSerializeAccelerator(built, cacheFilename);
+
+    logMessages.clear();
+    VKLVolume loaded = newAMRVolume(cacheFilename);
+
+    REQUIRE(countLogMessages("using accelerator cache") == 1);
+
+    compare_volumes(loaded, built);
+
+    vklRelease(built);
+    vklRelease(loaded);
+
+    std::remove(cacheFilename);
+  }
+
+  SECTION("corrupt unstructured caches are rebuilt")
+  {
+    auto source = ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+        vec3i(16), vec3f(0.f), vec3f(1.f), VKL_HEXAHEDRON, true);
+    vklVolumeSerializeAccelerator(source->getVKLVolume(), cacheFilename);
+
+    // the BVH nodes make up most of the file; overwrite some in the middle,
+    // leaving the header intact
+    std::fstream file(cacheFilename,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileSize = file.tellg();
+
+    const std::vector<char> garbage(fileSize / 4, char(0xff));
+    file.seekp(fileSize / 3);
+    file.write(garbage.data(), garbage.size());
+    file.close();
+
+    auto corrupt = ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+        vec3i(16), vec3f(0.f), vec3f(1.f), VKL_HEXAHEDRON, true);
+
+    VKLVolume corruptVolume = corrupt->getVKLVolume();
+
+    logMessages.clear();
+    vklSetString(corruptVolume, "acceleratorCache", cacheFilename);
+    vklCommit(corruptVolume);
+
+    REQUIRE(countLogMessages("ignoring corrupt accelerator cache") == 1);
+    REQUIRE(countLogMessages("using accelerator cache") == 0);
+
+    compare_volumes(corruptVolume, source->getVKLVolume());
+
+    std::remove(cacheFilename);
+  }
+
+  SECTION("corrupt AMR caches are rebuilt")
+  {
+    VKLVolume source = newAMRVolume(nullptr);
+    vklVolumeSerializeAccelerator(source, cacheFilename);
+
+    // the first entry of the section table, after the 56 byte header, gives
+    // the offset and size of the k-d tree nodes; point them all past the
+    // leaves
+    std::fstream file(cacheFilename,
+                      std::ios::in | std::ios::out | std::ios::binary);
+
+    uint64_t nodeSection[2];
+    file.seekg(56);
+    file.read(reinterpret_cast<char *>(nodeSection), sizeof(nodeSection));
+
+    const std::vector<char> garbage(nodeSection[1], char(0xff));
+    file.seekp(nodeSection[0]);
+    file.write(garbage.data(), garbage.size());
+    file.close();
+
+    logMessages.clear();
+    VKLVolume corrupt = newAMRVolume(cacheFilename);
+
+    REQUIRE(vklDriverGetLastErrorCode(driver) == VKL_NO_ERROR);
+    REQUIRE(countLogMessages("ignoring corrupt accelerator cache") == 1);
+    REQUIRE(countLogMessages("using accelerator cache") == 0);
+
+    compare_volumes(corrupt, source);
+
+    vklRelease(source);
+    vklRelease(corrupt);
+
+    std::remove(cacheFilename);
+  }
+
+  SECTION("invalid cache files are rebuilt")
+  {
+    auto source = ospcommon::make_unique<WaveletStructuredRegularVolumeFloat>(
+        vec3i(32), vec3f(0.f), vec3f(1.f));
+    vklVolumeSerializeAccelerator(source->getVKLVolume(), cacheFilename);
+
+    std::ifstream in(cacheFilename, std::ios::binary);
+    const std::vector<char> contents((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+    in.close();
+
+    // not an accelerator cache at all; a cache cut off in its section table;
+    // and a cache claiming more sections than the file could hold
+    std::vector<std::vector<char>> invalidFiles;
+    invalidFiles.emplace_back(contents.size(), 'x');
+    invalidFiles.emplace_back(contents.begin(), contents.begin() + 72);
+    invalidFiles.push_back(contents);
+    invalidFiles.back()[12] = char(0xff);
+    invalidFiles.back()[13] = char(0xff);
+    invalidFiles.back()[14] = char(0xff);
+
+    for (const auto &invalidFile : invalidFiles) {
+      std::ofstream out(cacheFilename, std::ios::binary | std::ios::trunc);
+      out.write(invalidFile.data(), invalidFile.size());
+      out.close();
+
+      auto invalid =
+          ospcommon::make_unique<WaveletStructuredRegularVolumeFloat>(
+              vec3i(32), vec3f(0.f), vec3f(1.f));
+
+      VKLVolume invalidVolume = invalid->getVKLVolume();
+
+      logMessages.clear();
+      vklSetString(invalidVolume, "acceleratorCache", cacheFilename);
+      vklCommit(invalidVolume);
+
+      REQUIRE(vklDriverGetLastErrorCode(driver) == VKL_NO_ERROR);
+      REQUIRE(countLogMessages("rebuilding") == 1);
+      REQUIRE(countLogMessages("using accelerator cache") == 0);
+
+      compare_volumes(invalidVolume, source->getVKLVolume());
+    }
+
+    std::remove(cacheFilename);
+  }
+
+  SECTION("mismatched caches are ignored")
+  {
+    auto source = ospcommon::make_unique<WaveletStructuredRegularVolumeFloat>(
+        vec3i(32), vec3f(0.f), vec3f(1.f));
+    vklVolumeSerializeAccelerator(source->getVKLVolume(), cacheFilename);
+
+    // different voxels
+    auto other = ospcommon::make_unique<XYZStructuredRegularVolume<float>>(
+        vec3i(32), vec3f(0.f), vec3f(1.f));
+    auto reference = ospcommon::make_unique<XYZStructuredRegularVolume<float>>(
+        vec3i(32), vec3f(0.f), vec3f(1.f));
+
+    VKLVolume otherVolume = other->getVKLVolume();
+
+    logMessages.clear();
+    vklSetString(otherVolume, "acceleratorCache", cacheFilename);
+    vklCommit(otherVolume);
+
+    REQUIRE(countLogMessages("does not match the volume") == 1);
+    REQUIRE(countLogMessages("using accelerator cache") == 0);
+
+    compare_volumes(otherVolume, reference->getVKLVolume());
+
+    // different volume type
+    auto unstructured =
+        ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+            vec3i(16), vec3f(0.f), vec3f(1.f), VKL_HEXAHEDRON, true);
+    auto unstructuredReference =
+        ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+            vec3i(16), vec3f(0.f), vec3f(1.f), VKL_HEXAHEDRON, true);
+
+    VKLVolume unstructuredVolume = unstructured->getVKLVolume();
+
+    logMessages.clear();
+    vklSetString(unstructuredVolume, "acceleratorCache", cacheFilename);
+    vklCommit(unstructuredVolume);
+
+    REQUIRE(countLogMessages("does not match the volume") == 1);
+    REQUIRE(countLogMessages("using accelerator cache") == 0);
+
+    compare_volumes(unstructuredVolume, unstructuredReference->getVKLVolume());
+
+    std::remove(cacheFilename);
+  }
+}
@@ -0,0 +1,139 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+// a single level AMR volume of two side by side blocks, with cell values
+// linear in the position of the cell centers; all methods reproduce the linear
+// function in the interior, so gradients are known exactly
+static VKLVolume newLinearAMRVolume(const vec3f &slope,
+                                    const vec3f &gridSpacing,
+                                    VKLAMRMethod method)
+{
+  const std::vector<box3i> blockBounds{box3i(vec3i(0), vec3i(7)),
+                                       box3i(vec3i(8, 0, 0), vec3i(15, 7, 7))};
+  const std::vector<int> refinementLevels{0, 0};
+  const std::vector<float> cellWidths{1.f};
+
+  std::vector<VKLData> blockData;
+
+  for (const auto &bounds : blockBounds) {
+    std::vector<float> values;
+
+    for (int z = bounds.lower.z; z <= bounds.upper.z; z++)
+      for (int y = bounds.lower.y; y <= bounds.upper.y; y++)
+        for (int x = bounds.lower.x; x <= bounds.upper.x; x++)
+          values.push_back(dot(slope, vec3f(x, y, z) + 0.5f));
+
+    blockData.push_back(vklNewData(values.size(), VKL_FLOAT, values.data()));
+  }
+
+  VKLData blockDataData =
+      vklNewData(blockData.size(), VKL_DATA, blockData.data());
+  VKLData boundsData =
+      vklNewData(blockBounds.size(), VKL_BOX3I, blockBounds.data());
+  VKLData levelsData =
+      vklNewData(refinementLevels.size(), VKL_INT, refinementLevels.data());
+  VKLData widthsData =
+      vklNewData(cellWidths.size(), VKL_FLOAT, cellWidths.data());
+
+  VKLVolume volume = vklNewVolume("amr");
+  vklSetData(volume, "block.data", blockDataData);
+  vklSetData(volume, "block.bounds", boundsData);
+  vklSetData(volume, "block.level", levelsData);
+  vklSetData(volume, "cellWidth", widthsData);
+  vklSetVec3f(
+      volume, "gridSpacing", gridSpacing.x, gridSpacing.y, gridSpacing.z);
+  vklSetInt(volume, "method", method);
+  vklCommit(volume);
+
+  vklRelease(blockDataData);
+  vklRelease(boundsData);
+  vklRelease(levelsData);
+  vklRelease(widthsData);
+
+  for (auto &d : blockData)
+    vklRelease(d);
+
+  return volume;
+}
+
+void linear_gradients(VKLAMRMethod method)
+{
+  const vec3f slope(1.f, -2.f, 3.f);
+  const vec3f gridSpacing(1.f, 2.f, 0.5f);
+
+  VKLVolume volume = newLinearAMRVolume(slope, gridSpacing, method);
+
+  // gradients are in object space
+  const vec3f expected = slope / gridSpacing;
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  // away from the boundary, where values are clamped, but across the block
+  // boundary at x = 8
+  std::uniform_real_distribution<float> distX(2.f, 14.f);
+  std::uniform_real_distribution<float> distYZ(2.f, 6.f);
+
+  for (int i = 0; i < 1000; i++) {
+    const vec3f local(distX(eng), distYZ(eng), distYZ(eng));
+    const vec3f objectCoordinates = local * gridSpacing;
+
+    INFO("objectCoordinates = " << objectCoordinates.x << " "
+                                << objectCoordinates.y << " "
+                                << objectCoordinates.z);
+
+    const vkl_vec3f vklGradient =
+        vklComputeGradient(volume, (const vkl_vec3f *)&objectCoordinates);
+    const vec3f gradient = (const vec3f &)vklGradient;
+
+    REQUIRE(gradient.x == Approx(expected.x).epsilon(1e-3f));
+    REQUIRE(gradient.y == Approx(expected.y).epsilon(1e-3f));
+    REQUIRE(gradient.z == Approx(expected.z).epsilon(1e-3f));
+  }
+
+  vklRelease(volume);
+}
+
+TEST_CASE("AMR volume gradients", "[volume_gradients]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  SECTION("current")
+  {
+    linear_gradients(VKL_AMR_CURRENT);
+  }
+
+  SECTION("finest")
+  {
+    linear_gradients(VKL_AMR_FINEST);
+  }
+
+  SECTION("octant")
+  {
+    linear_gradients(VKL_AMR_OCTANT);
+  }
+}
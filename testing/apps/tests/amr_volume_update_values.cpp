@@ -0,0 +1,219 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "../../external/catch.hpp"
+#include "comparison_utility.h"
+#include "openvkl_testing.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+// a two level AMR volume over [0, 16]^3, refined by a factor of two in
+// [4, 12]^3
+static const std::vector<box3i> blockBounds{box3i(vec3i(0), vec3i(7)),
+                                            box3i(vec3i(4), vec3i(11))};
+static const std::vector<int> refinementLevels{0, 1};
+static const std::vector<float> cellWidths{2.f, 1.f};
+
+// debug messages of the driver, which tell whether the k-d tree was kept
+static std::vector<std::string> logMessages;
+
+static void logFunction(const char *message)
+{
+  logMessages.push_back(message);
+}
+
+static size_t countLogMessages(const std::string &text)
+{
+  return std::count_if(
+      logMessages.begin(), logMessages.end(), [&](const std::string &m) {
+        return m.find(text) != std::string::npos;
+      });
+}
+
+// one array of values per block, sampling f at the cell centers
+template <typename VOXEL_TYPE>
+static VKLData newBlockData(const std::function<float(const vec3f &)> &f,
+                            VKLDataType dataType)
+{
+  std::vector<VKLData> blockData;
+
+  for (size_t b = 0; b < blockBounds.size(); b++) {
+    const box3i &bounds   = blockBounds[b];
+    const float cellWidth = cellWidths[refinementLevels[b]];
+
+    std::vector<VOXEL_TYPE> values;
+
+    for (int z = bounds.lower.z; z <= bounds.upper.z; z++)
+      for (int y = bounds.lower.y; y <= bounds.upper.y; y++)
+        for (int x = bounds.lower.x; x <= bounds.upper.x; x++)
+          values.push_back(f((vec3f(x, y, z) + 0.5f) * cellWidth));
+
+    blockData.push_back(vklNewData(values.size(), dataType, values.data()));
+  }
+
+  VKLData blockDataData =
+      vklNewData(blockData.size(), VKL_DATA, blockData.data());
+
+  for (auto &d : blockData)
+    vklRelease(d);
+
+  return blockDataData;
+}
+
+// setParameters, if given, sets further parameters before the commit
+static VKLVolume newAMRVolume(
+    VKLData boundsData,
+    VKLData levelsData,
+    VKLData widthsData,
+    VKLData blockDataData,
+    const std::function<void(VKLVolume)> &setParameters = nullptr)
+{
+  VKLVolume volume = vklNewVolume("amr");
+  vklSetData(volume, "block.data", blockDataData);
+  vklSetData(volume, "block.bounds", boundsData);
+  vklSetData(volume, "block.level", levelsData);
+  vklSetData(volume, "cellWidth", widthsData);
+
+  if (setParameters)
+    setParameters(volume);
+
+  vklCommit(volume);
+
+  return volume;
+}
+
+// a volume committed again with only new block data, so that only its leaf
+// value ranges are recomputed, must match one committed from scratch on the
+// same data
+template <typename VOXEL_TYPE>
+void update_matches_committed(VKLDataType dataType)
+{
+  VKLData boundsData =
+      vklNewData(blockBounds.size(), VKL_BOX3I, blockBounds.data());
+  VKLData levelsData =
+      vklNewData(refinementLevels.size(), VKL_INT, refinementLevels.data());
+  VKLData widthsData =
+      vklNewData(cellWidths.size(), VKL_FLOAT, cellWidths.data());
+
+  auto firstStep = [](const vec3f &p) { return p.x; };
+  auto nextStep  = [](const vec3f &p) {
+    return std::floor(16.f * std::sin(0.3f * p.x) * std::cos(0.2f * p.z));
+  };
+
+  VKLData firstData = newBlockData<float>(firstStep, VKL_FLOAT);
+  VKLData nextData  = newBlockData<VOXEL_TYPE>(nextStep, dataType);
+  VKLData truthData = newBlockData<VOXEL_TYPE>(nextStep, dataType);
+
+  VKLVolume volume =
+      newAMRVolume(boundsData, levelsData, widthsData, firstData);
+  VKLVolume truthVolume =
+      newAMRVolume(boundsData, levelsData, widthsData, truthData);
+
+  logMessages.clear();
+  vklSetData(volume, "block.data", nextData);
+  vklCommit(volume);
+
+  REQUIRE(countLogMessages("keeping the AMR volume k-d tree") == 1);
+
+  vklRelease(firstData);
+  vklRelease(nextData);
+  vklRelease(truthData);
+  vklRelease(boundsData);
+  vklRelease(levelsData);
+  vklRelease(widthsData);
+
+  compare_volumes(volume, truthVolume);
+
+  vklRelease(volume);
+  vklRelease(truthVolume);
+}
+
+// a volume committed again with a new grid transform or method, which keeps
+// its k-d tree, must match one committed from scratch with them
+void recommit_matches_committed(
+    const std::function<void(VKLVolume)> &setParameters)
+{
+  VKLData boundsData =
+      vklNewData(blockBounds.size(), VKL_BOX3I, blockBounds.data());
+  VKLData levelsData =
+      vklNewData(refinementLevels.size(), VKL_INT, refinementLevels.data());
+  VKLData widthsData =
+      vklNewData(cellWidths.size(), VKL_FLOAT, cellWidths.data());
+
+  VKLData blockData = newBlockData<float>(
+      [](const vec3f &p) { return std::sin(0.3f * p.x) * p.y; }, VKL_FLOAT);
+
+  VKLVolume volume =
+      newAMRVolume(boundsData, levelsData, widthsData, blockData);
+  VKLVolume truthVolume = newAMRVolume(
+      boundsData, levelsData, widthsData, blockData, setParameters);
+
+  logMessages.clear();
+  setParameters(volume);
+  vklCommit(volume);
+
+  REQUIRE(countLogMessages("keeping the AMR volume k-d tree") == 1);
+
+  vklRelease(blockData);
+  vklRelease(boundsData);
+  vklRelease(levelsData);
+  vklRelease(widthsData);
+
+  compare_volumes(volume, truthVolume);
+
+  vklRelease(volume);
+  vklRelease(truthVolume);
+}
+
+TEST_CASE("AMR volume data updates", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklDriverSetLogFunc(driver, logFunction);
+  vklDriverSetInt(driver, "logLevel", VKL_LOG_DEBUG);
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  SECTION("float data")
+  {
+    update_matches_committed<float>(VKL_FLOAT);
+  }
+
+  SECTION("data of another voxel type")
+  {
+    update_matches_committed<double>(VKL_DOUBLE);
+  }
+
+  SECTION("new grid transform")
+  {
+    recommit_matches_committed([](VKLVolume volume) {
+      vklSetVec3f(volume, "gridOrigin", -3.f, 1.f, 2.f);
+      vklSetVec3f(volume, "gridSpacing", 0.5f, 2.f, 1.f);
+    });
+  }
+
+  SECTION("new method")
+  {
+    recommit_matches_committed([](VKLVolume volume) {
+      vklSetInt(volume, "method", VKL_AMR_FINEST);
+    });
+  }
+}
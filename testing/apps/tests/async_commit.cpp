@@ -0,0 +1,201 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static void commitAsyncAndWait(VKLVolume volume)
+{
+  VKLFence fence = vklCommitAsync(volume);
+  REQUIRE(fence != nullptr);
+
+  vklWait(fence);
+  REQUIRE(vklIsReady(fence) == 1);
+
+  vklRelease(fence);
+}
+
+TEST_CASE("Asynchronous volume commit", "[volume_commit]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  const vec3i dimensions(64);
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume volume = v->getVKLVolume();
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> dist(0.f, dimensions.x - 1.f);
+
+  std::vector<vec3f> objectCoordinates;
+  std::vector<float> samples;
+
+  for (int i = 0; i < 1000; i++) {
+    const vec3f oc(dist(eng), dist(eng), dist(eng));
+    objectCoordinates.push_back(oc);
+    samples.push_back(vklComputeSample(volume, (const vkl_vec3f *)&oc));
+  }
+
+  SECTION("committed state matches a synchronous commit")
+  {
+    const vec3f gridOrigin(10.f, -5.f, 2.f);
+
+    vklSetVec3f(
+        volume, "gridOrigin", gridOrigin.x, gridOrigin.y, gridOrigin.z);
+    commitAsyncAndWait(volume);
+
+    const vkl_box3f bbox = vklGetBoundingBox(volume);
+    REQUIRE(bbox.lower.x == gridOrigin.x);
+    REQUIRE(bbox.lower.y == gridOrigin.y);
+    REQUIRE(bbox.lower.z == gridOrigin.z);
+
+    for (size_t i = 0; i < objectCoordinates.size(); i++) {
+      const vec3f oc = objectCoordinates[i] + gridOrigin;
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+      REQUIRE(samples[i] == vklComputeSample(volume, (const vkl_vec3f *)&oc));
+    }
+
+    // a synchronous commit makes the volume's own state current again
+    vklSetVec3f(volume, "gridOrigin", 0.f, 0.f, 0.f);
+    vklCommit(volume);
+
+    REQUIRE(vklGetBoundingBox(volume).lower.x == 0.f);
+  }
+
+  SECTION("parameters are snapshot when the commit is issued")
+  {
+    vklSetVec3f(volume, "gridOrigin", 1.f, 1.f, 1.f);
+    VKLFence fence1 = vklCommitAsync(volume);
+
+    vklSetVec3f(volume, "gridOrigin", 2.f, 2.f, 2.f);
+    VKLFence fence2 = vklCommitAsync(volume);
+
+    // changed after the last commit, and must not be picked up
+    vklSetVec3f(volume, "gridOrigin", 3.f, 3.f, 3.f);
+
+    vklWait(fence2);
+    vklWait(fence1);
+
+    // the most recently issued commit wins, whatever the completion order
+    REQUIRE(vklGetBoundingBox(volume).lower.x == 2.f);
+
+    vklRelease(fence1);
+    vklRelease(fence2);
+  }
+
+  SECTION("queries use the previous state until the commit completes")
+  {
+    vklSetVec3f(volume, "gridOrigin", 100.f, 100.f, 100.f);
+    VKLFence fence = vklCommitAsync(volume);
+
+    // either state may be current while the commit is in flight, but never
+    // a partially committed one
+    while (!vklIsReady(fence)) {
+      const float lower = vklGetBoundingBox(volume).lower.x;
+      REQUIRE((lower == 0.f || lower == 100.f));
+    }
+
+    vklWait(fence);
+    vklRelease(fence);
+
+    REQUIRE(vklGetBoundingBox(volume).lower.x == 100.f);
+  }
+
+  SECTION("continuous queries do not hold back commits")
+  {
+    std::atomic<bool> done{false};
+    std::atomic<int> badSamples{0};
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&]() {
+        while (!done.load()) {
+          // the state may change in between, but the position stays inside
+          // all of them
+          const vkl_box3f bbox = vklGetBoundingBox(volume);
+          const vec3f oc =
+              vec3f(bbox.lower.x, bbox.lower.y, bbox.lower.z) + 32.f;
+
+          const float sample =
+              vklComputeSample(volume, (const vkl_vec3f *)&oc);
+
+          if (!std::isfinite(sample))
+            badSamples++;
+        }
+      });
+    }
+
+    // every swap after the first replaces an asynchronously committed state
+    for (int i = 1; i <= 8; i++) {
+      vklSetVec3f(volume, "gridOrigin", float(i), float(i), float(i));
+      commitAsyncAndWait(volume);
+
+      REQUIRE(vklGetBoundingBox(volume).lower.x == float(i));
+    }
+
+    done = true;
+
+    for (auto &thread : threads)
+      thread.join();
+
+    REQUIRE(badSamples == 0);
+  }
+
+  SECTION("errors are reported when waiting")
+  {
+    VKLVolume emptyVolume = vklNewVolume("structured_regular");
+    VKLFence fence        = vklCommitAsync(emptyVolume);
+
+    vklWait(fence);
+    REQUIRE(vklIsReady(fence) == 1);
+    REQUIRE(vklDriverGetLastErrorCode(driver) != VKL_NO_ERROR);
+
+    vklRelease(fence);
+    vklRelease(emptyVolume);
+  }
+
+  SECTION("other objects are committed immediately")
+  {
+    VKLValueSelector selector = vklNewValueSelector(volume);
+
+    const vkl_range1f range{0.f, 1.f};
+    vklValueSelectorSetRanges(selector, 1, &range);
+
+    VKLFence fence = vklCommitAsync(selector);
+    REQUIRE(vklIsReady(fence) == 1);
+
+    vklRelease(fence);
+    vklRelease(selector);
+  }
+}
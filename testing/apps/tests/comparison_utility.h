@@ -0,0 +1,112 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <cmath>
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+
+// volume must give the same bounding box, value range, samples, and
+// intervals for a value selector as truth, e.g. after an update of its values
+// compared to a volume committed from scratch on the same values. samples and
+// rays are taken around the bounding box of truth
+inline void compare_volumes(VKLVolume volume, VKLVolume truth)
+{
+  const vkl_box3f bbox      = vklGetBoundingBox(truth);
+  const vkl_box3f volumeBox = vklGetBoundingBox(volume);
+
+  REQUIRE(volumeBox.lower.x == bbox.lower.x);
+  REQUIRE(volumeBox.lower.y == bbox.lower.y);
+  REQUIRE(volumeBox.lower.z == bbox.lower.z);
+  REQUIRE(volumeBox.upper.x == bbox.upper.x);
+  REQUIRE(volumeBox.upper.y == bbox.upper.y);
+  REQUIRE(volumeBox.upper.z == bbox.upper.z);
+
+  const vkl_range1f valueRange      = vklGetValueRange(volume);
+  const vkl_range1f truthValueRange = vklGetValueRange(truth);
+
+  REQUIRE(valueRange.lower == truthValueRange.lower);
+  REQUIRE(valueRange.upper == truthValueRange.upper);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(bbox.lower.x - 1.f,
+                                              bbox.upper.x + 1.f);
+  std::uniform_real_distribution<float> distY(bbox.lower.y - 1.f,
+                                              bbox.upper.y + 1.f);
+  std::uniform_real_distribution<float> distZ(bbox.lower.z - 1.f,
+                                              bbox.upper.z + 1.f);
+
+  for (int i = 0; i < 1000; i++) {
+    const vkl_vec3f oc{distX(eng), distY(eng), distZ(eng)};
+
+    INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+    const float sample      = vklComputeSample(volume, &oc);
+    const float truthSample = vklComputeSample(truth, &oc);
+
+    REQUIRE(((std::isnan(sample) && std::isnan(truthSample)) ||
+             sample == truthSample));
+  }
+
+  // intervals depend on the value ranges in the accelerator
+  VKLValueSelector selector      = vklNewValueSelector(volume);
+  VKLValueSelector truthSelector = vklNewValueSelector(truth);
+
+  const float mid = 0.5f * (valueRange.lower + valueRange.upper);
+  const vkl_range1f selectorRange{mid, valueRange.upper};
+
+  vklValueSelectorSetRanges(selector, 1, &selectorRange);
+  vklValueSelectorSetRanges(truthSelector, 1, &selectorRange);
+  vklCommit(selector);
+  vklCommit(truthSelector);
+
+  std::uniform_real_distribution<float> distDir(-1.f, 1.f);
+
+  for (int i = 0; i < 100; i++) {
+    const vkl_vec3f origin{distX(eng), distY(eng), distZ(eng)};
+    const vkl_vec3f direction{distDir(eng), distDir(eng), distDir(eng)};
+    const vkl_range1f tRange{0.f, inf};
+
+    VKLIntervalIterator iterator, truthIterator;
+    vklInitIntervalIterator(
+        &iterator, volume, &origin, &direction, &tRange, selector);
+    vklInitIntervalIterator(
+        &truthIterator, truth, &origin, &direction, &tRange, truthSelector);
+
+    VKLInterval interval, truthInterval;
+
+    while (true) {
+      const int result = vklIterateInterval(&iterator, &interval);
+      REQUIRE(result == vklIterateInterval(&truthIterator, &truthInterval));
+
+      if (!result) {
+        break;
+      }
+
+      REQUIRE(interval.tRange.lower == truthInterval.tRange.lower);
+      REQUIRE(interval.tRange.upper == truthInterval.tRange.upper);
+      REQUIRE(interval.valueRange.lower == truthInterval.valueRange.lower);
+      REQUIRE(interval.valueRange.upper == truthInterval.valueRange.upper);
+    }
+  }
+
+  vklRelease(selector);
+  vklRelease(truthSelector);
+}
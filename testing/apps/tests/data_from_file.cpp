@@ -0,0 +1,163 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+// a mapped volume must sample identically to one created from a copy of the
+// same voxels
+template <typename VOXEL_TYPE>
+void mapped_matches_copied(const vec3i &dimensions, size_t headerBytes)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<VOXEL_TYPE>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume copiedVolume = v->getVKLVolume();
+
+  std::vector<unsigned char> voxels = v->generateVoxels();
+
+  const std::string filename = "vkl_data_from_file_test.raw";
+
+  {
+    std::ofstream output(filename, std::ios::binary);
+    std::vector<char> header(headerBytes, 'x');
+    output.write(header.data(), header.size());
+    output.write((const char *)voxels.data(), voxels.size());
+  }
+
+  const VKLDataType voxelType = getVKLDataType<VOXEL_TYPE>();
+
+  VKLData data = vklNewDataFromFile(
+      filename.c_str(), headerBytes, dimensions.long_product(), voxelType);
+
+  REQUIRE(data != nullptr);
+
+  VKLVolume mappedVolume = vklNewVolume("structured_regular");
+  vklSetVec3i(
+      mappedVolume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+  vklSetVec3f(mappedVolume, "gridOrigin", 0.f, 0.f, 0.f);
+  vklSetVec3f(mappedVolume, "gridSpacing", 1.f, 1.f, 1.f);
+  vklSetData(mappedVolume, "data", data);
+  vklCommit(mappedVolume);
+
+  vklRelease(data);
+
+  const vkl_range1f copiedRange = vklGetValueRange(copiedVolume);
+  const vkl_range1f mappedRange = vklGetValueRange(mappedVolume);
+
+  REQUIRE(copiedRange.lower == mappedRange.lower);
+  REQUIRE(copiedRange.upper == mappedRange.upper);
+
+  multidim_index_sequence<3> mis(dimensions);
+
+  for (const auto &offset : mis) {
+    const vec3f oc = v->transformLocalToObjectCoordinates(offset);
+
+    INFO("offset = " << offset.x << " " << offset.y << " " << offset.z);
+
+    REQUIRE(vklComputeSample(copiedVolume, (const vkl_vec3f *)&oc) ==
+            vklComputeSample(mappedVolume, (const vkl_vec3f *)&oc));
+  }
+
+  vklRelease(mappedVolume);
+
+  // a file too small for the requested items is rejected
+  VKLData tooLarge = vklNewDataFromFile(
+      filename.c_str(), headerBytes + 1, dimensions.long_product(), voxelType);
+
+  REQUIRE(tooLarge == nullptr);
+
+  // offsets and sizes whose sum wraps around are rejected as well
+  VKLData wrappedOffset = vklNewDataFromFile(filename.c_str(),
+                                             size_t(-1) - sizeof(VOXEL_TYPE),
+                                             2,
+                                             voxelType);
+
+  REQUIRE(wrappedOffset == nullptr);
+
+  VKLData wrappedSize = vklNewDataFromFile(filename.c_str(),
+                                           headerBytes,
+                                           size_t(-1) / sizeof(VOXEL_TYPE),
+                                           voxelType);
+
+  REQUIRE(wrappedSize == nullptr);
+
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Data from file", "[data]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  SECTION("missing file")
+  {
+    REQUIRE(vklNewDataFromFile("vkl_missing_file.raw", 0, 1, VKL_FLOAT) ==
+            nullptr);
+  }
+
+  SECTION("item counts whose byte size overflows")
+  {
+    const std::string filename = "vkl_data_from_file_overflow_test.raw";
+
+    {
+      std::ofstream output(filename, std::ios::binary);
+      std::vector<char> bytes(64, 'x');
+      output.write(bytes.data(), bytes.size());
+    }
+
+    // the byte sizes wrap around to 4 and 8 bytes, which fit in the file
+    REQUIRE(vklNewDataFromFile(
+                filename.c_str(), 0, (size_t(1) << 62) + 1, VKL_FLOAT) ==
+            nullptr);
+    REQUIRE(vklNewDataFromFile(
+                filename.c_str(), 0, (size_t(1) << 61) + 1, VKL_DOUBLE) ==
+            nullptr);
+
+    // requests of those byte sizes are accepted
+    VKLData data = vklNewDataFromFile(filename.c_str(), 0, 2, VKL_FLOAT);
+    REQUIRE(data != nullptr);
+    vklRelease(data);
+
+    std::remove(filename.c_str());
+  }
+
+  // header sizes that are / are not multiples of the page size or voxel size
+  SECTION("unsigned char, unaligned header")
+  {
+    mapped_matches_copied<unsigned char>(vec3i(31), 17);
+  }
+
+  SECTION("float, page sized header")
+  {
+    mapped_matches_copied<float>(vec3i(32), 4096);
+  }
+
+  SECTION("double, unaligned header")
+  {
+    mapped_matches_copied<double>(vec3i(20, 33, 9), 4100);
+  }
+}
@@ -20,9 +20,11 @@
 using namespace ospcommon;
 using namespace openvkl::testing;
 
-void scalar_hit_iteration(VKLVolume volume, const std::vector<float> &isoValues)
+void scalar_hit_iteration(
+    VKLVolume volume,
+    const std::vector<float> &isoValues,
+    const vkl_vec3f &origin = vkl_vec3f{0.5f, 0.5f, -1.f})
 {
-  vkl_vec3f origin{0.5f, 0.5f, -1.f};
   vkl_vec3f direction{0.f, 0.f, 1.f};
   vkl_range1f tRange{0.f, inf};
 
@@ -52,6 +54,58 @@ void scalar_hit_iteration(VKLVolume volume, const std::vector<float> &isoValues)
   REQUIRE(hitCount == isoValues.size());
 }
 
+// a two level AMR volume over [0, 16]^3 with values equal to z, refined by a
+// factor of two in [4, 12]^3
+static VKLVolume newZAMRVolume()
+{
+  const std::vector<box3i> blockBounds{box3i(vec3i(0), vec3i(7)),
+                                       box3i(vec3i(4), vec3i(11))};
+  const std::vector<int> refinementLevels{0, 1};
+  const std::vector<float> cellWidths{2.f, 1.f};
+
+  std::vector<VKLData> blockData;
+
+  for (size_t b = 0; b < blockBounds.size(); b++) {
+    const box3i &bounds   = blockBounds[b];
+    const float cellWidth = cellWidths[refinementLevels[b]];
+
+    std::vector<float> values;
+
+    for (int z = bounds.lower.z; z <= bounds.upper.z; z++)
+      for (int y = bounds.lower.y; y <= bounds.upper.y; y++)
+        for (int x = bounds.lower.x; x <= bounds.upper.x; x++)
+          values.push_back((z + 0.5f) * cellWidth);
+
+    blockData.push_back(vklNewData(values.size(), VKL_FLOAT, values.data()));
+  }
+
+  VKLData blockDataData =
+      vklNewData(blockData.size(), VKL_DATA, blockData.data());
+  VKLData boundsData =
+      vklNewData(blockBounds.size(), VKL_BOX3I, blockBounds.data());
+  VKLData levelsData =
+      vklNewData(refinementLevels.size(), VKL_INT, refinementLevels.data());
+  VKLData widthsData =
+      vklNewData(cellWidths.size(), VKL_FLOAT, cellWidths.data());
+
+  VKLVolume volume = vklNewVolume("amr");
+  vklSetData(volume, "block.data", blockDataData);
+  vklSetData(volume, "block.bounds", boundsData);
+  vklSetData(volume, "block.level", levelsData);
+  vklSetData(volume, "cellWidth", widthsData);
+  vklCommit(volume);
+
+  vklRelease(blockDataData);
+  vklRelease(boundsData);
+  vklRelease(levelsData);
+  vklRelease(widthsData);
+
+  for (auto &d : blockData)
+    vklRelease(d);
+
+  return volume;
+}
+
 TEST_CASE("Hit iterator", "[hit_iterators]")
 {
   vklLoadModule("ispc_driver");
@@ -113,5 +167,22 @@ TEST_CASE("Hit iterator", "[hit_iterators]")
 
       scalar_hit_iteration(vklVolume, defaultIsoValues);
     }
+
+    SECTION("AMR volumes")
+    {
+      VKLVolume vklVolume = newZAMRVolume();
+
+      // in the coarse and fine levels, away from the transitions between
+      // them where the interpolation is not linear
+      const std::vector<float> isoValues{1.5f, 2.5f, 6.f, 8.25f, 10.5f, 13.5f};
+
+      // through the refined region
+      scalar_hit_iteration(vklVolume, isoValues, vkl_vec3f{5.5f, 6.5f, -1.f});
+
+      // through the coarse level only
+      scalar_hit_iteration(vklVolume, isoValues, vkl_vec3f{1.5f, 14.5f, -1.f});
+
+      vklRelease(vklVolume);
+    }
   }
 }
@@ -14,6 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <random>
 #include "../../external/catch.hpp"
 #include "iterator_utility.h"
 #include "openvkl_testing.h"
@@ -217,6 +218,144 @@ void scalar_interval_nominalDeltaT(VKLVolume volume,
   REQUIRE(interval.nominalDeltaT == Approx(expectedNominalDeltaT));
 }
 
+// intervals found with a value selector must be exactly those found without,
+// which overlap the selector's ranges; exercises skipping of empty regions
+void scalar_interval_value_selector_skipping(VKLVolume volume,
+                                             const vkl_range1f &valueRange)
+{
+  const vkl_box3f bbox = vklGetBoundingBox(volume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+  std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+  std::uniform_real_distribution<float> distDir(-1.f, 1.f);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(volume);
+  vklValueSelectorSetRanges(valueSelector, 1, &valueRange);
+  vklCommit(valueSelector);
+
+  for (int i = 0; i < 1000; i++) {
+    // rays entering through the lower or upper z face, in any direction
+    const bool up = i % 2 == 0;
+
+    vkl_vec3f origin{
+        distX(eng), distY(eng), up ? bbox.lower.z - 1.f : bbox.upper.z + 1.f};
+    vkl_vec3f direction{distDir(eng), distDir(eng), up ? 1.f : -1.f};
+    vkl_range1f tRange{0.f, inf};
+
+    INFO("origin = " << origin.x << " " << origin.y << " " << origin.z
+                     << " direction = " << direction.x << " " << direction.y
+                     << " " << direction.z);
+
+    std::vector<VKLInterval> expected;
+
+    VKLIntervalIterator iterator;
+    vklInitIntervalIterator(
+        &iterator, volume, &origin, &direction, &tRange, nullptr);
+
+    VKLInterval interval;
+
+    while (vklIterateInterval(&iterator, &interval)) {
+      if (rangesIntersect(valueRange, interval.valueRange)) {
+        expected.push_back(interval);
+      }
+    }
+
+    vklInitIntervalIterator(
+        &iterator, volume, &origin, &direction, &tRange, valueSelector);
+
+    size_t intervalCount = 0;
+
+    while (vklIterateInterval(&iterator, &interval)) {
+      REQUIRE(intervalCount < expected.size());
+
+      const VKLInterval &e = expected[intervalCount];
+
+      REQUIRE(interval.tRange.lower == Approx(e.tRange.lower));
+      REQUIRE(interval.tRange.upper == Approx(e.tRange.upper));
+      REQUIRE(interval.valueRange.lower == e.valueRange.lower);
+      REQUIRE(interval.valueRange.upper == e.valueRange.upper);
+
+      intervalCount++;
+    }
+
+    REQUIRE(intervalCount == expected.size());
+  }
+
+  vklRelease(valueSelector);
+}
+
+// a ray through all refinement levels of an AMR volume: intervals are the
+// k-d tree leaves along the ray, and their value ranges must bound the samples
+// within them. with a value selector, only the intervals overlapping its
+// ranges remain
+void scalar_interval_amr_value_ranges(VKLVolume volume,
+                                      const vkl_vec3f &origin,
+                                      const vkl_range1f &selectedRange)
+{
+  const vkl_vec3f direction{0.f, 0.f, 1.f};
+  const vkl_range1f tRange{0.f, inf};
+
+  VKLValueSelector valueSelector = vklNewValueSelector(volume);
+  vklValueSelectorSetRanges(valueSelector, 1, &selectedRange);
+  vklCommit(valueSelector);
+
+  std::vector<VKLInterval> selected;
+
+  VKLIntervalIterator iterator;
+  vklInitIntervalIterator(
+      &iterator, volume, &origin, &direction, &tRange, nullptr);
+
+  VKLInterval interval;
+
+  while (vklIterateInterval(&iterator, &interval)) {
+    INFO("interval tRange = " << interval.tRange.lower << ", "
+                              << interval.tRange.upper
+                              << " valueRange = " << interval.valueRange.lower
+                              << ", " << interval.valueRange.upper);
+
+    const vkl_range1f sampledValueRange =
+        computeIntervalValueRange(volume, origin, direction, interval.tRange);
+
+    INFO("sampled value range = " << sampledValueRange.lower << ", "
+                                  << sampledValueRange.upper);
+
+    REQUIRE(sampledValueRange.lower >= Approx(interval.valueRange.lower));
+    REQUIRE(sampledValueRange.upper <= Approx(interval.valueRange.upper));
+
+    if (rangesIntersect(selectedRange, interval.valueRange))
+      selected.push_back(interval);
+  }
+
+  // the ray passes through the finest level
+  REQUIRE(!selected.empty());
+
+  vklInitIntervalIterator(
+      &iterator, volume, &origin, &direction, &tRange, valueSelector);
+
+  size_t intervalCount = 0;
+
+  while (vklIterateInterval(&iterator, &interval)) {
+    REQUIRE(intervalCount < selected.size());
+
+    const VKLInterval &s = selected[intervalCount];
+
+    REQUIRE(interval.tRange.lower == s.tRange.lower);
+    REQUIRE(interval.tRange.upper == s.tRange.upper);
+    REQUIRE(interval.valueRange.lower == s.valueRange.lower);
+    REQUIRE(interval.valueRange.upper == s.valueRange.upper);
+    REQUIRE(interval.nominalDeltaT == s.nominalDeltaT);
+
+    intervalCount++;
+  }
+
+  REQUIRE(intervalCount == selected.size());
+
+  vklRelease(valueSelector);
+}
+
 TEST_CASE("Interval iterator", "[interval_iterators]")
 {
   vklLoadModule("ispc_driver");
@@ -253,6 +392,48 @@ TEST_CASE("Interval iterator", "[interval_iterators]")
     }
   }
 
+  SECTION("structured volumes: value selector skipping empty regions")
+  {
+    // values are the z coordinate, so that most of the volume is outside the
+    // selected range
+    auto v = ospcommon::make_unique<ZProceduralVolume>(
+        vec3i(300, 200, 600), vec3f(0.f), vec3f(1.f));
+
+    // a thin slab of the volume
+    scalar_interval_value_selector_skipping(v->getVKLVolume(),
+                                            vkl_range1f{200.f, 210.f});
+  }
+
+  SECTION("structured volumes: macrocell sizes")
+  {
+    auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+        vec3i(100), vec3f(0.f), vec3f(1.f / 99.f));
+
+    VKLVolume vklVolume = v->getVKLVolume();
+
+    const vkl_range1f valueRange = vklGetValueRange(vklVolume);
+
+    for (int macrocellSize : {4, 8, 16, 32}) {
+      INFO("macrocellSize = " << macrocellSize);
+
+      vklSetInt(vklVolume, "macrocellSize", macrocellSize);
+      vklCommit(vklVolume);
+
+      const vkl_range1f macrocellValueRange = vklGetValueRange(vklVolume);
+      REQUIRE(macrocellValueRange.lower == valueRange.lower);
+      REQUIRE(macrocellValueRange.upper == valueRange.upper);
+
+      scalar_interval_continuity_with_no_value_selector(vklVolume);
+      scalar_interval_value_ranges_with_value_selector(vklVolume);
+    }
+
+    // only the specialized sizes are supported
+    vklSetInt(vklVolume, "macrocellSize", 12);
+    vklCommit(vklVolume);
+
+    REQUIRE(vklDriverGetLastErrorCode(driver) != VKL_NO_ERROR);
+  }
+
   SECTION("structured volumes: interval nominalDeltaT")
   {
     // use a different volume to facilitate nominalDeltaT tests
@@ -327,6 +508,48 @@ TEST_CASE("Interval iterator", "[interval_iterators]")
     }
   }
 
+  SECTION("AMR volumes")
+  {
+    // shells of three refinement levels around the center of a 128^3 grid;
+    // the finest level has the values 1
+    auto v = ospcommon::make_unique<ProceduralShellsAMRVolume<>>(
+        vec3i(128), vec3f(0.f), vec3f(1.f));
+
+    VKLVolume vklVolume = v->getVKLVolume();
+
+    SECTION("scalar interval continuity with no value selector")
+    {
+      scalar_interval_continuity_with_no_value_selector(vklVolume);
+    }
+
+    SECTION("scalar interval value ranges through refinement levels")
+    {
+      scalar_interval_amr_value_ranges(
+          vklVolume, vkl_vec3f{60.5f, 61.5f, -1.f}, vkl_range1f{0.9f, 1.f});
+    }
+
+    SECTION("value selector skipping empty regions")
+    {
+      scalar_interval_value_selector_skipping(vklVolume,
+                                              vkl_range1f{0.9f, 1.f});
+    }
+
+  }
+
+  SECTION("AMR volumes: interval nominalDeltaT")
+  {
+    // centered on the origin, which the tested rays pass through; they enter
+    // the volume in the coarsest level, with a cell width of 16
+    auto v = ospcommon::make_unique<ProceduralShellsAMRVolume<>>(
+        vec3i(128), vec3f(-64.f), vec3f(1.f));
+
+    VKLVolume vklVolume = v->getVKLVolume();
+
+    scalar_interval_nominalDeltaT(vklVolume, vec3f(1.f, 0.f, 0.f), 16.f);
+    scalar_interval_nominalDeltaT(vklVolume, vec3f(0.f, -1.f, 0.f), 16.f);
+    scalar_interval_nominalDeltaT(vklVolume, vec3f(0.f, 0.f, 4.f), 4.f);
+  }
+
   SECTION("unstructured volumes")
   {
     // for a unit cube physical grid [(0,0,0), (1,1,1)]
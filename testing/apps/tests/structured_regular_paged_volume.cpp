@@ -0,0 +1,299 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl/drivers/ispc/volume/BrickCache.h"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+struct VoxelSource
+{
+  std::vector<unsigned char> voxels;
+  vec3i dimensions;
+};
+
+static void loadVoxels(void *userData, const vkl_box3i *box, void *voxels)
+{
+  const VoxelSource &source = *static_cast<const VoxelSource *>(userData);
+
+  const float *src = (const float *)source.voxels.data();
+  float *dst       = (float *)voxels;
+
+  for (int z = box->lower.z; z < box->upper.z; z++) {
+    for (int y = box->lower.y; y < box->upper.y; y++) {
+      for (int x = box->lower.x; x < box->upper.x; x++) {
+        *dst++ = src[x + source.dimensions.x *
+                             (size_t(y) + source.dimensions.y * size_t(z))];
+      }
+    }
+  }
+}
+
+// the paged volume must behave exactly like the in-memory one, no matter how
+// small its cache is
+void paged_matches_in_memory(VKLVolume pagedVolume,
+                             VKLVolume volume,
+                             const vec3i &dimensions)
+{
+  const vkl_range1f valueRange      = vklGetValueRange(volume);
+  const vkl_range1f pagedValueRange = vklGetValueRange(pagedVolume);
+
+  REQUIRE(valueRange.lower == pagedValueRange.lower);
+  REQUIRE(valueRange.upper == pagedValueRange.upper);
+
+  // iterators only touch the accelerator, which is built without going
+  // through the cache
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distPos(-10.f, dimensions.x + 10.f);
+  std::uniform_real_distribution<float> distDir(-1.f, 1.f);
+
+  VKLValueSelector selector      = vklNewValueSelector(volume);
+  VKLValueSelector pagedSelector = vklNewValueSelector(pagedVolume);
+
+  const vkl_range1f selectorRange{0.5f * valueRange.upper, valueRange.upper};
+
+  vklValueSelectorSetRanges(selector, 1, &selectorRange);
+  vklValueSelectorSetRanges(pagedSelector, 1, &selectorRange);
+  vklCommit(selector);
+  vklCommit(pagedSelector);
+
+  for (int i = 0; i < 100; i++) {
+    const vkl_vec3f origin{distPos(eng), distPos(eng), distPos(eng)};
+    const vkl_vec3f direction{distDir(eng), distDir(eng), distDir(eng)};
+    const vkl_range1f tRange{0.f, inf};
+
+    VKLIntervalIterator iterator, pagedIterator;
+    vklInitIntervalIterator(
+        &iterator, volume, &origin, &direction, &tRange, selector);
+    vklInitIntervalIterator(&pagedIterator,
+                            pagedVolume,
+                            &origin,
+                            &direction,
+                            &tRange,
+                            pagedSelector);
+
+    VKLInterval interval, pagedInterval;
+
+    while (true) {
+      const int result = vklIterateInterval(&iterator, &interval);
+      REQUIRE(result == vklIterateInterval(&pagedIterator, &pagedInterval));
+
+      if (!result) {
+        break;
+      }
+
+      REQUIRE(interval.tRange.lower == pagedInterval.tRange.lower);
+      REQUIRE(interval.tRange.upper == pagedInterval.tRange.upper);
+      REQUIRE(interval.valueRange.lower == pagedInterval.valueRange.lower);
+      REQUIRE(interval.valueRange.upper == pagedInterval.valueRange.upper);
+    }
+  }
+
+  vklRelease(selector);
+  vklRelease(pagedSelector);
+
+  REQUIRE(vklGetCacheStatistics(pagedVolume).cacheMisses == 0);
+
+  // sampling pages bricks in
+  std::vector<vec3f> objectCoordinates;
+
+  multidim_index_sequence<3> mis(dimensions);
+
+  for (const auto &offset : mis) {
+    objectCoordinates.push_back(vec3f(offset));
+  }
+
+  std::uniform_real_distribution<float> distInside(0.f, dimensions.x - 1.f);
+
+  for (int i = 0; i < 10000; i++) {
+    objectCoordinates.push_back(
+        vec3f(distInside(eng), distInside(eng), distInside(eng)));
+  }
+
+  for (const auto &oc : objectCoordinates) {
+    INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+    REQUIRE(vklComputeSample(volume, (const vkl_vec3f *)&oc) ==
+            vklComputeSample(pagedVolume, (const vkl_vec3f *)&oc));
+
+    const vkl_vec3f gradientTruth =
+        vklComputeGradient(volume, (const vkl_vec3f *)&oc);
+    const vkl_vec3f gradient =
+        vklComputeGradient(pagedVolume, (const vkl_vec3f *)&oc);
+
+    REQUIRE(gradientTruth.x == gradient.x);
+    REQUIRE(gradientTruth.y == gradient.y);
+    REQUIRE(gradientTruth.z == gradient.z);
+  }
+
+  std::vector<float> samplesTruth(objectCoordinates.size());
+  std::vector<float> samples(objectCoordinates.size());
+
+  vklComputeSampleStreamAOS(volume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            samplesTruth.data());
+
+  vklComputeSampleStreamAOS(pagedVolume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            samples.data());
+
+  for (size_t i = 0; i < objectCoordinates.size(); i++) {
+    INFO("sample = " << i + 1 << " / " << objectCoordinates.size());
+    REQUIRE(samplesTruth[i] == samples[i]);
+  }
+
+  // the volume is larger than the cache
+  const VKLCacheStatistics statistics = vklGetCacheStatistics(pagedVolume);
+
+  REQUIRE(statistics.cacheHits > 0);
+  REQUIRE(statistics.cacheMisses > 0);
+  REQUIRE(statistics.cacheEvictions > 0);
+  REQUIRE(statistics.bytesResident > 0);
+  REQUIRE(statistics.bytesResident < 2 * (size_t(1) << 20));
+}
+
+TEST_CASE("Structured regular paged volume", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  // not a multiple of any brick size; 4 MB of voxels
+  const vec3i dimensions(101);
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume volume = v->getVKLVolume();
+
+  VoxelSource source;
+  source.voxels     = v->generateVoxels();
+  source.dimensions = dimensions;
+
+  VKLVolume pagedVolume = vklNewVolume("structured_regular_paged");
+  vklSetVec3i(
+      pagedVolume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+  vklSetInt(pagedVolume, "voxelType", VKL_FLOAT);
+  vklSetInt(pagedVolume, "brickSize", 16);
+  vklSetInt(pagedVolume, "maxCacheSizeMB", 1);
+
+  SECTION("raw file")
+  {
+    const std::string filename = "vkl_paged_volume_test.raw";
+    const int headerBytes      = 64;
+
+    {
+      std::ofstream output(filename, std::ios::binary);
+      std::vector<char> header(headerBytes, 'x');
+      output.write(header.data(), header.size());
+      output.write((const char *)source.voxels.data(), source.voxels.size());
+    }
+
+    vklSetString(pagedVolume, "filename", filename.c_str());
+    vklSetInt(pagedVolume, "fileOffset", headerBytes);
+    vklCommit(pagedVolume);
+
+    paged_matches_in_memory(pagedVolume, volume, dimensions);
+
+    // offsets of 2 GB and more are set as 64-bit parameters
+    vklSetULong(pagedVolume, "fileOffset", headerBytes);
+    vklCommit(pagedVolume);
+
+    paged_matches_in_memory(pagedVolume, volume, dimensions);
+
+    vklRelease(pagedVolume);
+    std::remove(filename.c_str());
+  }
+
+  SECTION("callback")
+  {
+    vklSetVoidPtr(pagedVolume, "loadVoxelsFunc", (void *)loadVoxels);
+    vklSetVoidPtr(pagedVolume, "loadVoxelsUserData", &source);
+    vklCommit(pagedVolume);
+
+    paged_matches_in_memory(pagedVolume, volume, dimensions);
+
+    vklRelease(pagedVolume);
+  }
+}
+
+TEST_CASE("Brick cache", "[volume_sampling]")
+{
+  using openvkl::ispc_driver::BrickCache;
+
+  const size_t bytesPerBrick = 64;
+  const uint64_t numBricks   = 8;
+
+  int loads = 0;
+
+  // a budget of one brick, so a single shard
+  BrickCache cache(
+      bytesPerBrick, bytesPerBrick, numBricks, [&](uint64_t id, void *brick) {
+        loads++;
+        std::memset(brick, int(id), bytesPerBrick);
+      });
+
+  SECTION("resident bricks are hits")
+  {
+    const void *brick = cache.pin(3);
+    REQUIRE(*static_cast<const unsigned char *>(brick) == 3);
+    cache.unpin(3);
+
+    REQUIRE(cache.pin(3) == brick);
+    cache.unpin(3);
+
+    const VKLCacheStatistics statistics = cache.getStatistics();
+    REQUIRE(statistics.cacheHits == 1);
+    REQUIRE(statistics.cacheMisses == 1);
+    REQUIRE(loads == 1);
+  }
+
+  SECTION("the cache shrinks back to its budget")
+  {
+    // pinned bricks grow the cache beyond its budget
+    for (uint64_t id = 0; id < 4; id++) {
+      cache.pin(id);
+    }
+
+    REQUIRE(cache.getStatistics().bytesResident == 4 * bytesPerBrick);
+
+    for (uint64_t id = 0; id < 4; id++) {
+      cache.unpin(id);
+    }
+
+    // the next miss evicts all of them, reusing one
+    const void *brick = cache.pin(4);
+    REQUIRE(*static_cast<const unsigned char *>(brick) == 4);
+    cache.unpin(4);
+
+    const VKLCacheStatistics statistics = cache.getStatistics();
+    REQUIRE(statistics.cacheEvictions == 4);
+    REQUIRE(statistics.bytesResident == bytesPerBrick);
+  }
+}
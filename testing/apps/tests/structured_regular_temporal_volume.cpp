@@ -0,0 +1,175 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static VKLVolume newRegularVolume(const vec3i &dimensions,
+                                  const std::vector<float> &voxels)
+{
+  VKLVolume volume = vklNewVolume("structured_regular");
+
+  vklSetVec3i(volume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+
+  VKLData data = vklNewData(voxels.size(), VKL_FLOAT, voxels.data());
+  vklSetData(volume, "data", data);
+  vklRelease(data);
+
+  vklCommit(volume);
+
+  return volume;
+}
+
+TEST_CASE("Structured regular temporal volume", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  const vec3i dimensions(37, 42, 29);
+  const int numTimesteps = 3;
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  const std::vector<unsigned char> bytes = v->generateVoxels();
+  const float *wavelet                   = (const float *)bytes.data();
+
+  // timestep i is the wavelet shifted by i, so the timesteps differ
+  // everywhere and span different value ranges
+  std::vector<std::vector<float>> timestepVoxels(numTimesteps);
+  std::vector<VKLVolume> frames;
+  std::vector<VKLData> timestepData;
+
+  for (int i = 0; i < numTimesteps; i++) {
+    for (size_t j = 0; j < dimensions.long_product(); j++) {
+      timestepVoxels[i].push_back(wavelet[j] + 2.f * i);
+    }
+
+    frames.push_back(newRegularVolume(dimensions, timestepVoxels[i]));
+    timestepData.push_back(vklNewData(
+        timestepVoxels[i].size(), VKL_FLOAT, timestepVoxels[i].data()));
+  }
+
+  VKLData timesteps =
+      vklNewData(timestepData.size(), VKL_DATA, timestepData.data());
+
+  for (VKLData data : timestepData) {
+    vklRelease(data);
+  }
+
+  VKLVolume volume = vklNewVolume("structured_regular_temporal");
+  vklSetVec3i(volume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+  vklSetData(volume, "timesteps", timesteps);
+  vklRelease(timesteps);
+  vklCommit(volume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(0.f, dimensions.x - 1.f);
+  std::uniform_real_distribution<float> distY(0.f, dimensions.y - 1.f);
+  std::uniform_real_distribution<float> distZ(0.f, dimensions.z - 1.f);
+  std::uniform_real_distribution<float> distTime(0.f, 1.f);
+
+  SECTION("the value range spans all timesteps")
+  {
+    const vkl_range1f valueRange = vklGetValueRange(volume);
+
+    REQUIRE(valueRange.lower == vklGetValueRange(frames.front()).lower);
+    REQUIRE(valueRange.upper == vklGetValueRange(frames.back()).upper);
+  }
+
+  SECTION("samples interpolate linearly between timesteps")
+  {
+    for (int i = 0; i < 10000; i++) {
+      const vec3f oc(distX(eng), distY(eng), distZ(eng));
+      const float time = distTime(eng);
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z
+                                  << " time = " << time);
+
+      const float t    = time * (numTimesteps - 1);
+      const int frame  = std::min(int(t), numTimesteps - 2);
+      const float frac = t - frame;
+
+      const float sample0 =
+          vklComputeSample(frames[frame], (const vkl_vec3f *)&oc);
+      const float sample1 =
+          vklComputeSample(frames[frame + 1], (const vkl_vec3f *)&oc);
+
+      REQUIRE(vklComputeSampleTime(volume, (const vkl_vec3f *)&oc, time) ==
+              Approx(sample0 + frac * (sample1 - sample0)).epsilon(1e-5f));
+    }
+
+    // timesteps are sampled exactly at their times
+    for (int frame = 0; frame < numTimesteps; frame++) {
+      const vec3f oc(distX(eng), distY(eng), distZ(eng));
+      const float time = float(frame) / (numTimesteps - 1);
+
+      REQUIRE(vklComputeSampleTime(volume, (const vkl_vec3f *)&oc, time) ==
+              vklComputeSample(frames[frame], (const vkl_vec3f *)&oc));
+    }
+  }
+
+  SECTION("the time parameter applies to all sampling functions")
+  {
+    const float time = 0.3f;
+
+    vklSetFloat(volume, "time", time);
+    vklCommit(volume);
+
+    for (int i = 0; i < 1000; i++) {
+      const vec3f oc(distX(eng), distY(eng), distZ(eng));
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+      const float sample =
+          vklComputeSampleTime(volume, (const vkl_vec3f *)&oc, time);
+
+      REQUIRE(vklComputeSample(volume, (const vkl_vec3f *)&oc) == sample);
+
+      const int valid[4] = {1, 0, 0, 0};
+      vkl_vvec3f4 oc4;
+      oc4.x[0] = oc.x;
+      oc4.y[0] = oc.y;
+      oc4.z[0] = oc.z;
+
+      float samples4[4];
+      vklComputeSample4(valid, volume, &oc4, samples4);
+
+      REQUIRE(samples4[0] == Approx(sample).epsilon(1e-5f));
+    }
+
+    // a commit changing only the time keeps the accelerator, and with it the
+    // value range of all timesteps
+    REQUIRE(vklGetValueRange(volume).upper ==
+            vklGetValueRange(frames.back()).upper);
+  }
+
+  vklRelease(volume);
+
+  for (VKLVolume frame : frames) {
+    vklRelease(frame);
+  }
+}
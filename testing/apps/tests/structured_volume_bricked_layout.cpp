@@ -0,0 +1,206 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <array>
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+// intervals along rays through the volume, with interval value ranges given
+// by the accelerator
+static std::vector<VKLInterval> allIntervals(VKLVolume volume)
+{
+  const vkl_box3f bbox = vklGetBoundingBox(volume);
+  const vec3f lower    = (const vec3f &)bbox.lower;
+  const vec3f upper    = (const vec3f &)bbox.upper;
+
+  const vkl_range1f tRange{0.f, inf};
+
+  std::vector<VKLInterval> intervals;
+
+  for (int i = 0; i < 3; i++) {
+    for (float f : {0.1f, 0.5f, 0.9f}) {
+      vec3f origin = lower + f * (upper - lower);
+      origin[i]    = lower[i] - 1.f;
+
+      vec3f direction(0.f);
+      direction[i] = 1.f;
+
+      VKLIntervalIterator iterator;
+      vklInitIntervalIterator(&iterator,
+                              volume,
+                              (const vkl_vec3f *)&origin,
+                              (const vkl_vec3f *)&direction,
+                              &tRange,
+                              nullptr);
+
+      VKLInterval interval;
+      while (vklIterateInterval(&iterator, &interval)) {
+        intervals.push_back(interval);
+      }
+    }
+  }
+
+  return intervals;
+}
+
+// the bricked layout must be invisible to the user: sampling, gradients,
+// value ranges and interval value ranges must match the linear layout exactly
+template <typename PROCEDURAL_VOLUME_TYPE>
+void bricked_matches_linear(const vec3i &dimensions, int brickSize)
+{
+  vec3f gridOrigin;
+  vec3f gridSpacing;
+
+  PROCEDURAL_VOLUME_TYPE::generateGridParameters(
+      dimensions, 2.f, gridOrigin, gridSpacing);
+
+  auto linear = ospcommon::make_unique<PROCEDURAL_VOLUME_TYPE>(
+      dimensions, gridOrigin, gridSpacing);
+
+  auto bricked = ospcommon::make_unique<PROCEDURAL_VOLUME_TYPE>(
+      dimensions, gridOrigin, gridSpacing);
+  bricked->setBrickSize(brickSize);
+
+  VKLVolume linearVolume  = linear->getVKLVolume();
+  VKLVolume brickedVolume = bricked->getVKLVolume();
+
+  INFO("brickSize = " << brickSize);
+
+  const vkl_range1f linearRange  = vklGetValueRange(linearVolume);
+  const vkl_range1f brickedRange = vklGetValueRange(brickedVolume);
+
+  REQUIRE(linearRange.lower == brickedRange.lower);
+  REQUIRE(linearRange.upper == brickedRange.upper);
+
+  // the accelerator of the linear layout is built from typed rows of voxels,
+  // that of the bricked layout one macrocell at a time
+  const std::vector<VKLInterval> linearIntervals =
+      allIntervals(linearVolume);
+  const std::vector<VKLInterval> brickedIntervals =
+      allIntervals(brickedVolume);
+
+  REQUIRE(linearIntervals.size() == brickedIntervals.size());
+
+  for (size_t i = 0; i < linearIntervals.size(); i++) {
+    REQUIRE(linearIntervals[i].tRange.lower ==
+            brickedIntervals[i].tRange.lower);
+    REQUIRE(linearIntervals[i].tRange.upper ==
+            brickedIntervals[i].tRange.upper);
+    REQUIRE(linearIntervals[i].valueRange.lower ==
+            brickedIntervals[i].valueRange.lower);
+    REQUIRE(linearIntervals[i].valueRange.upper ==
+            brickedIntervals[i].valueRange.upper);
+  }
+
+  std::vector<vec3f> objectCoordinates;
+
+  // all voxel positions, which cover brick boundaries and aprons
+  multidim_index_sequence<3> mis(dimensions);
+
+  for (const auto &offset : mis) {
+    objectCoordinates.push_back(
+        linear->transformLocalToObjectCoordinates(offset));
+  }
+
+  // and random positions within cells
+  vkl_box3f bbox = vklGetBoundingBox(linearVolume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+  std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+  std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+
+  for (int i = 0; i < 10000; i++) {
+    objectCoordinates.push_back(vec3f(distX(eng), distY(eng), distZ(eng)));
+  }
+
+  for (const auto &oc : objectCoordinates) {
+    INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+    const float sampleTruth =
+        vklComputeSample(linearVolume, (const vkl_vec3f *)&oc);
+    const float sample =
+        vklComputeSample(brickedVolume, (const vkl_vec3f *)&oc);
+
+    REQUIRE(sampleTruth == sample);
+
+    const vkl_vec3f gradientTruth =
+        vklComputeGradient(linearVolume, (const vkl_vec3f *)&oc);
+    const vkl_vec3f gradient =
+        vklComputeGradient(brickedVolume, (const vkl_vec3f *)&oc);
+
+    REQUIRE(gradientTruth.x == gradient.x);
+    REQUIRE(gradientTruth.y == gradient.y);
+    REQUIRE(gradientTruth.z == gradient.z);
+  }
+
+  // varying sampling paths
+  std::vector<float> samplesTruth(objectCoordinates.size());
+  std::vector<float> samples(objectCoordinates.size());
+
+  vklComputeSampleStreamAOS(linearVolume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            samplesTruth.data());
+
+  vklComputeSampleStreamAOS(brickedVolume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            samples.data());
+
+  for (size_t i = 0; i < objectCoordinates.size(); i++) {
+    INFO("sample = " << i + 1 << " / " << objectCoordinates.size());
+    REQUIRE(samplesTruth[i] == samples[i]);
+  }
+}
+
+TEST_CASE("Structured volume bricked layout", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  // dimensions that are / are not multiples of the brick size, and a thin
+  // (two slice) dimension
+  const std::array<vec3i, 3> dimensions{
+      vec3i(37, 50, 23), vec3i(33), vec3i(20, 9, 2)};
+
+  const std::array<int, 3> brickSizes{4, 8, 16};
+
+  for (const auto &d : dimensions) {
+    for (const auto &brickSize : brickSizes) {
+      INFO("dimensions = " << d.x << " " << d.y << " " << d.z);
+
+      bricked_matches_linear<WaveletStructuredRegularVolumeUChar>(d,
+                                                                  brickSize);
+      bricked_matches_linear<WaveletStructuredRegularVolumeShort>(d,
+                                                                  brickSize);
+      bricked_matches_linear<WaveletStructuredRegularVolumeFloat>(d,
+                                                                  brickSize);
+      bricked_matches_linear<WaveletStructuredRegularVolumeDouble>(d,
+                                                                   brickSize);
+    }
+  }
+}
@@ -14,6 +14,8 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <cmath>
+#include <random>
 #include "../../external/catch.hpp"
 #include "openvkl_testing.h"
 #include "ospcommon/math/box.h"
@@ -72,6 +74,72 @@ void scalar_gradients(float tolerance = 0.1f, bool skipBoundaries = false)
   }
 }
 
+template <typename PROCEDURAL_VOLUME_TYPE>
+void scalar_sample_and_gradients(float tolerance = 1e-3f)
+{
+  const vec3i dimensions(128);
+  const float boundingBoxSize = 2.f;
+
+  vec3f gridOrigin;
+  vec3f gridSpacing;
+
+  PROCEDURAL_VOLUME_TYPE::generateGridParameters(
+      dimensions, boundingBoxSize, gridOrigin, gridSpacing);
+
+  auto v = ospcommon::make_unique<PROCEDURAL_VOLUME_TYPE>(
+      dimensions, gridOrigin, gridSpacing);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+  std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+  std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+
+  for (int i = 0; i < 10000; i++) {
+    const vec3f objectCoordinates(distX(eng), distY(eng), distZ(eng));
+
+    INFO("objectCoordinates = " << objectCoordinates.x << " "
+                                << objectCoordinates.y << " "
+                                << objectCoordinates.z);
+
+    vkl_vec3f vklGradient;
+    const float sample =
+        vklComputeSampleAndGradient(vklVolume,
+                                    (const vkl_vec3f *)&objectCoordinates,
+                                    &vklGradient);
+    const vec3f gradient = (const vec3f &)vklGradient;
+
+    const float sampleTruth =
+        vklComputeSample(vklVolume, (const vkl_vec3f *)&objectCoordinates);
+
+    REQUIRE(sample == Approx(sampleTruth).margin(tolerance));
+
+    // the XYZ field is itself trilinear, so the gradient of the trilinear
+    // interpolant matches the analytical gradient everywhere in the volume
+    const vec3f proceduralGradient =
+        v->computeProceduralGradient(objectCoordinates);
+
+    REQUIRE(gradient.x == Approx(proceduralGradient.x).margin(tolerance));
+    REQUIRE(gradient.y == Approx(proceduralGradient.y).margin(tolerance));
+    REQUIRE(gradient.z == Approx(proceduralGradient.z).margin(tolerance));
+  }
+
+  // outside the volume both the sample and the gradient are NaN
+  const vec3f outside(bbox.upper.x + 1.f, bbox.upper.y, bbox.upper.z);
+
+  vkl_vec3f outsideGradient;
+  const float outsideSample = vklComputeSampleAndGradient(
+      vklVolume, (const vkl_vec3f *)&outside, &outsideGradient);
+
+  REQUIRE(std::isnan(outsideSample));
+  REQUIRE(std::isnan(outsideGradient.x));
+}
+
 TEST_CASE("Structured volume gradients", "[volume_gradients]")
 {
   vklLoadModule("ispc_driver");
@@ -94,4 +162,9 @@ TEST_CASE("Structured volume gradients", "[volume_gradients]")
   {
     scalar_gradients<XYZStructuredSphericalVolume<float>>(0.1f, true);
   }
+
+  SECTION("XYZStructuredRegularVolume<float> fused sample and gradient")
+  {
+    scalar_sample_and_gradients<XYZStructuredRegularVolume<float>>();
+  }
 }
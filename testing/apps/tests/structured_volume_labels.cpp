@@ -0,0 +1,115 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+template <typename LABEL_TYPE>
+void labels_nearest_voxel(VKLDataType labelType, const vec3i &dimensions)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  std::vector<unsigned char> voxels = v->generateVoxels();
+
+  const size_t numVoxels = dimensions.long_product();
+
+  std::vector<LABEL_TYPE> labels(numVoxels);
+  for (size_t i = 0; i < numVoxels; i++)
+    labels[i] = LABEL_TYPE(i % 251);
+
+  VKLVolume volume = vklNewVolume("structured_regular");
+
+  vklSetVec3i(volume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+
+  VKLData data = vklNewData(numVoxels, VKL_FLOAT, voxels.data());
+  vklSetData(volume, "data", data);
+  vklRelease(data);
+
+  VKLData labelData = vklNewData(numVoxels, labelType, labels.data());
+  vklSetData(volume, "labels", labelData);
+  vklRelease(labelData);
+
+  vklCommit(volume);
+
+  VKLVolume reference = v->getVKLVolume();
+
+  multidim_index_sequence<3> mis(dimensions);
+
+  // probe each voxel and points displaced towards (but short of) its
+  // neighbors, which must all resolve to the same label
+  const std::vector<vec3f> displacements{
+      vec3f(0.f), vec3f(0.4f), vec3f(-0.4f), vec3f(0.4f, -0.4f, 0.f)};
+
+  for (const auto &index : mis) {
+    const uint8_t labelTruth =
+        uint8_t(labels[index.x + dimensions.x * (index.y + dimensions.y *
+                                                               index.z)]);
+
+    for (const auto &d : displacements) {
+      const vec3f oc = vec3f(index) + d;
+
+      if (oc.x < 0.f || oc.y < 0.f || oc.z < 0.f ||
+          oc.x > dimensions.x - 1.f || oc.y > dimensions.y - 1.f ||
+          oc.z > dimensions.z - 1.f) {
+        continue;
+      }
+
+      uint8_t label = 255;
+      const float sample =
+          vklComputeSampleSeg(volume, (const vkl_vec3f *)&oc, &label);
+
+      INFO("index = " << index.x << " " << index.y << " " << index.z);
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+      REQUIRE(label == labelTruth);
+
+      // labels must not affect the value layout
+      REQUIRE(sample == vklComputeSample(reference, (const vkl_vec3f *)&oc));
+    }
+  }
+
+  // positions outside the volume report the background label
+  const vec3f outside(-1.f);
+  uint8_t label = 255;
+  vklComputeSampleSeg(volume, (const vkl_vec3f *)&outside, &label);
+  REQUIRE(label == 0);
+
+  vklRelease(volume);
+}
+
+TEST_CASE("Structured volume labels", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  SECTION("unsigned char labels")
+  {
+    labels_nearest_voxel<uint8_t>(VKL_UCHAR, vec3i(17, 19, 23));
+  }
+
+  SECTION("unsigned short labels")
+  {
+    labels_nearest_voxel<uint16_t>(VKL_USHORT, vec3i(17, 19, 23));
+  }
+}
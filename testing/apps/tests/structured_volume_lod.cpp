@@ -0,0 +1,210 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cmath>
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static void setMipPyramid(VKLVolume volume,
+                          int mipLevels,
+                          const char *mipFilter)
+{
+  vklSetInt(volume, "mipLevels", mipLevels);
+  vklSetString(volume, "mipFilter", mipFilter);
+  vklCommit(volume);
+}
+
+static float intervalNominalDeltaT(VKLVolume volume,
+                                   float stepSize,
+                                   const vkl_vec3f &direction = {0.f, 0.f, 1.f})
+{
+  vkl_vec3f origin{0.5f, 0.5f, -1.f};
+  vkl_range1f tRange{0.f, inf};
+
+  const vkl_range1f valueRange = vklGetValueRange(volume);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(volume);
+  vklValueSelectorSetRanges(valueSelector, 1, &valueRange);
+  vklValueSelectorSetStepSize(valueSelector, stepSize);
+  vklCommit(valueSelector);
+
+  VKLIntervalIterator iterator;
+  vklInitIntervalIterator(
+      &iterator, volume, &origin, &direction, &tRange, valueSelector);
+
+  VKLInterval interval;
+  REQUIRE(vklIterateInterval(&iterator, &interval));
+
+  vklRelease(valueSelector);
+
+  return interval.nominalDeltaT;
+}
+
+TEST_CASE("Structured volume level of detail", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  // odd and even dimensions, so some levels end one cell short of the finer
+  // level
+  const vec3i dimensions(45, 38, 27);
+  const int numLevels = 3;
+
+  auto average = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+  auto minimum = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+  auto maximum = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume avgVolume = average->getVKLVolume();
+  VKLVolume minVolume = minimum->getVKLVolume();
+  VKLVolume maxVolume = maximum->getVKLVolume();
+
+  const vkl_range1f valueRange = vklGetValueRange(avgVolume);
+  const float epsilon = 1e-5f * (valueRange.upper - valueRange.lower);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(0.f, dimensions.x - 1.f);
+  std::uniform_real_distribution<float> distY(0.f, dimensions.y - 1.f);
+  std::uniform_real_distribution<float> distZ(0.f, dimensions.z - 1.f);
+  std::uniform_real_distribution<float> distLOD(0.f, numLevels + 1.f);
+
+  SECTION("without a pyramid, lod is ignored")
+  {
+    for (int i = 0; i < 1000; i++) {
+      const vec3f oc(distX(eng), distY(eng), distZ(eng));
+      const float lod = distLOD(eng);
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z
+                                  << " lod = " << lod);
+
+      REQUIRE(vklComputeSample(avgVolume, (const vkl_vec3f *)&oc) ==
+              vklComputeSampleLOD(avgVolume, (const vkl_vec3f *)&oc, lod));
+    }
+  }
+
+  SECTION("pyramid levels are ordered by filter")
+  {
+    setMipPyramid(avgVolume, numLevels, "average");
+    setMipPyramid(minVolume, numLevels, "min");
+    setMipPyramid(maxVolume, numLevels, "max");
+
+    for (int level = 0; level <= numLevels; level++) {
+      INFO("level = " << level);
+
+      // every voxel of a level is also a voxel of the full resolution, and
+      // within its level's filter footprint
+      const int stride = 1 << level;
+
+      multidim_index_sequence<3> mis((dimensions - 1) / stride + 1);
+
+      for (const auto &index : mis) {
+        const vec3f oc(index * stride);
+
+        INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+        const float sample =
+            vklComputeSample(avgVolume, (const vkl_vec3f *)&oc);
+
+        const float minSample =
+            vklComputeSampleLOD(minVolume, (const vkl_vec3f *)&oc, level);
+        const float avgSample =
+            vklComputeSampleLOD(avgVolume, (const vkl_vec3f *)&oc, level);
+        const float maxSample =
+            vklComputeSampleLOD(maxVolume, (const vkl_vec3f *)&oc, level);
+
+        REQUIRE(minSample <= sample + epsilon);
+        REQUIRE(sample <= maxSample + epsilon);
+        REQUIRE(minSample <= avgSample + epsilon);
+        REQUIRE(avgSample <= maxSample + epsilon);
+      }
+    }
+
+    // interpolation within and between levels preserves the ordering;
+    // levels beyond the pyramid are clamped
+    for (int i = 0; i < 10000; i++) {
+      const vec3f oc(distX(eng), distY(eng), distZ(eng));
+      const float lod = distLOD(eng);
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z
+                                  << " lod = " << lod);
+
+      const float minSample =
+          vklComputeSampleLOD(minVolume, (const vkl_vec3f *)&oc, lod);
+      const float avgSample =
+          vklComputeSampleLOD(avgVolume, (const vkl_vec3f *)&oc, lod);
+      const float maxSample =
+          vklComputeSampleLOD(maxVolume, (const vkl_vec3f *)&oc, lod);
+
+      REQUIRE(minSample <= avgSample + epsilon);
+      REQUIRE(avgSample <= maxSample + epsilon);
+    }
+
+    // level 0 is the volume itself, and coarse levels do not extend the
+    // volume bounds
+    const vec3f inside(distX(eng), distY(eng), distZ(eng));
+    const vec3f outside(1.f, dimensions.y - 0.5f, 1.f);
+
+    REQUIRE(vklComputeSample(avgVolume, (const vkl_vec3f *)&inside) ==
+            vklComputeSampleLOD(avgVolume, (const vkl_vec3f *)&inside, 0.f));
+
+    REQUIRE(std::isnan(
+        vklComputeSampleLOD(avgVolume, (const vkl_vec3f *)&outside, 1.5f)));
+
+    // the last fine cell of even dimensions is clamped to the coarse levels
+    const vec3f upperCorner = vec3f(dimensions) - 1.f;
+
+    for (int level = 1; level <= numLevels; level++) {
+      INFO("level = " << level);
+      REQUIRE(!std::isnan(vklComputeSampleLOD(
+          avgVolume, (const vkl_vec3f *)&upperCorner, level)));
+    }
+  }
+
+  SECTION("iterators pick the level from their step size")
+  {
+    const float nominalDeltaT = intervalNominalDeltaT(avgVolume, 0.f);
+
+    // without a pyramid, the step size is ignored
+    REQUIRE(intervalNominalDeltaT(avgVolume, 4.f) == nominalDeltaT);
+
+    setMipPyramid(avgVolume, numLevels, "average");
+
+    REQUIRE(intervalNominalDeltaT(avgVolume, 0.f) == nominalDeltaT);
+    REQUIRE(intervalNominalDeltaT(avgVolume, 1.f) == nominalDeltaT);
+    REQUIRE(intervalNominalDeltaT(avgVolume, 3.f) == 2.f * nominalDeltaT);
+    REQUIRE(intervalNominalDeltaT(avgVolume, 4.f) == 4.f * nominalDeltaT);
+
+    // the step size is in object space, independent of the direction's length
+    REQUIRE(intervalNominalDeltaT(avgVolume, 4.f, {0.f, 0.f, 2.f}) ==
+            2.f * nominalDeltaT);
+
+    // clamped to the levels present
+    REQUIRE(intervalNominalDeltaT(avgVolume, 1000.f) ==
+            float(1 << numLevels) * nominalDeltaT);
+  }
+}
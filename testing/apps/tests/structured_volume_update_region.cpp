@@ -0,0 +1,203 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <random>
+#include "../../external/catch.hpp"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/multidim_index_sequence.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static VKLVolume newVolume(const vec3i &dimensions,
+                           const float *voxels,
+                           VKLDataCreationFlags dataCreationFlags,
+                           int brickSize,
+                           int mipLevels)
+{
+  VKLVolume volume = vklNewVolume("structured_regular");
+
+  vklSetVec3i(volume, "dimensions", dimensions.x, dimensions.y, dimensions.z);
+  vklSetVec3f(volume, "gridOrigin", 0.f, 0.f, 0.f);
+  vklSetVec3f(volume, "gridSpacing", 1.f, 1.f, 1.f);
+  vklSetInt(volume, "brickSize", brickSize);
+  vklSetInt(volume, "mipLevels", mipLevels);
+
+  VKLData data = vklNewData(
+      dimensions.long_product(), VKL_FLOAT, voxels, dataCreationFlags);
+  vklSetData(volume, "data", data);
+  vklRelease(data);
+
+  vklCommit(volume);
+
+  return volume;
+}
+
+// a volume updated in place must match one committed from scratch on the same
+// voxels
+void updated_matches_committed(const vec3i &dimensions,
+                               int brickSize,
+                               int mipLevels,
+                               const box3i &region)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  const std::vector<unsigned char> bytes = v->generateVoxels();
+  std::vector<float> voxels((const float *)bytes.data(),
+                            (const float *)bytes.data() +
+                                dimensions.long_product());
+
+  VKLVolume volume = newVolume(
+      dimensions, voxels.data(), VKL_DATA_SHARED_BUFFER, brickSize, mipLevels);
+
+  const vkl_range1f initialRange = vklGetValueRange(volume);
+
+  // raise the region well above the previous value range, so the update
+  // must show in the value range, the macrocells and the mip levels
+  multidim_index_sequence<3> mis(dimensions);
+
+  for (const auto &index : mis) {
+    if (index.x >= region.lower.x && index.x < region.upper.x &&
+        index.y >= region.lower.y && index.y < region.upper.y &&
+        index.z >= region.lower.z && index.z < region.upper.z) {
+      const size_t i =
+          index.x + dimensions.x * (size_t(index.y) +
+                                    dimensions.y * size_t(index.z));
+      voxels[i] += 2.f * initialRange.upper;
+    }
+  }
+
+  vklVolumeUpdateRegion(volume, (const vkl_box3i *)&region);
+
+  VKLVolume truth = newVolume(
+      dimensions, voxels.data(), VKL_DATA_DEFAULT, brickSize, mipLevels);
+
+  INFO("brickSize = " << brickSize << " mipLevels = " << mipLevels);
+
+  const vkl_range1f valueRange      = vklGetValueRange(volume);
+  const vkl_range1f truthValueRange = vklGetValueRange(truth);
+
+  REQUIRE(valueRange.lower == truthValueRange.lower);
+  REQUIRE(valueRange.upper == truthValueRange.upper);
+  REQUIRE(valueRange.upper > initialRange.upper);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::vector<vec3f> objectCoordinates;
+
+  for (const auto &index : mis) {
+    objectCoordinates.push_back(vec3f(index));
+  }
+
+  std::uniform_real_distribution<float> distX(0.f, dimensions.x - 1.f);
+  std::uniform_real_distribution<float> distY(0.f, dimensions.y - 1.f);
+  std::uniform_real_distribution<float> distZ(0.f, dimensions.z - 1.f);
+
+  for (int i = 0; i < 10000; i++) {
+    objectCoordinates.push_back(vec3f(distX(eng), distY(eng), distZ(eng)));
+  }
+
+  for (const auto &oc : objectCoordinates) {
+    INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+    REQUIRE(vklComputeSample(volume, (const vkl_vec3f *)&oc) ==
+            vklComputeSample(truth, (const vkl_vec3f *)&oc));
+
+    for (int level = 1; level <= mipLevels; level++) {
+      REQUIRE(vklComputeSampleLOD(volume, (const vkl_vec3f *)&oc, level) ==
+              vklComputeSampleLOD(truth, (const vkl_vec3f *)&oc, level));
+    }
+  }
+
+  // intervals depend on the macrocell value ranges
+  VKLValueSelector selector      = vklNewValueSelector(volume);
+  VKLValueSelector truthSelector = vklNewValueSelector(truth);
+
+  const vkl_range1f selectorRange{initialRange.upper, valueRange.upper};
+
+  vklValueSelectorSetRanges(selector, 1, &selectorRange);
+  vklValueSelectorSetRanges(truthSelector, 1, &selectorRange);
+  vklCommit(selector);
+  vklCommit(truthSelector);
+
+  std::uniform_real_distribution<float> distPos(-10.f, dimensions.x + 10.f);
+  std::uniform_real_distribution<float> distDir(-1.f, 1.f);
+
+  for (int i = 0; i < 100; i++) {
+    const vkl_vec3f origin{distPos(eng), distPos(eng), distPos(eng)};
+    const vkl_vec3f direction{distDir(eng), distDir(eng), distDir(eng)};
+    const vkl_range1f tRange{0.f, inf};
+
+    VKLIntervalIterator iterator, truthIterator;
+    vklInitIntervalIterator(
+        &iterator, volume, &origin, &direction, &tRange, selector);
+    vklInitIntervalIterator(
+        &truthIterator, truth, &origin, &direction, &tRange, truthSelector);
+
+    VKLInterval interval, truthInterval;
+
+    while (true) {
+      const int result = vklIterateInterval(&iterator, &interval);
+      REQUIRE(result == vklIterateInterval(&truthIterator, &truthInterval));
+
+      if (!result) {
+        break;
+      }
+
+      REQUIRE(interval.tRange.lower == truthInterval.tRange.lower);
+      REQUIRE(interval.tRange.upper == truthInterval.tRange.upper);
+      REQUIRE(interval.valueRange.lower == truthInterval.valueRange.lower);
+      REQUIRE(interval.valueRange.upper == truthInterval.valueRange.upper);
+    }
+  }
+
+  vklRelease(selector);
+  vklRelease(truthSelector);
+
+  vklRelease(volume);
+  vklRelease(truth);
+}
+
+TEST_CASE("Structured volume region updates", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  // not a multiple of the macrocell or brick sizes
+  const vec3i dimensions(70, 53, 41);
+
+  // an interior slab, and a corner touching the upper boundary
+  const std::vector<box3i> regions{
+      box3i(vec3i(17, 0, 9), vec3i(33, 53, 10)),
+      box3i(vec3i(60, 40, 30), vec3i(80, 60, 50))};
+
+  for (const auto &region : regions) {
+    INFO("region = " << region.lower.x << " " << region.lower.y << " "
+                      << region.lower.z << " - " << region.upper.x << " "
+                      << region.upper.y << " " << region.upper.z);
+
+    for (int brickSize : {0, 8}) {
+      for (int mipLevels : {0, 2}) {
+        updated_matches_committed(dimensions, brickSize, mipLevels, region);
+      }
+    }
+  }
+}
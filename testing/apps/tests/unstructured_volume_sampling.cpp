@@ -14,13 +14,32 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
 #include "../../external/catch.hpp"
+#include "openvkl/drivers/ispc/volume/UnstructuredFaceNeighbors.h"
 #include "openvkl_testing.h"
 #include "ospcommon/utility/multidim_index_sequence.h"
 
 using namespace ospcommon;
 using namespace openvkl::testing;
 
+// debug messages of the driver, which tell whether hinted samples were found
+// by walking cells
+static std::vector<std::string> logMessages;
+
+static void logFunction(const char *message)
+{
+  logMessages.push_back(message);
+}
+
+static size_t countLogMessages(const std::string &text)
+{
+  return std::count_if(
+      logMessages.begin(), logMessages.end(), [&](const std::string &m) {
+        return m.find(text) != std::string::npos;
+      });
+}
+
 template <typename volumeType>
 void scalar_sampling_test_prim_geometry(VKLUnstructuredCellType primType,
                                         bool cellValued,
@@ -138,11 +157,170 @@ void scalar_sampling_on_vertices_vs_procedural_values(
   }
 }
 
+// wide BVHs and multi-cell leaves must not change sampling results; this
+// covers both the single lane and the vectorized traversal
+void wide_bvh_vs_binary_bvh(VKLUnstructuredCellType primType,
+                            int bvhWidth,
+                            int bvhLeafSize)
+{
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> binary(
+      new WaveletUnstructuredProceduralVolume(
+          vec3i(32), vec3f(0.f), vec3f(1.f), primType, true));
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> wide(
+      new WaveletUnstructuredProceduralVolume(
+          vec3i(32), vec3f(0.f), vec3f(1.f), primType, true));
+
+  VKLVolume binaryVolume = binary->getVKLVolume();
+  VKLVolume wideVolume   = wide->getVKLVolume();
+
+  vklSetInt(wideVolume, "bvhWidth", bvhWidth);
+  vklSetInt(wideVolume, "bvhLeafSize", bvhLeafSize);
+  vklCommit(wideVolume);
+
+  const vkl_box3f binaryBounds = vklGetBoundingBox(binaryVolume);
+  const vkl_box3f wideBounds   = vklGetBoundingBox(wideVolume);
+
+  REQUIRE(binaryBounds.lower.x == wideBounds.lower.x);
+  REQUIRE(binaryBounds.lower.y == wideBounds.lower.y);
+  REQUIRE(binaryBounds.lower.z == wideBounds.lower.z);
+  REQUIRE(binaryBounds.upper.x == wideBounds.upper.x);
+  REQUIRE(binaryBounds.upper.y == wideBounds.upper.y);
+  REQUIRE(binaryBounds.upper.z == wideBounds.upper.z);
+
+  const vkl_range1f binaryRange = vklGetValueRange(binaryVolume);
+  const vkl_range1f wideRange   = vklGetValueRange(wideVolume);
+
+  REQUIRE(binaryRange.lower == wideRange.lower);
+  REQUIRE(binaryRange.upper == wideRange.upper);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  // including positions outside of the volume
+  std::uniform_real_distribution<float> dist(-1.f, 33.f);
+
+  std::vector<vec3f> objectCoordinates(1000);
+
+  for (auto &oc : objectCoordinates) {
+    oc = vec3f(dist(eng), dist(eng), dist(eng));
+
+    INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+    const float binarySample =
+        vklComputeSample(binaryVolume, (const vkl_vec3f *)&oc);
+    const float wideSample =
+        vklComputeSample(wideVolume, (const vkl_vec3f *)&oc);
+
+    if (std::isnan(binarySample))
+      REQUIRE(std::isnan(wideSample));
+    else
+      REQUIRE(wideSample == Approx(binarySample).margin(1e-5f));
+  }
+
+  std::vector<float> binarySamples(objectCoordinates.size());
+  std::vector<float> wideSamples(objectCoordinates.size());
+
+  vklComputeSampleStreamAOS(binaryVolume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            binarySamples.data());
+
+  vklComputeSampleStreamAOS(wideVolume,
+                            objectCoordinates.size(),
+                            (const vkl_vec3f *)objectCoordinates.data(),
+                            wideSamples.data());
+
+  for (size_t i = 0; i < objectCoordinates.size(); i++) {
+    INFO("sample = " << i + 1 << " / " << objectCoordinates.size());
+
+    if (std::isnan(binarySamples[i]))
+      REQUIRE(std::isnan(wideSamples[i]));
+    else
+      REQUIRE(wideSamples[i] == Approx(binarySamples[i]).margin(1e-5f));
+  }
+}
+
+// hinted sampling along rays, which leave and reenter the volume, must match
+// unhinted sampling, and walk cells from the hint if neighbors are available
+void hinted_vs_unhinted(VKLUnstructuredCellType primType,
+                        bool precomputedNeighbors)
+{
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> v(
+      new WaveletUnstructuredProceduralVolume(
+          vec3i(32), vec3f(0.f), vec3f(1.f), primType, false));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vklSetBool(vklVolume, "precomputedNeighbors", precomputedNeighbors);
+  vklCommit(vklVolume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> originDist(-1.f, 33.f);
+  std::uniform_real_distribution<float> directionDist(-1.f, 1.f);
+
+  for (int r = 0; r < 20; r++) {
+    const vec3f origin(originDist(eng), originDist(eng), originDist(eng));
+    const vec3f direction = normalize(
+        vec3f(directionDist(eng), directionDist(eng), directionDist(eng)));
+
+    // odd rays start from a hint naming no cell, which must be ignored
+    uint64_t hint = (r % 2) ? uint64_t(-1) : 0;
+
+    for (int i = 0; i < 200; i++) {
+      const vec3f oc = origin + (0.37f * i) * direction;
+
+      INFO("objectCoordinates = " << oc.x << " " << oc.y << " " << oc.z);
+
+      const float sample = vklComputeSample(vklVolume, (const vkl_vec3f *)&oc);
+      const float hintedSample =
+          vklComputeSampleHint(vklVolume, (const vkl_vec3f *)&oc, &hint);
+
+      if (std::isnan(sample))
+        REQUIRE(std::isnan(hintedSample));
+      else
+        REQUIRE(hintedSample == Approx(sample).margin(1e-5f));
+    }
+  }
+
+  // the walk count is logged when the volume is released
+  logMessages.clear();
+  v.reset();
+
+  REQUIRE(countLogMessages("hinted samples by walking cells") ==
+          (precomputedNeighbors ? 1 : 0));
+}
+
+// cells sharing a face must be found as neighbors, whatever the local order of
+// the shared vertices
+void face_neighbors(const std::vector<uint8_t> &cellTypes,
+                    const std::vector<std::vector<uint64_t>> &cells,
+                    const std::vector<uint64_t> &expectedNeighbors)
+{
+  const std::vector<uint64_t> faceNeighbors =
+      openvkl::ispc_driver::computeFaceNeighbors(
+          cells.size(),
+          [&](uint64_t cellId) { return cellTypes[cellId]; },
+          [&](uint64_t cellId, uint32_t vertex) {
+            return cells[cellId][vertex];
+          });
+
+  REQUIRE(faceNeighbors.size() == expectedNeighbors.size());
+
+  for (size_t i = 0; i < faceNeighbors.size(); i++) {
+    INFO("cell = " << i / 6 << " face = " << i % 6);
+    REQUIRE(faceNeighbors[i] == expectedNeighbors[i]);
+  }
+}
+
 TEST_CASE("Unstructured volume sampling", "[volume_sampling]")
 {
   vklLoadModule("ispc_driver");
 
   VKLDriver driver = vklNewDriver("ispc");
+  vklDriverSetLogFunc(driver, logFunction);
+  vklDriverSetInt(driver, "logLevel", VKL_LOG_DEBUG);
   vklCommitDriver(driver);
   vklSetCurrentDriver(driver);
 
@@ -233,4 +411,49 @@ TEST_CASE("Unstructured volume sampling", "[volume_sampling]")
           VKL_PYRAMID, cellValued, indexPrefix, precomputedNormals, false);
     }
   }
+
+  SECTION("wide BVH")
+  {
+    for (auto primType : {VKL_HEXAHEDRON, VKL_TETRAHEDRON}) {
+      for (int bvhWidth : {2, 4, 8}) {
+        for (int bvhLeafSize : {1, 4}) {
+          INFO("primType = " << primType << " bvhWidth = " << bvhWidth
+                             << " bvhLeafSize = " << bvhLeafSize);
+          wide_bvh_vs_binary_bvh(primType, bvhWidth, bvhLeafSize);
+        }
+      }
+    }
+  }
+
+  SECTION("hinted sampling")
+  {
+    for (auto primType :
+         {VKL_HEXAHEDRON, VKL_TETRAHEDRON, VKL_WEDGE, VKL_PYRAMID}) {
+      for (bool precomputedNeighbors : {false, true}) {
+        INFO("primType = " << primType << " precomputedNeighbors = "
+                           << precomputedNeighbors);
+        hinted_vs_unhinted(primType, precomputedNeighbors);
+      }
+    }
+  }
+
+  SECTION("face neighbors")
+  {
+    const uint64_t none = uint64_t(-1);
+
+    // two tetrahedra sharing the triangle (0, 1, 2), which is the first face
+    // of the first and the third face of the second
+    face_neighbors({VKL_TETRAHEDRON, VKL_TETRAHEDRON},
+                   {{0, 1, 2, 3}, {4, 1, 2, 0}},
+                   {1, none, none, none, none, none,
+                    none, none, 0, none, none, none});
+
+    // a pyramid on the top quad of a hexahedron, and a tetrahedron on a
+    // triangle of the pyramid
+    face_neighbors({VKL_HEXAHEDRON, VKL_PYRAMID, VKL_TETRAHEDRON},
+                   {{0, 1, 2, 3, 4, 5, 6, 7}, {7, 6, 5, 4, 8}, {8, 9, 5, 4}},
+                   {none, none, none, none, none, 1,
+                    0, none, none, 2, none, none,
+                    none, none, none, 1, none, none});
+  }
 }
@@ -0,0 +1,192 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../../external/catch.hpp"
+#include "comparison_utility.h"
+#include "openvkl_testing.h"
+
+using namespace ospcommon;
+using namespace openvkl::testing;
+
+static const char *cacheFilename = "vkl_unstructured_refit_test.bin";
+
+// debug messages of the driver, which tell whether the BVH was refit
+static std::vector<std::string> logMessages;
+
+static void logFunction(const char *message)
+{
+  logMessages.push_back(message);
+}
+
+static size_t countLogMessages(const std::string &text)
+{
+  return std::count_if(
+      logMessages.begin(), logMessages.end(), [&](const std::string &m) {
+        return m.find(text) != std::string::npos;
+      });
+}
+
+// a volume committed again with only new values, so that its BVH is refit,
+// must match one committed from scratch on the same values. with fromCache,
+// the BVH is first mapped from an accelerator cache, and must be copied to
+// be refit
+void refit_matches_committed(VKLUnstructuredCellType primType,
+                             bool cellValued,
+                             int bvhWidth,
+                             bool fromCache)
+{
+  const vec3i dimensions(16);
+
+  auto v = ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+      dimensions, vec3f(0.f), vec3f(1.f), primType, cellValued);
+  auto truth = ospcommon::make_unique<XYZUnstructuredProceduralVolume>(
+      dimensions, vec3f(0.f), vec3f(1.f), primType, cellValued);
+
+  VKLVolume volume      = v->getVKLVolume();
+  VKLVolume truthVolume = truth->getVKLVolume();
+
+  // the volumes were committed on construction; a new BVH leaf size makes
+  // sure the volume is not refit already when the cache is set
+  const int bvhLeafSize = fromCache ? 2 : 1;
+
+  if (fromCache) {
+    auto source = ospcommon::make_unique<WaveletUnstructuredProceduralVolume>(
+        dimensions, vec3f(0.f), vec3f(1.f), primType, cellValued);
+    vklSetInt(source->getVKLVolume(), "bvhWidth", bvhWidth);
+    vklSetInt(source->getVKLVolume(), "bvhLeafSize", bvhLeafSize);
+    vklCommit(source->getVKLVolume());
+    vklVolumeSerializeAccelerator(source->getVKLVolume(), cacheFilename);
+
+    vklSetString(volume, "acceleratorCache", cacheFilename);
+  }
+
+  vklSetInt(volume, "bvhWidth", bvhWidth);
+  vklSetInt(volume, "bvhLeafSize", bvhLeafSize);
+  vklCommit(volume);
+  vklSetInt(truthVolume, "bvhWidth", bvhWidth);
+  vklSetInt(truthVolume, "bvhLeafSize", bvhLeafSize);
+  vklCommit(truthVolume);
+
+  // the values of the truth volume
+  const vec3i valueDimensions = cellValued ? dimensions : dimensions + 1;
+
+  std::vector<float> values;
+  for (int z = 0; z < valueDimensions.z; z++)
+    for (int y = 0; y < valueDimensions.y; y++)
+      for (int x = 0; x < valueDimensions.x; x++)
+        values.push_back(getXYZValue<float>(vec3f(x, y, z)));
+
+  VKLData valuesData = vklNewData(values.size(), VKL_FLOAT, values.data());
+  vklSetData(volume, cellValued ? "cell.data" : "vertex.data", valuesData);
+  vklRelease(valuesData);
+
+  logMessages.clear();
+  vklCommit(volume);
+
+  REQUIRE(countLogMessages("refitting unstructured volume BVH") == 1);
+  REQUIRE(countLogMessages("copying unstructured volume BVH") ==
+          (fromCache ? 1 : 0));
+
+  if (fromCache)
+    std::remove(cacheFilename);
+
+  compare_volumes(volume, truthVolume);
+}
+
+// positions changed in place in shared data must be picked up by a recommit,
+// which rebuilds the BVH rather than refitting it
+void in_place_positions_rebuild()
+{
+  std::vector<vec3f> positions{vec3f(0.f, 0.f, 0.f),
+                               vec3f(1.f, 0.f, 0.f),
+                               vec3f(1.f, 1.f, 0.f),
+                               vec3f(0.f, 1.f, 0.f),
+                               vec3f(0.f, 0.f, 1.f),
+                               vec3f(1.f, 0.f, 1.f),
+                               vec3f(1.f, 1.f, 1.f),
+                               vec3f(0.f, 1.f, 1.f)};
+  const std::vector<uint32_t> indices{0, 1, 2, 3, 4, 5, 6, 7};
+  const std::vector<uint32_t> cells{0};
+  const std::vector<uint8_t> cellTypes{VKL_HEXAHEDRON};
+  const std::vector<float> values{0.f, 1.f, 1.f, 0.f, 0.f, 1.f, 1.f, 0.f};
+
+  VKLData positionsData = vklNewData(
+      positions.size(), VKL_VEC3F, positions.data(), VKL_DATA_SHARED_BUFFER);
+  VKLData indicesData = vklNewData(indices.size(), VKL_UINT, indices.data());
+  VKLData cellsData   = vklNewData(cells.size(), VKL_UINT, cells.data());
+  VKLData cellTypesData =
+      vklNewData(cellTypes.size(), VKL_UCHAR, cellTypes.data());
+  VKLData valuesData = vklNewData(values.size(), VKL_FLOAT, values.data());
+
+  VKLVolume volume = vklNewVolume("unstructured");
+  vklSetData(volume, "vertex.position", positionsData);
+  vklSetData(volume, "index", indicesData);
+  vklSetData(volume, "cell.index", cellsData);
+  vklSetData(volume, "cell.type", cellTypesData);
+  vklSetData(volume, "vertex.data", valuesData);
+  vklCommit(volume);
+
+  REQUIRE(vklGetBoundingBox(volume).upper.x == 1.f);
+
+  for (auto &p : positions)
+    p.x *= 2.f;
+
+  logMessages.clear();
+  vklCommit(volume);
+
+  REQUIRE(countLogMessages("refitting unstructured volume BVH") == 0);
+  REQUIRE(vklGetBoundingBox(volume).upper.x == 2.f);
+
+  const vkl_vec3f oc{1.5f, 0.5f, 0.5f};
+  REQUIRE(vklComputeSample(volume, &oc) == Approx(0.75f));
+
+  vklRelease(volume);
+  vklRelease(positionsData);
+  vklRelease(indicesData);
+  vklRelease(cellsData);
+  vklRelease(cellTypesData);
+  vklRelease(valuesData);
+}
+
+TEST_CASE("Unstructured volume value updates", "[volume_sampling]")
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklDriverSetLogFunc(driver, logFunction);
+  vklDriverSetInt(driver, "logLevel", VKL_LOG_DEBUG);
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  for (auto primType : {VKL_HEXAHEDRON, VKL_TETRAHEDRON, VKL_WEDGE}) {
+    for (bool cellValued : {false, true}) {
+      for (int bvhWidth : {2, 8}) {
+        for (bool fromCache : {false, true}) {
+          INFO("primType = " << primType << " cellValued = " << cellValued
+                             << " bvhWidth = " << bvhWidth
+                             << " fromCache = " << fromCache);
+          refit_matches_committed(primType, cellValued, bvhWidth, fromCache);
+        }
+      }
+    }
+  }
+
+  in_place_positions_rebuild();
+}
@@ -97,6 +97,89 @@ void randomized_vectorized_gradients(VKLVolume volume)
   }
 }
 
+void randomized_vectorized_sample_and_gradients(VKLVolume volume)
+{
+  vkl_box3f bbox = vklGetBoundingBox(volume);
+
+  std::random_device rd;
+  std::mt19937 eng(rd());
+
+  std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+  std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+  std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+
+  const int maxWidth = 16;
+
+  std::array<int, 3> nativeWidths{4, 8, 16};
+
+  for (int width = 1; width < maxWidth; width++) {
+    std::vector<vec3f> objectCoordinates(width);
+    for (auto &oc : objectCoordinates) {
+      oc = vec3f(distX(eng), distY(eng), distZ(eng));
+    }
+
+    for (const int &callingWidth : nativeWidths) {
+      if (width > callingWidth) {
+        continue;
+      }
+
+      std::vector<int> valid(callingWidth, 0);
+      std::fill(valid.begin(), valid.begin() + width, 1);
+
+      std::vector<float> objectCoordinatesSOA =
+          AOStoSOA_vec3f(objectCoordinates, callingWidth);
+
+      float samples[16];
+      std::vector<vec3f> gradients;
+
+      if (callingWidth == 4) {
+        vkl_vvec3f4 gradients4;
+        vklComputeSampleAndGradient4(
+            valid.data(),
+            volume,
+            (const vkl_vvec3f4 *)objectCoordinatesSOA.data(),
+            samples,
+            &gradients4);
+        gradients = SOAtoAOS_vvec3f(gradients4);
+      } else if (callingWidth == 8) {
+        vkl_vvec3f8 gradients8;
+        vklComputeSampleAndGradient8(
+            valid.data(),
+            volume,
+            (const vkl_vvec3f8 *)objectCoordinatesSOA.data(),
+            samples,
+            &gradients8);
+        gradients = SOAtoAOS_vvec3f(gradients8);
+      } else if (callingWidth == 16) {
+        vkl_vvec3f16 gradients16;
+        vklComputeSampleAndGradient16(
+            valid.data(),
+            volume,
+            (const vkl_vvec3f16 *)objectCoordinatesSOA.data(),
+            samples,
+            &gradients16);
+        gradients = SOAtoAOS_vvec3f(gradients16);
+      } else {
+        throw std::runtime_error("unsupported calling width");
+      }
+
+      for (int i = 0; i < width; i++) {
+        vkl_vec3f gradientTruth;
+        float sampleTruth = vklComputeSampleAndGradient(
+            volume, (const vkl_vec3f *)&objectCoordinates[i], &gradientTruth);
+
+        INFO("sample = " << i + 1 << " / " << width
+                         << ", calling width = " << callingWidth);
+
+        REQUIRE(sampleTruth == samples[i]);
+        REQUIRE(gradientTruth.x == gradients[i].x);
+        REQUIRE(gradientTruth.y == gradients[i].y);
+        REQUIRE(gradientTruth.z == gradients[i].z);
+      }
+    }
+  }
+}
+
 TEST_CASE("Vectorized gradients", "[volume_gradients]")
 {
   vklLoadModule("ispc_driver");
@@ -116,6 +199,7 @@ TEST_CASE("Vectorized gradients", "[volume_gradients]")
     VKLVolume volume = v->getVKLVolume();
 
     randomized_vectorized_gradients(volume);
+    randomized_vectorized_sample_and_gradients(volume);
   }
 
   SECTION(
@@ -129,5 +213,26 @@ TEST_CASE("Vectorized gradients", "[volume_gradients]")
     VKLVolume volume = v->getVKLVolume();
 
     randomized_vectorized_gradients(volume);
+    randomized_vectorized_sample_and_gradients(volume);
+  }
+
+  SECTION(
+      "randomized vectorized gradients varying calling width and masks: "
+      "AMR volumes")
+  {
+    std::unique_ptr<ProceduralShellsAMRVolume<>> v(
+        new ProceduralShellsAMRVolume<>(vec3i(128), vec3f(0.f), vec3f(1.f)));
+
+    VKLVolume volume = v->getVKLVolume();
+
+    for (auto method : {VKL_AMR_CURRENT, VKL_AMR_FINEST, VKL_AMR_OCTANT}) {
+      INFO("method = " << method);
+
+      vklSetInt(volume, "method", method);
+      vklCommit(volume);
+
+      randomized_vectorized_gradients(volume);
+      randomized_vectorized_sample_and_gradients(volume);
+    }
   }
 }
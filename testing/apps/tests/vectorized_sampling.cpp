@@ -14,7 +14,9 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include "../../external/catch.hpp"
 #include "aos_soa_conversion.h"
 #include "openvkl_testing.h"
@@ -23,6 +25,86 @@
 using namespace ospcommon;
 using namespace openvkl::testing;
 
+// wavelet volume with a nonzero label at every voxel, so segmentation results
+// are checked against actual labels
+struct LabeledWaveletStructuredRegularVolume
+    : public WaveletStructuredRegularVolume<float>
+{
+  LabeledWaveletStructuredRegularVolume(const vec3i &dimensions,
+                                        const vec3f &gridOrigin,
+                                        const vec3f &gridSpacing)
+      : WaveletStructuredRegularVolume<float>(
+            dimensions, gridOrigin, gridSpacing),
+        labelDimensions(dimensions)
+  {
+  }
+
+  std::vector<unsigned char> generateLabels() override
+  {
+    std::vector<unsigned char> labels;
+    labels.reserve(labelDimensions.long_product());
+
+    for (int z = 0; z < labelDimensions.z; z++) {
+      for (int y = 0; y < labelDimensions.y; y++) {
+        for (int x = 0; x < labelDimensions.x; x++) {
+          labels.push_back(label(vec3i(x, y, z)));
+        }
+      }
+    }
+
+    return labels;
+  }
+
+  // label of the voxel nearest to the given position, which must be on the
+  // unit-spaced grid at the origin; 0 outside the volume
+  uint8_t labelAt(const vec3f &oc) const
+  {
+    if (oc.x < 0.f || oc.x > labelDimensions.x - 1.f || oc.y < 0.f ||
+        oc.y > labelDimensions.y - 1.f || oc.z < 0.f ||
+        oc.z > labelDimensions.z - 1.f) {
+      return 0;
+    }
+
+    return label(vec3i(std::min(int(oc.x + 0.5f), labelDimensions.x - 1),
+                       std::min(int(oc.y + 0.5f), labelDimensions.y - 1),
+                       std::min(int(oc.z + 0.5f), labelDimensions.z - 1)));
+  }
+
+ private:
+  static uint8_t label(const vec3i &index)
+  {
+    return uint8_t(1 + (index.x + 3 * index.y + 7 * index.z) % 200);
+  }
+
+  vec3i labelDimensions;
+};
+
+// labels the test volumes must report; volumes without labels report 0
+template <typename VOLUME_TYPE>
+uint8_t expectedLabel(const VOLUME_TYPE &, const vec3f &)
+{
+  return 0;
+}
+
+uint8_t expectedLabel(const LabeledWaveletStructuredRegularVolume &v,
+                      const vec3f &oc)
+{
+  return v.labelAt(oc);
+}
+
+// positions this close to the midpoint between voxels may round to either
+// voxel, depending on the coordinate transformation
+static bool nearLabelBoundary(const vec3f &oc)
+{
+  for (int i = 0; i < 3; i++) {
+    if (std::abs(oc[i] - std::floor(oc[i]) - 0.5f) < 1e-3f) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 template <typename VOLUME_TYPE>
 void test_vectorized_sampling()
 {
@@ -96,6 +178,215 @@ void test_vectorized_sampling()
       }
     }
   }
+
+  SECTION(
+      "randomized vectorized segmentation sampling varying calling width and "
+      "masks")
+  {
+    vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+    std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+    std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+
+    const int maxWidth = 16;
+
+    std::array<int, 3> nativeWidths{4, 8, 16};
+
+    for (int width = 1; width < maxWidth; width++) {
+      std::vector<vec3f> objectCoordinates(width);
+      for (auto &oc : objectCoordinates) {
+        oc = vec3f(distX(eng), distY(eng), distZ(eng));
+      }
+
+      for (auto callingWidth : nativeWidths) {
+        if (width > callingWidth) {
+          continue;
+        }
+
+        std::vector<int> valid(callingWidth, 0);
+        std::fill(valid.begin(), valid.begin() + width, 1);
+
+        std::vector<float> objectCoordinatesSOA =
+            AOStoSOA_vec3f(objectCoordinates, callingWidth);
+
+        float samples[16];
+        uint8_t segmentation[16];
+
+        if (callingWidth == 4) {
+          vklComputeSampleSeg4(valid.data(),
+                               vklVolume,
+                               (const vkl_vvec3f4 *)objectCoordinatesSOA.data(),
+                               samples,
+                               segmentation);
+        } else if (callingWidth == 8) {
+          vklComputeSampleSeg8(valid.data(),
+                               vklVolume,
+                               (const vkl_vvec3f8 *)objectCoordinatesSOA.data(),
+                               samples,
+                               segmentation);
+
+        } else if (callingWidth == 16) {
+          vklComputeSampleSeg16(
+              valid.data(),
+              vklVolume,
+              (const vkl_vvec3f16 *)objectCoordinatesSOA.data(),
+              samples,
+              segmentation);
+        } else {
+          throw std::runtime_error("unsupported calling width");
+        }
+
+        for (int i = 0; i < width; i++) {
+          uint8_t segmentationTruth;
+          float sampleTruth =
+              vklComputeSampleSeg(vklVolume,
+                                  (const vkl_vec3f *)&objectCoordinates[i],
+                                  &segmentationTruth);
+
+          INFO("sample = " << i + 1 << " / " << width
+                           << ", calling width = " << callingWidth);
+          REQUIRE(sampleTruth == samples[i]);
+          REQUIRE(segmentationTruth == segmentation[i]);
+
+          if (!nearLabelBoundary(objectCoordinates[i])) {
+            REQUIRE(segmentation[i] ==
+                    expectedLabel(*v, objectCoordinates[i]));
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("randomized stream sampling for SOA and AOS layouts")
+  {
+    vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+    std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+    std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+
+    // includes lengths that are not multiples of any SIMD width, and one
+    // long enough to be split across multiple tasks
+    std::array<size_t, 4> counts{1, 17, 1000, 40000};
+
+    for (auto count : counts) {
+      std::vector<vkl_vec3f> objectCoordinates(count);
+      std::vector<float> x(count), y(count), z(count);
+
+      for (size_t i = 0; i < count; i++) {
+        objectCoordinates[i] = vkl_vec3f{distX(eng), distY(eng), distZ(eng)};
+
+        x[i] = objectCoordinates[i].x;
+        y[i] = objectCoordinates[i].y;
+        z[i] = objectCoordinates[i].z;
+      }
+
+      std::vector<float> samplesSOA(count);
+      std::vector<float> samplesAOS(count);
+
+      vklComputeSampleStream(
+          vklVolume, count, x.data(), y.data(), z.data(), samplesSOA.data());
+
+      vklComputeSampleStreamAOS(
+          vklVolume, count, objectCoordinates.data(), samplesAOS.data());
+
+      for (size_t i = 0; i < count; i++) {
+        float sampleTruth = vklComputeSample(vklVolume, &objectCoordinates[i]);
+
+        INFO("sample = " << i + 1 << " / " << count);
+        REQUIRE(sampleTruth == samplesSOA[i]);
+        REQUIRE(sampleTruth == samplesAOS[i]);
+      }
+    }
+  }
+
+  SECTION("fixed-step ray sampling")
+  {
+    vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    std::uniform_real_distribution<float> distX(bbox.lower.x, bbox.upper.x);
+    std::uniform_real_distribution<float> distY(bbox.lower.y, bbox.upper.y);
+    std::uniform_real_distribution<float> distZ(bbox.lower.z, bbox.upper.z);
+    std::uniform_real_distribution<float> distDir(-1.f, 1.f);
+
+    // rays leave the volume, so out-of-bounds steps are covered as well
+    const size_t numRays  = 37;
+    const size_t numSteps = 129;
+    const float dt        = 0.5f;
+
+    std::vector<vkl_vec3f> origins(numRays);
+    std::vector<vkl_vec3f> directions(numRays);
+    std::vector<float> tStart(numRays);
+
+    for (size_t i = 0; i < numRays; i++) {
+      origins[i]    = vkl_vec3f{distX(eng), distY(eng), distZ(eng)};
+      directions[i] = vkl_vec3f{distDir(eng), distDir(eng), distDir(eng)};
+      tStart[i]     = 0.25f * i;
+    }
+
+    std::vector<float> values(numRays * numSteps);
+    std::vector<uint8_t> labels(numRays * numSteps);
+
+    vklSampleRays(vklVolume,
+                  numRays,
+                  origins.data(),
+                  directions.data(),
+                  tStart.data(),
+                  dt,
+                  numSteps,
+                  values.data(),
+                  labels.data());
+
+    // structured regular volumes step in grid space, so positions may differ
+    // from the direct evaluation by rounding; this can only flip inside /
+    // outside classification where a ray enters or leaves the volume
+    size_t numBoundaryMismatches = 0;
+
+    for (size_t i = 0; i < numRays; i++) {
+      for (size_t j = 0; j < numSteps; j++) {
+        const float t = tStart[i] + j * dt;
+
+        const vkl_vec3f c{origins[i].x + t * directions[i].x,
+                          origins[i].y + t * directions[i].y,
+                          origins[i].z + t * directions[i].z};
+
+        uint8_t labelTruth;
+        const float sampleTruth =
+            vklComputeSampleSeg(vklVolume, &c, &labelTruth);
+
+        const float sample = values[i * numSteps + j];
+
+        if (std::isnan(sampleTruth) != std::isnan(sample)) {
+          numBoundaryMismatches++;
+          continue;
+        }
+
+        if (std::isnan(sample)) {
+          continue;
+        }
+
+        INFO("ray = " << i << ", step = " << j);
+        REQUIRE(sample == Approx(sampleTruth).epsilon(1e-3f).margin(1e-3f));
+        // the rounding of the stepped positions may select a neighboring voxel
+        if (!nearLabelBoundary((const vec3f &)c)) {
+          REQUIRE(labels[i * numSteps + j] == labelTruth);
+          REQUIRE(labelTruth == expectedLabel(*v, (const vec3f &)c));
+        }
+      }
+    }
+
+    REQUIRE(numBoundaryMismatches <= 2 * numRays);
+  }
 }
 
 TEST_CASE("Vectorized sampling", "[volume_sampling]")
@@ -111,6 +402,11 @@ TEST_CASE("Vectorized sampling", "[volume_sampling]")
     test_vectorized_sampling<WaveletStructuredRegularVolume<float>>();
   }
 
+  SECTION("structured with labels")
+  {
+    test_vectorized_sampling<LabeledWaveletStructuredRegularVolume>();
+  }
+
   SECTION("unstructured")
   {
     test_vectorized_sampling<WaveletUnstructuredProceduralVolume>();
@@ -0,0 +1,431 @@
+// ======================================================================== //
+// Copyright 2019 Intel Corporation                                         //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cmath>
+#include <random>
+#include "benchmark/benchmark.h"
+#include "openvkl_testing.h"
+#include "ospcommon/utility/random.h"
+
+using namespace openvkl::testing;
+using namespace ospcommon::utility;
+
+void initializeOpenVKL()
+{
+  vklLoadModule("ispc_driver");
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+}
+
+// all benchmarks take the VKLAMRMethod as range(0)
+static std::unique_ptr<ProceduralShellsAMRVolume<>> newVolume(
+    benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<ProceduralShellsAMRVolume<>>(
+      vec3i(256), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vklSetInt(vklVolume, "method", state.range(0));
+  vklCommit(vklVolume);
+
+  return v;
+}
+
+static void scalarRandomSample(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  for (auto _ : state) {
+    vkl_vec3f objectCoordinates{distX(), distY(), distZ()};
+
+    benchmark::DoNotOptimize(
+        vklComputeSample(vklVolume, (const vkl_vec3f *)&objectCoordinates));
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(scalarRandomSample)->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+template <int W>
+void vectorRandomSample(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  int valid[W];
+
+  for (int i = 0; i < W; i++) {
+    valid[i] = 1;
+  }
+
+  struct vvec3f
+  {
+    float x[W];
+    float y[W];
+    float z[W];
+  };
+
+  vvec3f objectCoordinates;
+  float samples[W];
+
+  for (auto _ : state) {
+    for (int i = 0; i < W; i++) {
+      objectCoordinates.x[i] = distX();
+      objectCoordinates.y[i] = distY();
+      objectCoordinates.z[i] = distZ();
+    }
+
+    if (W == 4) {
+      vklComputeSample4(
+          valid, vklVolume, (const vkl_vvec3f4 *)&objectCoordinates, samples);
+    } else if (W == 8) {
+      vklComputeSample8(
+          valid, vklVolume, (const vkl_vvec3f8 *)&objectCoordinates, samples);
+    } else if (W == 16) {
+      vklComputeSample16(
+          valid, vklVolume, (const vkl_vvec3f16 *)&objectCoordinates, samples);
+    } else {
+      throw std::runtime_error(
+          "vectorRandomSample benchmark called with unimplemented calling "
+          "width");
+    }
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * W);
+}
+
+BENCHMARK_TEMPLATE(vectorRandomSample, 4)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+BENCHMARK_TEMPLATE(vectorRandomSample, 8)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+BENCHMARK_TEMPLATE(vectorRandomSample, 16)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+// a stream of random coordinates, so that nearly every sample looks up a
+// different k-d tree leaf
+static void streamRandomSample(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  const size_t count = 1 << 16;
+
+  std::vector<float> x(count), y(count), z(count);
+
+  for (size_t i = 0; i < count; i++) {
+    x[i] = distX();
+    y[i] = distY();
+    z[i] = distZ();
+  }
+
+  std::vector<float> samples(count);
+
+  for (auto _ : state) {
+    vklComputeSampleStream(
+        vklVolume, count, x.data(), y.data(), z.data(), samples.data());
+
+    benchmark::DoNotOptimize(samples.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(streamRandomSample)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT)
+    ->UseRealTime();
+
+static void scalarRandomGradient(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  for (auto _ : state) {
+    vkl_vec3f objectCoordinates{distX(), distY(), distZ()};
+
+    benchmark::DoNotOptimize(
+        vklComputeGradient(vklVolume, (const vkl_vec3f *)&objectCoordinates));
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(scalarRandomGradient)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+template <int W>
+void vectorRandomGradient(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  int valid[W];
+
+  for (int i = 0; i < W; i++) {
+    valid[i] = 1;
+  }
+
+  struct vvec3f
+  {
+    float x[W];
+    float y[W];
+    float z[W];
+  };
+
+  vvec3f objectCoordinates;
+  vkl_vvec3f4 gradient4;
+  vkl_vvec3f8 gradient8;
+  vkl_vvec3f16 gradient16;
+
+  for (auto _ : state) {
+    for (int i = 0; i < W; i++) {
+      objectCoordinates.x[i] = distX();
+      objectCoordinates.y[i] = distY();
+      objectCoordinates.z[i] = distZ();
+    }
+
+    if (W == 4) {
+      vklComputeGradient4(valid,
+                          vklVolume,
+                          (const vkl_vvec3f4 *)&objectCoordinates,
+                          &gradient4);
+    } else if (W == 8) {
+      vklComputeGradient8(valid,
+                          vklVolume,
+                          (const vkl_vvec3f8 *)&objectCoordinates,
+                          &gradient8);
+    } else if (W == 16) {
+      vklComputeGradient16(valid,
+                           vklVolume,
+                           (const vkl_vvec3f16 *)&objectCoordinates,
+                           &gradient16);
+    } else {
+      throw std::runtime_error(
+          "vectorRandomGradient benchmark called with unimplemented calling "
+          "width");
+    }
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * W);
+}
+
+BENCHMARK_TEMPLATE(vectorRandomGradient, 4)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+BENCHMARK_TEMPLATE(vectorRandomGradient, 8)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+BENCHMARK_TEMPLATE(vectorRandomGradient, 16)
+    ->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+// rays entering through the lower z face of the volume
+static void randomRays(VKLVolume vklVolume,
+                       size_t numRays,
+                       std::vector<vkl_vec3f> &origins,
+                       std::vector<vkl_vec3f> &directions)
+{
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distDir(rd(), 0, -0.5f, 0.5f);
+
+  origins.resize(numRays);
+  directions.resize(numRays);
+
+  for (size_t i = 0; i < numRays; i++) {
+    origins[i]    = vkl_vec3f{distX(), distY(), bbox.lower.z - 1.f};
+    directions[i] = vkl_vec3f{distDir(), distDir(), 1.f};
+  }
+}
+
+// between the values of the two finest shells
+static const float shellIsoValue = 0.5f;
+
+// find all hits of the isosurface around the finest shell
+static void scalarHitIteration(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(vklVolume);
+  vklValueSelectorSetValues(valueSelector, 1, &shellIsoValue);
+  vklCommit(valueSelector);
+
+  const vkl_range1f tRange{0.f, inf};
+
+  size_t numHits = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      VKLHitIterator iterator;
+      vklInitHitIterator(&iterator,
+                         vklVolume,
+                         &origins[i],
+                         &directions[i],
+                         &tRange,
+                         valueSelector);
+
+      VKLHit hit;
+      while (vklIterateHit(&iterator, &hit)) {
+        numHits++;
+      }
+    }
+  }
+
+  benchmark::DoNotOptimize(numHits);
+
+  vklRelease(valueSelector);
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(scalarHitIteration)->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+// the same rays and isosurface as scalarHitIteration, searched as by the
+// default hit iterator: brackets at a fixed step of 1% of the largest volume
+// extent, regardless of refinement level. this is the baseline for the native
+// AMR hit iterator
+static void scalarHitFixedStep(benchmark::State &state)
+{
+  auto v = newVolume(state);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  const vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+  const vec3f lower    = (const vec3f &)bbox.lower;
+  const vec3f upper    = (const vec3f &)bbox.upper;
+
+  const float step = 0.01f * reduce_max(upper - lower);
+
+  size_t numHits = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      const vec3f origin    = (const vec3f &)origins[i];
+      const vec3f direction = (const vec3f &)directions[i];
+
+      const vec3f t0 = (lower - origin) / direction;
+      const vec3f t1 = (upper - origin) / direction;
+
+      const float tNear = std::max(reduce_max(min(t0, t1)), 0.f);
+      const float tFar  = reduce_min(max(t0, t1));
+
+      float tPrevious = std::floor(tNear / step) * step;
+      vec3f c         = origin + tPrevious * direction;
+      float previous  = vklComputeSample(vklVolume, (const vkl_vec3f *)&c);
+
+      for (float t = tPrevious + step; tPrevious < tFar; t += step) {
+        c                  = origin + t * direction;
+        const float sample = vklComputeSample(vklVolume, (const vkl_vec3f *)&c);
+
+        if ((shellIsoValue - previous) * (shellIsoValue - sample) <= 0.f &&
+            sample != previous) {
+          const float tHit = tPrevious + (shellIsoValue - previous) /
+                                             (sample - previous) *
+                                             (t - tPrevious);
+          if (tHit >= tNear && tHit <= tFar)
+            numHits++;
+        }
+
+        tPrevious = t;
+        previous  = sample;
+      }
+    }
+  }
+
+  benchmark::DoNotOptimize(numHits);
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(scalarHitFixedStep)->DenseRange(VKL_AMR_CURRENT, VKL_AMR_OCTANT);
+
+// based on BENCHMARK_MAIN() macro from benchmark.h
+int main(int argc, char **argv)
+{
+  initializeOpenVKL();
+
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  vklShutdown();
+
+  return 0;
+}
@@ -202,6 +202,308 @@ BENCHMARK_TEMPLATE(vectorFixedSample, 4);
 BENCHMARK_TEMPLATE(vectorFixedSample, 8);
 BENCHMARK_TEMPLATE(vectorFixedSample, 16);
 
+// stream and packet sampling of the same random coordinate arrays, with the
+// stream length given by state.range(0)
+static std::vector<vkl_vec3f> randomObjectCoordinates(VKLVolume vklVolume,
+                                                      size_t count)
+{
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  std::vector<vkl_vec3f> objectCoordinates(count);
+
+  for (auto &oc : objectCoordinates) {
+    oc = vkl_vec3f{distX(), distY(), distZ()};
+  }
+
+  return objectCoordinates;
+}
+
+static void streamRandomSampleSOA(benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(128), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t count = state.range(0);
+
+  std::vector<vkl_vec3f> objectCoordinates =
+      randomObjectCoordinates(vklVolume, count);
+
+  std::vector<float> x(count), y(count), z(count);
+
+  for (size_t i = 0; i < count; i++) {
+    x[i] = objectCoordinates[i].x;
+    y[i] = objectCoordinates[i].y;
+    z[i] = objectCoordinates[i].z;
+  }
+
+  std::vector<float> samples(count);
+
+  for (auto _ : state) {
+    vklComputeSampleStream(
+        vklVolume, count, x.data(), y.data(), z.data(), samples.data());
+
+    benchmark::DoNotOptimize(samples.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(streamRandomSampleSOA)->Range(1 << 10, 1 << 22)->UseRealTime();
+
+static void streamRandomSampleAOS(benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(128), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t count = state.range(0);
+
+  std::vector<vkl_vec3f> objectCoordinates =
+      randomObjectCoordinates(vklVolume, count);
+
+  std::vector<float> samples(count);
+
+  for (auto _ : state) {
+    vklComputeSampleStreamAOS(
+        vklVolume, count, objectCoordinates.data(), samples.data());
+
+    benchmark::DoNotOptimize(samples.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(streamRandomSampleAOS)->Range(1 << 10, 1 << 22)->UseRealTime();
+
+// incoherent sampling of the linear (brickSize 0) vs. bricked voxel layouts,
+// for volumes of dimension^3 voxels given by state.range(0) and the
+// brickSize given by state.range(1)
+static void streamRandomSampleLayout(benchmark::State &state)
+{
+  const int dimension = state.range(0);
+  const int brickSize = state.range(1);
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(dimension), vec3f(0.f), vec3f(1.f));
+
+  v->setBrickSize(brickSize);
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t count = 1 << 20;
+
+  std::vector<vkl_vec3f> objectCoordinates =
+      randomObjectCoordinates(vklVolume, count);
+
+  std::vector<float> samples(count);
+
+  for (auto _ : state) {
+    vklComputeSampleStreamAOS(
+        vklVolume, count, objectCoordinates.data(), samples.data());
+
+    benchmark::DoNotOptimize(samples.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// 768^3 floats (~1.7 GB) is representative of large CT volumes
+BENCHMARK(streamRandomSampleLayout)
+    ->Args({256, 0})
+    ->Args({256, 8})
+    ->Args({256, 16})
+    ->Args({768, 0})
+    ->Args({768, 8})
+    ->Args({768, 16})
+    ->UseRealTime();
+
+// a fan of state.range(0) rays through the volume center, each marched for
+// 512 steps, comparing batched ray sampling against per-step scalar calls
+static void fanRays(VKLVolume vklVolume,
+                    size_t numRays,
+                    std::vector<vkl_vec3f> &origins,
+                    std::vector<vkl_vec3f> &directions)
+{
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  const vkl_vec3f apex{0.5f * (bbox.lower.x + bbox.upper.x),
+                       0.5f * (bbox.lower.y + bbox.upper.y),
+                       bbox.lower.z};
+
+  origins.assign(numRays, apex);
+  directions.resize(numRays);
+
+  const float fov = 60.f * M_PI / 180.f;
+
+  for (size_t i = 0; i < numRays; i++) {
+    const float angle =
+        (float(i) / std::max(numRays - 1, size_t(1)) - 0.5f) * fov;
+
+    directions[i] =
+        vkl_vec3f{0.25f * std::sin(angle), 0.f, 0.25f * std::cos(angle)};
+  }
+}
+
+static void sampleRaysFan(benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(128), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t numRays  = state.range(0);
+  const size_t numSteps = 512;
+
+  std::vector<vkl_vec3f> origins, directions;
+  fanRays(vklVolume, numRays, origins, directions);
+
+  std::vector<float> tStart(numRays, 0.f);
+  std::vector<float> values(numRays * numSteps);
+  std::vector<uint8_t> labels(numRays * numSteps);
+
+  for (auto _ : state) {
+    vklSampleRays(vklVolume,
+                  numRays,
+                  origins.data(),
+                  directions.data(),
+                  tStart.data(),
+                  1.f,
+                  numSteps,
+                  values.data(),
+                  labels.data());
+
+    benchmark::DoNotOptimize(values.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays * numSteps);
+}
+
+BENCHMARK(sampleRaysFan)->Range(16, 256)->UseRealTime();
+
+static void scalarSampleSegFan(benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(128), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t numRays  = state.range(0);
+  const size_t numSteps = 512;
+
+  std::vector<vkl_vec3f> origins, directions;
+  fanRays(vklVolume, numRays, origins, directions);
+
+  std::vector<float> values(numRays * numSteps);
+  std::vector<uint8_t> labels(numRays * numSteps);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      for (size_t j = 0; j < numSteps; j++) {
+        const vkl_vec3f c{origins[i].x + j * directions[i].x,
+                          origins[i].y + j * directions[i].y,
+                          origins[i].z + j * directions[i].z};
+
+        values[i * numSteps + j] =
+            vklComputeSampleSeg(vklVolume, &c, &labels[i * numSteps + j]);
+      }
+    }
+
+    benchmark::DoNotOptimize(values.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays * numSteps);
+}
+
+BENCHMARK(scalarSampleSegFan)->Range(16, 256)->UseRealTime();
+
+template <int W>
+void vectorRandomSampleArray(benchmark::State &state)
+{
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      vec3i(128), vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  const size_t count = state.range(0);
+
+  std::vector<vkl_vec3f> objectCoordinates =
+      randomObjectCoordinates(vklVolume, count);
+
+  std::vector<float> samples(count);
+
+  int valid[W];
+
+  struct vvec3f
+  {
+    float x[W];
+    float y[W];
+    float z[W];
+  };
+
+  vvec3f packCoordinates;
+  float packSamples[W];
+
+  for (auto _ : state) {
+    for (size_t packBegin = 0; packBegin < count; packBegin += W) {
+      for (int i = 0; i < W; i++) {
+        const size_t index = std::min(packBegin + i, count - 1);
+
+        valid[i]             = packBegin + i < count;
+        packCoordinates.x[i] = objectCoordinates[index].x;
+        packCoordinates.y[i] = objectCoordinates[index].y;
+        packCoordinates.z[i] = objectCoordinates[index].z;
+      }
+
+      if (W == 4) {
+        vklComputeSample4(valid,
+                          vklVolume,
+                          (const vkl_vvec3f4 *)&packCoordinates,
+                          packSamples);
+      } else if (W == 8) {
+        vklComputeSample8(valid,
+                          vklVolume,
+                          (const vkl_vvec3f8 *)&packCoordinates,
+                          packSamples);
+      } else if (W == 16) {
+        vklComputeSample16(valid,
+                           vklVolume,
+                           (const vkl_vvec3f16 *)&packCoordinates,
+                           packSamples);
+      } else {
+        throw std::runtime_error(
+            "vectorRandomSampleArray benchmark called with unimplemented "
+            "calling width");
+      }
+
+      for (int i = 0; i < W && packBegin + i < count; i++) {
+        samples[packBegin + i] = packSamples[i];
+      }
+    }
+
+    benchmark::DoNotOptimize(samples.data());
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK_TEMPLATE(vectorRandomSampleArray, 4)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(vectorRandomSampleArray, 8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(vectorRandomSampleArray, 16)->Range(1 << 10, 1 << 22);
+
 static void scalarRandomGradient(benchmark::State &state)
 {
   auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
@@ -570,6 +872,323 @@ BENCHMARK(scalarIntervalIteratorIterateSecond)->Threads(12)->UseRealTime();
 BENCHMARK(scalarIntervalIteratorIterateSecond)->Threads(36)->UseRealTime();
 BENCHMARK(scalarIntervalIteratorIterateSecond)->Threads(72)->UseRealTime();
 
+// a volume of dimension^3 voxels which is 0 everywhere but in a ball around
+// its center, of radiusPercent percent of its size, where it is 1
+static VKLVolume newSparseVolume(int dimension, int radiusPercent)
+{
+  const float center = 0.5f * (dimension - 1);
+  const float radius = 0.01f * radiusPercent * dimension;
+
+  std::vector<float> voxels(size_t(dimension) * dimension * dimension);
+
+  for (int z = 0; z < dimension; z++) {
+    for (int y = 0; y < dimension; y++) {
+      for (int x = 0; x < dimension; x++) {
+        const vec3f d = vec3f(x, y, z) - center;
+
+        voxels[x + dimension * (size_t(y) + size_t(dimension) * z)] =
+            dot(d, d) <= radius * radius ? 1.f : 0.f;
+      }
+    }
+  }
+
+  VKLData data = vklNewData(voxels.size(), VKL_FLOAT, voxels.data());
+
+  VKLVolume volume = vklNewVolume("structured_regular");
+  vklSetVec3i(volume, "dimensions", dimension, dimension, dimension);
+  vklSetVec3f(volume, "gridOrigin", 0.f, 0.f, 0.f);
+  vklSetVec3f(volume, "gridSpacing", 1.f, 1.f, 1.f);
+  vklSetData(volume, "data", data);
+  vklCommit(volume);
+
+  vklRelease(data);
+
+  return volume;
+}
+
+// rays entering through the lower z face of the volume
+static void randomRays(VKLVolume vklVolume,
+                       size_t numRays,
+                       std::vector<vkl_vec3f> &origins,
+                       std::vector<vkl_vec3f> &directions)
+{
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distDir(rd(), 0, -0.5f, 0.5f);
+
+  origins.resize(numRays);
+  directions.resize(numRays);
+
+  for (size_t i = 0; i < numRays; i++) {
+    origins[i]    = vkl_vec3f{distX(), distY(), bbox.lower.z - 1.f};
+    directions[i] = vkl_vec3f{distDir(), distDir(), 1.f};
+  }
+}
+
+// iterate all intervals of a value range only present in a small part of a
+// 512^3 volume; the ball radius in percent of the volume is given by
+// state.range(0)
+static void sparseIntervalIteration(benchmark::State &state)
+{
+  VKLVolume vklVolume = newSparseVolume(512, state.range(0));
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(vklVolume);
+  vkl_range1f valueRange{0.5f, 1.5f};
+  vklValueSelectorSetRanges(valueSelector, 1, &valueRange);
+  vklCommit(valueSelector);
+
+  const vkl_range1f tRange{0.f, inf};
+
+  size_t numIntervals = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      VKLIntervalIterator iterator;
+      vklInitIntervalIterator(&iterator,
+                              vklVolume,
+                              &origins[i],
+                              &directions[i],
+                              &tRange,
+                              valueSelector);
+
+      VKLInterval interval;
+      while (vklIterateInterval(&iterator, &interval)) {
+        numIntervals++;
+      }
+    }
+  }
+
+  benchmark::DoNotOptimize(numIntervals);
+
+  vklRelease(valueSelector);
+  vklRelease(vklVolume);
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(sparseIntervalIteration)->Arg(2)->Arg(10)->Arg(25)->Arg(50);
+
+// as sparseIntervalIteration, finding the surface of the ball
+static void sparseHitIteration(benchmark::State &state)
+{
+  VKLVolume vklVolume = newSparseVolume(512, state.range(0));
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(vklVolume);
+  float value                    = 0.5f;
+  vklValueSelectorSetValues(valueSelector, 1, &value);
+  vklCommit(valueSelector);
+
+  const vkl_range1f tRange{0.f, inf};
+
+  size_t numHits = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      VKLHitIterator iterator;
+      vklInitHitIterator(&iterator,
+                         vklVolume,
+                         &origins[i],
+                         &directions[i],
+                         &tRange,
+                         valueSelector);
+
+      VKLHit hit;
+      while (vklIterateHit(&iterator, &hit)) {
+        numHits++;
+      }
+    }
+  }
+
+  benchmark::DoNotOptimize(numHits);
+
+  vklRelease(valueSelector);
+  vklRelease(vklVolume);
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(sparseHitIteration)->Arg(2)->Arg(10)->Arg(25)->Arg(50);
+
+// accelerator memory for a macrocell size: one value range per macrocell,
+// padded out to whole bricks of 16^3 macrocells, plus coarse cells of 8^3
+// macrocells
+static double acceleratorMB(const vec3i &dimensions, int macrocellSize)
+{
+  const vec3i cells  = (dimensions + macrocellSize - 1) / macrocellSize;
+  const vec3i bricks = (cells + 15) / 16;
+
+  const double numCells = double(bricks.long_product()) * 16 * 16 * 16;
+
+  return numCells * (1. + 1. / 512.) * sizeof(vkl_range1f) / (1024. * 1024.);
+}
+
+// interval iteration with a value selector, for the macrocell size given by
+// state.range(0)
+static void macrocellSizeIntervals(benchmark::State &state)
+{
+  const vec3i dimensions(256);
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+  vklSetInt(vklVolume, "macrocellSize", state.range(0));
+  vklCommit(vklVolume);
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(vklVolume);
+  vkl_range1f valueRange{1.f, 2.f};
+  vklValueSelectorSetRanges(valueSelector, 1, &valueRange);
+  vklCommit(valueSelector);
+
+  const vkl_range1f tRange{0.f, inf};
+
+  size_t numIntervals = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      VKLIntervalIterator iterator;
+      vklInitIntervalIterator(&iterator,
+                              vklVolume,
+                              &origins[i],
+                              &directions[i],
+                              &tRange,
+                              valueSelector);
+
+      VKLInterval interval;
+      while (vklIterateInterval(&iterator, &interval)) {
+        numIntervals++;
+      }
+    }
+  }
+
+  vklRelease(valueSelector);
+
+  state.counters["intervalsPerRay"] =
+      double(numIntervals) / (state.iterations() * numRays);
+  state.counters["acceleratorMB"] =
+      acceleratorMB(dimensions, state.range(0));
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(macrocellSizeIntervals)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+// as macrocellSizeIntervals, for hit iteration
+static void macrocellSizeHits(benchmark::State &state)
+{
+  const vec3i dimensions(256);
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+  vklSetInt(vklVolume, "macrocellSize", state.range(0));
+  vklCommit(vklVolume);
+
+  const size_t numRays = 1024;
+
+  std::vector<vkl_vec3f> origins, directions;
+  randomRays(vklVolume, numRays, origins, directions);
+
+  VKLValueSelector valueSelector = vklNewValueSelector(vklVolume);
+  float value                    = 1.f;
+  vklValueSelectorSetValues(valueSelector, 1, &value);
+  vklCommit(valueSelector);
+
+  const vkl_range1f tRange{0.f, inf};
+
+  size_t numHits = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < numRays; i++) {
+      VKLHitIterator iterator;
+      vklInitHitIterator(&iterator,
+                         vklVolume,
+                         &origins[i],
+                         &directions[i],
+                         &tRange,
+                         valueSelector);
+
+      VKLHit hit;
+      while (vklIterateHit(&iterator, &hit)) {
+        numHits++;
+      }
+    }
+  }
+
+  vklRelease(valueSelector);
+
+  state.counters["hits"] = benchmark::Counter(
+      double(numHits), benchmark::Counter::kIsRate);
+  state.counters["acceleratorMB"] =
+      acceleratorMB(dimensions, state.range(0));
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations() * numRays);
+}
+
+BENCHMARK(macrocellSizeHits)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+// commit time, dominated by the accelerator build, for a volume of
+// state.range(0)^3 voxels and state.range(1) threads
+static void commitStructuredRegular(benchmark::State &state)
+{
+  VKLDriver previousDriver = vklGetCurrentDriver();
+
+  VKLDriver driver = vklNewDriver("ispc");
+  vklDriverSetInt(driver, "numThreads", state.range(1));
+  vklCommitDriver(driver);
+  vklSetCurrentDriver(driver);
+
+  const vec3i dimensions(state.range(0));
+
+  auto v = ospcommon::make_unique<WaveletStructuredRegularVolume<float>>(
+      dimensions, vec3f(0.f), vec3f(1.f));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  for (auto _ : state) {
+    vklCommit(vklVolume);
+  }
+
+  v.reset();
+
+  // restores the tasking system of the previous driver
+  vklCommitDriver(previousDriver);
+  vklSetCurrentDriver(previousDriver);
+
+  // enables rates in report output
+  state.SetBytesProcessed(state.iterations() * dimensions.long_product() *
+                          sizeof(float));
+}
+
+BENCHMARK(commitStructuredRegular)
+    ->RangeMultiplier(2)
+    ->Ranges({{128, 512}, {1, 64}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 // based on BENCHMARK_MAIN() macro from benchmark.h
 int main(int argc, char **argv)
 {
@@ -14,6 +14,9 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <random>
 #include "../common/simd.h"
 #include "benchmark/benchmark.h"
@@ -78,6 +81,171 @@ static void scalarRandomSample(benchmark::State &state)
 
 BENCHMARK_ALL_PRIMS(scalarRandomSample);
 
+// point location with BVHs of width range(0) and up to range(1) cells per
+// leaf; reports the node memory of the BVH
+template <VKLUnstructuredCellType primType>
+static void scalarRandomSampleBVH(benchmark::State &state)
+{
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> v(
+      new WaveletUnstructuredProceduralVolume(
+          vec3i(128), vec3f(0.f), vec3f(1.f), primType, false));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vklSetInt(vklVolume, "bvhWidth", state.range(0));
+  vklSetInt(vklVolume, "bvhLeafSize", state.range(1));
+  vklCommit(vklVolume);
+
+  const std::string filename = "vklBenchmarkUnstructuredVolume_bvh.bin";
+  vklVolumeSerializeAccelerator(vklVolume, filename.c_str());
+
+  {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    state.counters["bvhMB"] = file.tellg() / (1024.0 * 1024.0);
+  }
+
+  std::remove(filename.c_str());
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  for (auto _ : state) {
+    vkl_vec3f objectCoordinates{distX(), distY(), distZ()};
+
+    benchmark::DoNotOptimize(
+        vklComputeSample(vklVolume, (const vkl_vec3f *)&objectCoordinates));
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(scalarRandomSampleBVH, VKL_TETRAHEDRON)
+    ->RangeMultiplier(2)
+    ->Ranges({{2, 8}, {1, 8}});
+
+// samples along random rays, as when ray marching: without a hint
+// (range(0) = 0), with a hint (1), and with a hint and precomputed face
+// neighbors (2)
+template <VKLUnstructuredCellType primType>
+static void scalarRayMarchSample(benchmark::State &state)
+{
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> v(
+      new WaveletUnstructuredProceduralVolume(
+          vec3i(128), vec3f(0.f), vec3f(1.f), primType, false));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  vklSetBool(vklVolume, "precomputedNeighbors", state.range(0) == 2);
+  vklCommit(vklVolume);
+
+  vkl_box3f bbox = vklGetBoundingBox(vklVolume);
+
+  std::random_device rd;
+  pcg32_biased_float_distribution distX(rd(), 0, bbox.lower.x, bbox.upper.x);
+  pcg32_biased_float_distribution distY(rd(), 0, bbox.lower.y, bbox.upper.y);
+  pcg32_biased_float_distribution distZ(rd(), 0, bbox.lower.z, bbox.upper.z);
+
+  const vec3f center = 0.5f * ((const vec3f &)bbox.lower +
+                               (const vec3f &)bbox.upper);
+
+  // half a cell per step
+  constexpr float stepSize = 0.5f;
+  constexpr int numSteps   = 256;
+
+  vec3f origin;
+  vec3f direction;
+  uint64_t hint = 0;
+
+  size_t step = numSteps;
+
+  for (auto _ : state) {
+    if (step == numSteps) {
+      origin    = vec3f(distX(), distY(), distZ());
+      direction = normalize(center - origin);
+      hint      = 0;
+      step      = 0;
+    }
+
+    const vec3f objectCoordinates = origin + (stepSize * step++) * direction;
+
+    if (state.range(0) == 0) {
+      benchmark::DoNotOptimize(
+          vklComputeSample(vklVolume, (const vkl_vec3f *)&objectCoordinates));
+    } else {
+      benchmark::DoNotOptimize(vklComputeSampleHint(
+          vklVolume, (const vkl_vec3f *)&objectCoordinates, &hint));
+    }
+  }
+
+  // enables rates in report output
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(scalarRayMarchSample, VKL_TETRAHEDRON)->DenseRange(0, 2);
+BENCHMARK_TEMPLATE(scalarRayMarchSample, VKL_HEXAHEDRON)->DenseRange(0, 2);
+
+// commits new vertex values on a fixed mesh, as for each timestep of a
+// simulation: only the values change (range(0) = 0), so the BVH is refit, or
+// the vertex positions are set as a new data object as well (1), so that
+// everything is rebuilt
+template <VKLUnstructuredCellType primType>
+static void commitVertexValues(benchmark::State &state)
+{
+  const vec3i dimensions(128);
+
+  std::unique_ptr<WaveletUnstructuredProceduralVolume> v(
+      new WaveletUnstructuredProceduralVolume(
+          dimensions, vec3f(0.f), vec3f(1.f), primType, false));
+
+  VKLVolume vklVolume = v->getVKLVolume();
+
+  // the vertex grid of the testing volume
+  std::vector<vec3f> positions;
+  positions.reserve((dimensions + vec3i(1)).long_product());
+
+  for (int z = 0; z <= dimensions.z; z++)
+    for (int y = 0; y <= dimensions.y; y++)
+      for (int x = 0; x <= dimensions.x; x++)
+        positions.emplace_back(x, y, z);
+
+  std::vector<float> values(positions.size());
+
+  int timestep = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    timestep++;
+    for (size_t i = 0; i < values.size(); i++)
+      values[i] = std::sin(0.1f * positions[i].x + 0.2f * timestep);
+    state.ResumeTiming();
+
+    VKLData valuesData = vklNewData(values.size(), VKL_FLOAT, values.data());
+    vklSetData(vklVolume, "vertex.data", valuesData);
+    vklRelease(valuesData);
+
+    if (state.range(0)) {
+      VKLData positionsData =
+          vklNewData(positions.size(), VKL_VEC3F, positions.data());
+      vklSetData(vklVolume, "vertex.position", positionsData);
+      vklRelease(positionsData);
+    }
+
+    vklCommit(vklVolume);
+  }
+}
+
+BENCHMARK_TEMPLATE(commitVertexValues, VKL_TETRAHEDRON)
+    ->DenseRange(0, 1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(commitVertexValues, VKL_HEXAHEDRON)
+    ->DenseRange(0, 1)
+    ->Unit(benchmark::kMillisecond);
+
 template <int W, VKLUnstructuredCellType primType>
 void vectorRandomSample(benchmark::State &state)
 {
@@ -60,8 +60,25 @@ namespace openvkl {
       std::vector<unsigned char> generateVoxels() override;
       std::vector<unsigned char> generateVoxelsDicom();
 
+      std::vector<unsigned char> generateLabels() override;
+
+      // computed on first use by streaming through the file, as raw files are
+      // mapped rather than loaded
+      range1f getComputedValueRange() const override;
+
+     protected:
+      VKLData generateVoxelData() override;
+
      private:
+      bool isDicomDirectory() const;
+
       std::string filename;
+
+      // cached result of getComputedValueRange() for raw files
+      mutable range1f fileValueRange = range1f(ospcommon::math::empty);
+
+      // filled by generateVoxelsDicom() when labelled images are present
+      std::vector<unsigned char> labels;
     };
 
     // Inlined definitions ////////////////////////////////////////////////////
@@ -271,9 +288,13 @@ namespace openvkl {
       auto numValues = this->dimensions.long_product();
 
 
-      int voxel_size = sizeOfVKLDataType(voxelType) + sizeof(uint8_t);
+      int voxel_size = sizeOfVKLDataType(voxelType);
       std::vector<unsigned char> voxels(numValues *voxel_size);
 
+      labels.clear();
+      if (segm.size() != 0)
+        labels.resize(numValues, 0);
+
       // loading voxels
       int imageSize = this->dimensions.x*this->dimensions.y;
 
@@ -340,8 +361,8 @@ namespace openvkl {
 
               if(segm.size() != 0) 
               {
-                uint8_t segmentation = static_cast<uint8_t>((int)image_seg(scanX,scanY,0,0));
-                memcpy(&voxels[sizeOfVKLDataType(voxelType) + voxel_size*(scanY * width + scanX) + (i * k)], &segmentation, sizeof(uint8_t));
+                labels[(scanY * width + scanX) + (i * height * width)] =
+                    static_cast<uint8_t>((int)image_seg(scanX,scanY,0,0));
               }
 
             }
@@ -375,9 +396,14 @@ namespace openvkl {
             for(std::uint32_t scanX(0); scanX != width; ++scanX)
             {
               // For monochrome images
-              float luminance = static_cast<float>(dataHandler.getSignedLong(scanY * width + scanX));
+              // stored as VKL_USHORT, the voxel type initDicomFormat()
+              // declares for both DICOM and JPG slices; values outside
+              // [0, 65535] (e.g. negative Hounsfield units) saturate
+              std::int32_t value = dataHandler.getSignedLong(scanY * width + scanX);
+              uint16_t luminance = static_cast<uint16_t>(
+                  std::min(std::max(value, std::int32_t(0)), std::int32_t(65535)));
           
-              memcpy(&voxels[4*(scanY * width + scanX) + ((imageNumber-1) * k)], &luminance, sizeof(float));
+              memcpy(&voxels[voxel_size*(scanY * width + scanX) + ((imageNumber-1) * k)], &luminance, sizeof(uint16_t));
 
             }
           }
@@ -394,9 +420,85 @@ namespace openvkl {
     
     }
 
+    inline std::vector<unsigned char> RawFileStructuredVolume::generateLabels()
+    {
+      return labels;
+    }
+
+    inline bool RawFileStructuredVolume::isDicomDirectory() const
+    {
+      return std::experimental::filesystem::is_directory(
+          std::experimental::filesystem::status(filename));
+    }
+
+    inline VKLData RawFileStructuredVolume::generateVoxelData()
+    {
+      if (isDicomDirectory()) {
+        return TestingStructuredVolume::generateVoxelData();
+      }
+
+      // map the file instead of reading it into memory: loading is nearly
+      // free, and the page cache is shared with other processes
+      VKLData data = vklNewDataFromFile(
+          filename.c_str(), 0, this->dimensions.long_product(), voxelType);
+
+      if (!data) {
+        throw std::runtime_error("error mapping raw volume file");
+      }
+
+      return data;
+    }
+
+    inline range1f RawFileStructuredVolume::getComputedValueRange() const
+    {
+      if (isDicomDirectory()) {
+        return TestingStructuredVolume::getComputedValueRange();
+      }
+
+      if (!fileValueRange.empty()) {
+        return fileValueRange;
+      }
+
+      const size_t voxelSize = sizeOfVKLDataType(voxelType);
+      size_t numRemaining    = this->dimensions.long_product();
+
+      std::ifstream input(filename, std::ios::binary);
+
+      if (!input) {
+        throw std::runtime_error("error opening raw volume file");
+      }
+
+      const size_t chunkSize = size_t(1) << 24;
+      std::vector<char> chunk(chunkSize * voxelSize);
+
+      range1f valueRange(ospcommon::math::empty);
+
+      while (numRemaining > 0) {
+        const size_t numValues = std::min(chunkSize, numRemaining);
+
+        input.read(chunk.data(), numValues * voxelSize);
+
+        if (!input.good()) {
+          throw std::runtime_error("error reading raw volume file");
+        }
+
+        const range1f chunkRange =
+            computeValueRange(voxelType, chunk.data(), numValues);
+
+        valueRange.extend(chunkRange.lower);
+        valueRange.extend(chunkRange.upper);
+
+        numRemaining -= numValues;
+      }
+
+      fileValueRange = valueRange;
+
+      return valueRange;
+    }
+
     inline std::vector<unsigned char> RawFileStructuredVolume::generateVoxels()
     {
-      if(std::experimental::filesystem::is_directory(std::experimental::filesystem::status(filename)))
+      if (isDicomDirectory())
       {
         return generateVoxelsDicom();
       }
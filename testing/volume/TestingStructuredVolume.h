@@ -39,13 +39,25 @@ namespace openvkl {
       vec3f getGridOrigin() const;
       vec3f getGridSpacing() const;
 
+      // use the bricked internal voxel layout (the "brickSize" volume
+      // parameter); must be called before getVKLVolume()
+      void setBrickSize(int brickSize);
+
       // allow external access to underlying voxel data (e.g. for conversion to
       // other volume formats / types)
       virtual std::vector<unsigned char> generateVoxels() = 0;
 
+      // optional per-voxel labels (VKL_UCHAR), set as the "labels" parameter
+      // when non-empty; called after generateVoxels()
+      virtual std::vector<unsigned char> generateLabels();
+
      protected:
       void generateVKLVolume() override;
 
+      // creates the "data" parameter and sets computedValueRange; by default
+      // a copy of generateVoxels(), subclasses may avoid the copy
+      virtual VKLData generateVoxelData();
+
       range1f computedValueRange = range1f(ospcommon::math::empty);
 
       std::string gridType;
@@ -53,6 +65,7 @@ namespace openvkl {
       vec3f gridOrigin;
       vec3f gridSpacing;
       VKLDataType voxelType;
+      int brickSize{0};
     };
 
     // Inlined definitions ////////////////////////////////////////////////////
@@ -71,6 +84,11 @@ namespace openvkl {
     {
     }    
 
+    inline std::vector<unsigned char> TestingStructuredVolume::generateLabels()
+    {
+      return std::vector<unsigned char>();
+    }
+
     inline range1f TestingStructuredVolume::getComputedValueRange() const
     {
       if (computedValueRange.empty()) {
@@ -96,10 +114,30 @@ namespace openvkl {
       return gridSpacing;
     }
 
-    inline void TestingStructuredVolume::generateVKLVolume()
+    inline void TestingStructuredVolume::setBrickSize(int brickSize)
+    {
+      if (volume) {
+        throw std::runtime_error(
+            "brickSize must be set before the VKL volume is generated");
+      }
+
+      this->brickSize = brickSize;
+    }
+
+    inline VKLData TestingStructuredVolume::generateVoxelData()
     {
       std::vector<unsigned char> voxels = generateVoxels();
 
+      computedValueRange = computeValueRange(
+          voxelType, voxels.data(), dimensions.long_product());
+
+      return vklNewData(dimensions.long_product(), voxelType, voxels.data());
+    }
+
+    inline void TestingStructuredVolume::generateVKLVolume()
+    {
+      VKLData data = generateVoxelData();
+
       volume = vklNewVolume(gridType.c_str());
 
       vklSetVec3i(
@@ -109,15 +147,23 @@ namespace openvkl {
       vklSetVec3f(
           volume, "gridSpacing", gridSpacing.x, gridSpacing.y, gridSpacing.z);
 
-      VKLData data =
-          vklNewData(dimensions.long_product(), voxelType, voxels.data());
       vklSetData(volume, "data", data);
       vklRelease(data);
 
-      vklCommit(volume);
+      if (brickSize) {
+        vklSetInt(volume, "brickSize", brickSize);
+      }
 
-      computedValueRange = computeValueRange(
-          voxelType, voxels.data(), dimensions.long_product());
+      std::vector<unsigned char> labels = generateLabels();
+
+      if (!labels.empty()) {
+        VKLData labelData =
+            vklNewData(dimensions.long_product(), VKL_UCHAR, labels.data());
+        vklSetData(volume, "labels", labelData);
+        vklRelease(labelData);
+      }
+
+      vklCommit(volume);
     }
 
   }  // namespace testing